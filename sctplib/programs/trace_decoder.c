@@ -0,0 +1,189 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *           //=====   //===== ===//=== //===//  //       //   //===//
+ *          //        //         //    //    // //       //   //    //
+ *         //====//  //         //    //===//  //       //   //===<<
+ *              //  //         //    //       //       //   //    //
+ *       ======//  //=====    //    //       //=====  //   //===//
+ *
+ * -------------- An SCTP implementation according to RFC 4960 --------------
+ *
+ * Copyright (C) 2000 by Siemens AG, Munich, Germany.
+ * Copyright (C) 2001-2004 Andreas Jungmaier
+ * Copyright (C) 2004-2026 Thomas Dreibholz
+ *
+ * Acknowledgements:
+ * Realized in co-operation between Siemens AG and the University of
+ * Duisburg-Essen, Institute for Experimental Mathematics, Computer
+ * Networking Technology group.
+ * This work was partially funded by the Bundesministerium fuer Bildung und
+ * Forschung (BMBF) of the Federal Republic of Germany
+ * (Förderkennzeichen 01AK045).
+ * The authors alone are responsible for the contents.
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact: sctp-discussion@sctp.de
+ *          thomas.dreibholz@gmail.com
+ *          tuexen@fh-muenster.de
+ *          andreas.jungmaier@web.de
+ */
+
+/*
+ * trace_decoder prints the records of a binary trace file written by
+ * sctp_writeTraceFile() in human readable form, one record per line.
+ */
+
+#include "sctp.h"
+#include "trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+static const char* eventNames[TRC_MAX_EVENT + 1] = {
+    "UNKNOWN",
+    "PACKET_RECEIVED",
+    "PACKET_SENT",
+    "DATA_SENT",
+    "DATA_RECEIVED",
+    "DATA_DUPLICATE",
+    "SACK_SENT",
+    "SACK_RECEIVED",
+    "FAST_RETRANSMIT",
+    "T3_TIMEOUT",
+    "ULP_SEND",
+    "DATA_DELIVERED",
+    "RTT_MEASURED"
+};
+
+/* names of the two values of a record, per event */
+static const char* valueNames[TRC_MAX_EVENT + 1][2] = {
+    { "value1", "value2" },
+    { "vtag",   "length" },
+    { "path",   "length" },
+    { "tsn",    "length" },
+    { "tsn",    "length" },
+    { "tsn",    "unused" },
+    { "ctsna",  "rwnd"   },
+    { "ctsna",  "rwnd"   },
+    { "tsn",    "chunks" },
+    { "path",   "chunks" },
+    { "stream", "length" },
+    { "stream", "length" },
+    { "path",   "rtt"    }
+};
+
+
+static const char* moduleName(unsigned int module)
+{
+    switch (module) {
+    case SCTP_TRACE_MODULE_DISTRIBUTION:   return "distribution";
+    case SCTP_TRACE_MODULE_BUNDLING:       return "bundling";
+    case SCTP_TRACE_MODULE_RECVCTRL:       return "recvctrl";
+    case SCTP_TRACE_MODULE_RELTRANSFER:    return "reltransfer";
+    case SCTP_TRACE_MODULE_FLOWCONTROL:    return "flowcontrol";
+    case SCTP_TRACE_MODULE_PATHMANAGEMENT: return "pathmanagement";
+    case SCTP_TRACE_MODULE_STREAMENGINE:   return "streamengine";
+    default:                               return "unknown";
+    }
+}
+
+
+void printUsage(void)
+{
+    printf("Usage:    trace_decoder [options] tracefile\n");
+    printf("options:\n");
+    printf("-a id     only print records of association id\n");
+    printf("-r        print times relative to the first record\n");
+}
+
+
+int main(int argc, char **argv)
+{
+    FILE* fd;
+    SCTP_TraceFileHeader header;
+    SCTP_TraceRecord rec;
+    const char* fileName = NULL;
+    unsigned int assocFilter = 0, count;
+    unsigned int event;
+    int relative = 0, first = 1, i;
+    double start = 0.0, now;
+
+    for (i = 1; i < argc; i++) {
+        if (argv[i][0] == '-') {
+            switch (argv[i][1]) {
+                case 'a':
+                    if (i+1 >= argc) {
+                        printUsage();
+                        exit(1);
+                    }
+                    assocFilter = (unsigned int)atoi(argv[++i]);
+                    break;
+                case 'r':
+                    relative = 1;
+                    break;
+                default:
+                    printUsage();
+                    exit(1);
+            }
+        } else {
+            fileName = argv[i];
+        }
+    }
+    if (fileName == NULL) {
+        printUsage();
+        exit(1);
+    }
+
+    if ((fd = fopen(fileName, "rb")) == NULL) {
+        perror("trace_decoder: could not open trace file");
+        exit(1);
+    }
+    if (fread(&header, sizeof(header), 1, fd) != 1 || header.magic != TRC_FILE_MAGIC) {
+        fprintf(stderr, "trace_decoder: %s is not a trace file of this byte order\n", fileName);
+        fclose(fd);
+        exit(1);
+    }
+    if (header.version != TRC_FILE_VERSION || header.recordSize != sizeof(SCTP_TraceRecord)) {
+        fprintf(stderr, "trace_decoder: unsupported trace file version %u (record size %u)\n",
+                header.version, header.recordSize);
+        fclose(fd);
+        exit(1);
+    }
+
+    printf("# %u records, %u older records overwritten\n", header.numberOfRecords, header.lostRecords);
+
+    for (count = 0; count < header.numberOfRecords; count++) {
+        if (fread(&rec, sizeof(rec), 1, fd) != 1) {
+            fprintf(stderr, "trace_decoder: file truncated after %u records\n", count);
+            break;
+        }
+        if (assocFilter != 0 && rec.assocID != assocFilter) continue;
+
+        now = rec.seconds + rec.microseconds / 1000000.0;
+        if (first) {
+            start = now;
+            first = 0;
+        }
+        event = (rec.event <= TRC_MAX_EVENT) ? rec.event : 0;
+        printf("%10u %17.6f assoc %u %-14s %-16s %s=%u %s=%u\n",
+               rec.sequence, relative ? now - start : now, rec.assocID,
+               moduleName(rec.module), eventNames[event],
+               valueNames[event][0], rec.tsn, valueNames[event][1], rec.arg);
+    }
+    fclose(fd);
+    return 0;
+}
@@ -351,7 +351,7 @@ void scu_associate(unsigned short noOfOutStreams,
         event_log(EXTERNAL_EVENT, "event: scu_assocatiate in state CLOSED");
         /* create init chunk and write data to it -- take AssocID as tag !!! */
         initCID = ch_makeInit(mdi_readLocalTag(),
-                              mdi_getDefaultMyRwnd(),
+                              mdi_getInitialMyRwnd(),
                               noOfOutStreams, noOfInStreams, mdi_generateStartTSN());
 
         /* store the number of streams */
@@ -375,6 +375,10 @@ void scu_associate(unsigned short noOfOutStreams,
         if (withPRSCTP) {
             ch_addParameterToInitChunk(initCID, VLPARAM_PRSCTP, 0, NULL);
         }
+        if (mdi_supportsECN()) {
+            ch_addParameterToInitChunk(initCID, VLPARAM_ECN_CAPABLE, 0, NULL);
+        }
+        ch_enterSupportedExtensions(initCID);
 
 #ifdef BAKEOFF
          ch_addParameterToInitChunk(initCID, 0x8123, 17, (unsigned char*)localData);
@@ -741,7 +745,7 @@ int sctlr_init(SCTP_init * init)
         outbound_streams = min(ch_noInStreams(initCID), mdi_readLocalOutStreams());
         /* fire back an InitAck with a Cookie */
         initAckCID = ch_makeInitAck(mdi_generateTag(),
-                                    mdi_getDefaultMyRwnd(),
+                                    mdi_getInitialMyRwnd(),
                                     outbound_streams,
                                     inbound_streams, mdi_generateStartTSN());
 
@@ -890,7 +894,7 @@ int sctlr_init(SCTP_init * init)
             inbound_streams = min(ch_noOutStreams(initCID), mdi_readLocalInStreams());
 
             initAckCID = ch_makeInitAck(mdi_generateTag(),
-                                        rxc_get_local_receiver_window(),
+                                        rxc_get_tuned_receiver_window(),
                                         se_numOfSendStreams(), se_numOfRecvStreams(),
                                         /* TODO : check whether we take NEW TSN or leave an old one */
                                         mdi_generateStartTSN());
@@ -993,6 +997,9 @@ gboolean sctlr_initAck(SCTP_init * initAck)
     gboolean preferredSet      = FALSE;
     gboolean peerSupportsPRSCTP = FALSE;
     gboolean peerSupportsADDIP = FALSE;
+    gboolean peerSupportsECN = FALSE;
+    gboolean peerSupportsNRSACK = FALSE;
+    gboolean peerSupportsIDATA = FALSE;
     gboolean peerSupportsIPV4 = FALSE;
     gboolean peerSupportsIPV6 = FALSE;
     short preferredPath;
@@ -1070,6 +1077,9 @@ gboolean sctlr_initAck(SCTP_init * initAck)
         outbound_streams = min(ch_noInStreams(initAckCID), localData->NumberOfOutStreams);
 
         peerSupportsPRSCTP = ch_getPRSCTPfromInitAck(initAckCID);
+        peerSupportsECN = ch_getECNfromInitAck(initAckCID);
+        peerSupportsNRSACK = ch_getSupportedExtensionFromInitAck(initAckCID, CHUNK_NR_SACK);
+        peerSupportsIDATA = ch_getSupportedExtensionFromInitAck(initAckCID, CHUNK_IDATA);
 
 
         mdi_initAssociation(ch_receiverWindow(initAckCID), /* remotes side initial rwnd */
@@ -1079,7 +1089,10 @@ gboolean sctlr_initAck(SCTP_init * initAck)
                             ch_initiateTag(initAckCID), /* remote init tag */
                             ch_initialTSN(initCID), /* local initial TSN for sending */
                             peerSupportsPRSCTP,
-                            FALSE);
+                            FALSE,
+                            peerSupportsECN,
+                            peerSupportsNRSACK,
+                            peerSupportsIDATA);
 
        event_logii(VERBOSE, "sctlr_InitAck(): called mdi_initAssociation(in-streams=%u, out-streams=%u)",
                     inbound_streams,outbound_streams);
@@ -1251,6 +1264,9 @@ void sctlr_cookie_echo(SCTP_cookie_echo * cookie_echo)
     short primaryDestinationAddress;
     short noOfDestinationAddresses;
     gboolean peerSupportsPRSCTP;
+    gboolean peerSupportsECN;
+    gboolean peerSupportsNRSACK;
+    gboolean peerSupportsIDATA;
 
     unsigned short noSuccess, restart_result;
     unsigned int peerAddressTypes;
@@ -1375,13 +1391,18 @@ void sctlr_cookie_echo(SCTP_cookie_echo * cookie_echo)
         }
 
         peerSupportsPRSCTP = ch_getPRSCTPfromCookie(cookieCID);
+        peerSupportsECN = ch_getECNfromCookie(cookieCID);
+        peerSupportsNRSACK = ch_getSupportedExtensionFromCookie(cookieCID, CHUNK_NR_SACK);
+        peerSupportsIDATA = ch_getSupportedExtensionFromCookie(cookieCID, CHUNK_IDATA);
 
         /* initialize new association from cookie data */
         mdi_initAssociation(ch_receiverWindow(initCID),
                             ch_noInStreams(initAckCID),
                             ch_noOutStreams(initAckCID),
                             ch_initialTSN(initCID), cookie_remote_tag, ch_initialTSN(initAckCID),
-                            peerSupportsPRSCTP, FALSE);
+                            peerSupportsPRSCTP, FALSE, peerSupportsECN,
+                            peerSupportsNRSACK,
+                            peerSupportsIDATA);
 
 
         localData->NumberOfOutStreams = ch_noOutStreams(initAckCID);
@@ -1447,6 +1468,9 @@ void sctlr_cookie_echo(SCTP_cookie_echo * cookie_echo)
                         mdi_writeDestinationAddresses(dAddresses, ndAddresses);
                     }
                     peerSupportsPRSCTP = ch_getPRSCTPfromCookie(cookieCID);
+                    peerSupportsECN = ch_getECNfromCookie(cookieCID);
+                    peerSupportsNRSACK = ch_getSupportedExtensionFromCookie(cookieCID, CHUNK_NR_SACK);
+                    peerSupportsIDATA = ch_getSupportedExtensionFromCookie(cookieCID, CHUNK_IDATA);
 
                     /* initialize new association from cookie data */
                     mdi_initAssociation(ch_receiverWindow(initCID),
@@ -1455,7 +1479,9 @@ void sctlr_cookie_echo(SCTP_cookie_echo * cookie_echo)
                                         ch_initialTSN(initCID),
                                         cookie_remote_tag,
                                         ch_initialTSN(initAckCID),
-                                        peerSupportsPRSCTP, FALSE);
+                                        peerSupportsPRSCTP, FALSE, peerSupportsECN,
+                                        peerSupportsNRSACK,
+                                        peerSupportsIDATA);
 
                     localData->NumberOfOutStreams = ch_noOutStreams(initAckCID);
                     localData->NumberOfInStreams = ch_noInStreams(initAckCID);
@@ -1495,6 +1521,9 @@ void sctlr_cookie_echo(SCTP_cookie_echo * cookie_echo)
                         mdi_writeDestinationAddresses(dAddresses, ndAddresses);
                     }
                     peerSupportsPRSCTP = ch_getPRSCTPfromCookie(cookieCID);
+                    peerSupportsECN = ch_getECNfromCookie(cookieCID);
+                    peerSupportsNRSACK = ch_getSupportedExtensionFromCookie(cookieCID, CHUNK_NR_SACK);
+                    peerSupportsIDATA = ch_getSupportedExtensionFromCookie(cookieCID, CHUNK_IDATA);
 
                     /* initialize new association from cookie data */
                     mdi_initAssociation(ch_receiverWindow(initCID),
@@ -1503,7 +1532,9 @@ void sctlr_cookie_echo(SCTP_cookie_echo * cookie_echo)
                                         ch_initialTSN(initCID),
                                         cookie_remote_tag,
                                         ch_initialTSN(initAckCID),
-                                        peerSupportsPRSCTP, FALSE);
+                                        peerSupportsPRSCTP, FALSE, peerSupportsECN,
+                                        peerSupportsNRSACK,
+                                        peerSupportsIDATA);
 
                     localData->NumberOfOutStreams = ch_noOutStreams(initAckCID);
                     localData->NumberOfInStreams = ch_noInStreams(initAckCID);
@@ -1544,6 +1575,9 @@ void sctlr_cookie_echo(SCTP_cookie_echo * cookie_echo)
                     mySupportedTypes = mdi_getSupportedAddressTypes();
                     ndAddresses = ch_cookieIPDestAddresses(cookieCID, mySupportedTypes, dAddresses, &peerAddressTypes, &destAddress);
                     peerSupportsPRSCTP = ch_getPRSCTPfromCookie(cookieCID);
+                    peerSupportsECN = ch_getECNfromCookie(cookieCID);
+                    peerSupportsNRSACK = ch_getSupportedExtensionFromCookie(cookieCID, CHUNK_NR_SACK);
+                    peerSupportsIDATA = ch_getSupportedExtensionFromCookie(cookieCID, CHUNK_IDATA);
 
                     restart_result = mdi_restartAssociation(ch_noInStreams(initAckCID),
                                                             ch_noOutStreams(initAckCID),
@@ -1551,7 +1585,9 @@ void sctlr_cookie_echo(SCTP_cookie_echo * cookie_echo)
                                                             ch_initialTSN(initCID),
                                                             ch_initialTSN(initAckCID),
                                                             (short)ndAddresses, 0, dAddresses,
-                                                            peerSupportsPRSCTP,FALSE); /* setting 0 as primary */
+                                                            peerSupportsPRSCTP, FALSE, peerSupportsECN,
+                                                            peerSupportsNRSACK,
+                                                            peerSupportsIDATA); /* setting 0 as primary */
                     if (restart_result == 0) {
                         /* what happens to SCTP data chunks is implementation specific */
                         mdi_rewriteTagRemote(cookie_remote_tag);
@@ -51,6 +51,7 @@
 
 #ifndef WIN32
    #include <sys/time.h>
+   #include <time.h>
    #include <netinet/in_systm.h>
    #include <netinet/ip.h>
    #include <netdb.h>
@@ -63,6 +64,10 @@
    #include <net/if.h>
 #ifdef SCTP_OVER_UDP
    #include <netinet/udp.h>
+#else
+   /* ICMP messages quote SCTP packets only when SCTP runs directly over IP */
+   #define USE_ICMP_SOCKETS
+   #include <netinet/ip_icmp.h>
 #endif
 #else
     #include <winsock2.h>
@@ -92,6 +97,9 @@
     #else
         /* include files for IPv6 header structs */
     #endif
+    #ifdef USE_ICMP_SOCKETS
+        #include <netinet/icmp6.h>
+    #endif
 #endif
 
 #if defined (LINUX)
@@ -160,6 +168,7 @@
 #define    EVENTCB_TYPE_UDP        2
 #define    EVENTCB_TYPE_USER       3
 #define    EVENTCB_TYPE_ROUTING    4
+#define    EVENTCB_TYPE_ICMP       5
 
 
 #ifdef SCTP_OVER_UDP
@@ -268,6 +277,89 @@ adl_random(void)
  *      fails.
  */
 
+/* event loop profile, see sctp_getEventLoopProfile() */
+static gboolean profilingEnabled = FALSE;
+static SCTP_EventLoopProfile eventLoopProfile;
+static struct profile_state {
+    unsigned int depth;
+    unsigned long long wallStart;
+    unsigned long long cpuStart;
+} profileState[SCTP_PROFILE_CATEGORIES];
+
+static unsigned long long adl_profileWallClock(void)
+{
+    struct timeval tv;
+#if !defined(WIN32) && defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+        return (unsigned long long)ts.tv_sec * 1000000ULL + (unsigned long long)(ts.tv_nsec / 1000);
+    }
+#endif
+    adl_gettime(&tv);
+    return (unsigned long long)tv.tv_sec * 1000000ULL + (unsigned long long)tv.tv_usec;
+}
+
+static unsigned long long adl_profileCpuClock(void)
+{
+#if !defined(WIN32) && (defined(CLOCK_THREAD_CPUTIME_ID) || defined(CLOCK_PROCESS_CPUTIME_ID))
+    struct timespec ts;
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+#else
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == 0) {
+#endif
+        return (unsigned long long)ts.tv_sec * 1000000ULL + (unsigned long long)(ts.tv_nsec / 1000);
+    }
+#endif
+    return 0;
+}
+
+void adl_profileStart(unsigned int category)
+{
+    if (profilingEnabled == FALSE || category >= SCTP_PROFILE_CATEGORIES) return;
+    if (profileState[category].depth++ > 0) return;
+    profileState[category].wallStart = adl_profileWallClock();
+    profileState[category].cpuStart  = adl_profileCpuClock();
+}
+
+void adl_profileStop(unsigned int category)
+{
+    unsigned long long now;
+    SCTP_ProfileCounter* counter;
+
+    /* profiling may have been switched on while this category was active */
+    if (category >= SCTP_PROFILE_CATEGORIES || profileState[category].depth == 0) return;
+    if (--profileState[category].depth > 0) return;
+
+    counter = &eventLoopProfile.category[category];
+    counter->count++;
+    now = adl_profileWallClock();
+    if (now > profileState[category].wallStart)
+        counter->wallTime += now - profileState[category].wallStart;
+    now = adl_profileCpuClock();
+    if (now > profileState[category].cpuStart)
+        counter->cpuTime += now - profileState[category].cpuStart;
+}
+
+void adl_setEventLoopProfiling(gboolean enable)
+{
+    if (enable == TRUE && profilingEnabled == FALSE) {
+        memset(profileState, 0, sizeof(profileState));
+    }
+    profilingEnabled = enable;
+}
+
+void adl_getEventLoopProfile(SCTP_EventLoopProfile* profile)
+{
+    memcpy(profile, &eventLoopProfile, sizeof(SCTP_EventLoopProfile));
+}
+
+void adl_resetEventLoopProfile(void)
+{
+    memset(&eventLoopProfile, 0, sizeof(eventLoopProfile));
+}
+
 static long revision = 0;
 
 struct extendedpollfd {
@@ -351,7 +443,9 @@ int extendedPoll(struct extendedpollfd* fdlist,
          unlock(data);
       }
 
+      adl_profileStart(SCTP_PROFILE_POLL);
       ret = select(n + 1, &readfdset, &writefdset, &exceptfdset, to);
+      adl_profileStop(SCTP_PROFILE_POLL);
 
       if(lock) {
          lock(data);
@@ -413,8 +507,13 @@ static int sctp_sfd = -1;       /* socket fd for standard SCTP port....      */
 static int sctpv6_sfd = -1;
 #endif
 
-/* will be added back later....
-   static int icmp_sfd = -1;  */      /* socket fd for ICMP messages */
+#ifdef USE_ICMP_SOCKETS
+static int icmp_sfd = -1;       /* socket fd for ICMP messages */
+
+#ifdef HAVE_IPV6
+static int icmpv6_sfd = -1;     /* socket fd for ICMPv6 messages */
+#endif
+#endif
 
 static struct event_cb *event_callbacks[NUM_FDS];
 
@@ -646,6 +745,12 @@ gint adl_open_sctp_socket(int af, int* myRwnd)
                 error_log(ERROR_FATAL, "setsockopt: IPV6_PKTINFO failed");
                 abort();
             }
+#endif
+#ifdef IPV6_RECVTCLASS
+            /* and the traffic class, for the ECN codepoint */
+            if (setsockopt(sfd, IPPROTO_IPV6, IPV6_RECVTCLASS, &ch, sizeof(ch)) < 0) {
+                error_log(ERROR_MINOR, "setsockopt: IPV6_RECVTCLASS failed");
+            }
 #endif
             break;
 #endif
@@ -674,6 +779,185 @@ gint adl_get_sctpv6_socket(void)
 #endif
 
 
+#ifdef USE_ICMP_SOCKETS
+/**
+ * opens a raw socket that receives the ICMP (AF_INET) or ICMPv6 (AF_INET6) messages
+ * of this host. Only the error messages that may quote SCTP packets are of interest,
+ * on ICMPv6 sockets the kernel filters out all others.
+ * @param  af  address family
+ * @return socket file descriptor, or -1 on error
+ */
+static gint adl_open_icmp_socket(int af)
+{
+    int sfd;
+#ifdef HAVE_IPV6
+    struct icmp6_filter filter;
+#endif
+
+    if (af == AF_INET) {
+        sfd = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+#ifdef HAVE_IPV6
+    } else if (af == AF_INET6) {
+        sfd = socket(AF_INET6, SOCK_RAW, IPPROTO_ICMPV6);
+        if (sfd >= 0) {
+            ICMP6_FILTER_SETBLOCKALL(&filter);
+            ICMP6_FILTER_SETPASS(ICMP6_DST_UNREACH, &filter);
+            ICMP6_FILTER_SETPASS(ICMP6_PACKET_TOO_BIG, &filter);
+            if (setsockopt(sfd, IPPROTO_ICMPV6, ICMP6_FILTER, &filter, sizeof(filter)) < 0)
+                error_log(ERROR_MINOR, "setsockopt: ICMP6_FILTER failed !");
+        }
+#endif
+    } else {
+        error_log(ERROR_MINOR, "Unknown address family.");
+        return -1;
+    }
+    if (sfd < 0) {
+        error_logi(ERROR_MINOR, "Could not open ICMP socket for address family %d", af);
+        return -1;
+    }
+    event_logi(INTERNAL_EVENT_0, "Created ICMP raw socket %d", sfd);
+    return sfd;
+}
+
+
+/**
+ * parses an ICMP message received on icmp_sfd (starting with the IPv4 header), and
+ * passes destination unreachable and fragmentation needed messages that quote an
+ * SCTP packet to the message distribution.
+ */
+static void adl_icmp_message(unsigned char *buffer, int length)
+{
+    struct ip *iph, *quoted;
+    struct icmp *icmph;
+    SCTP_common_header *sctph;
+    union sockunion peer;
+    int hlen, qlen, icmpEvent;
+    unsigned int mtu = 0;
+
+    iph = (struct ip *) buffer;
+    hlen = iph->ip_hl << 2;
+    if (length < hlen + ICMP_MINLEN + (int)sizeof(struct ip)) return;
+
+    icmph = (struct icmp *) &buffer[hlen];
+    if (icmph->icmp_type != ICMP_UNREACH) return;
+
+    quoted = &icmph->icmp_ip;
+    qlen = quoted->ip_hl << 2;
+    if (quoted->ip_p != IPPROTO_SCTP) return;
+    /* RFC 792 quotes at least 8 bytes : the ports and the verification tag */
+    if (length < hlen + ICMP_MINLEN + qlen + 8) return;
+    sctph = (SCTP_common_header *) ((unsigned char *) quoted + qlen);
+
+    switch (icmph->icmp_code) {
+    case ICMP_UNREACH_NEEDFRAG:
+        mtu = ntohs(icmph->icmp_nextmtu);
+        /* old routers do not report the next hop MTU, PLPMTUD will find it */
+        if (mtu == 0) return;
+        icmpEvent = MDI_ICMP_PACKET_TOO_BIG;
+        break;
+    case ICMP_UNREACH_NET:
+    case ICMP_UNREACH_HOST:
+    case ICMP_UNREACH_PROTOCOL:
+    case ICMP_UNREACH_PORT:
+    case ICMP_UNREACH_NET_UNKNOWN:
+    case ICMP_UNREACH_HOST_UNKNOWN:
+        icmpEvent = MDI_ICMP_UNREACHABLE;
+        break;
+    default:
+        return;
+    }
+
+    memset((void *) &peer, 0, sizeof(peer));
+    peer.sin.sin_family = AF_INET;
+#ifdef HAVE_SIN_LEN
+    peer.sin.sin_len = sizeof(struct sockaddr_in);
+#endif
+    peer.sin.sin_addr = quoted->ip_dst;
+
+    event_logii(VERBOSE, "ICMP type %u code %u for an SCTP packet",
+                icmph->icmp_type, icmph->icmp_code);
+    mdi_icmpReceived(&peer, ntohs(sctph->src_port), ntohs(sctph->dest_port),
+                     ntohl(sctph->verification_tag), icmpEvent, mtu);
+}
+
+
+#ifdef HAVE_IPV6
+/**
+ * parses an ICMPv6 message received on icmpv6_sfd (starting with the ICMPv6 header),
+ * and passes destination unreachable and packet too big messages that quote an
+ * SCTP packet to the message distribution. Quoted packets with extension headers
+ * are not followed.
+ */
+static void adl_icmpv6_message(unsigned char *buffer, int length)
+{
+    struct icmp6_hdr *icmp6h;
+    struct ip6_hdr *quoted;
+    SCTP_common_header *sctph;
+    union sockunion peer;
+    int icmpEvent;
+    unsigned int mtu = 0;
+
+    if (length < (int)(sizeof(struct icmp6_hdr) + sizeof(struct ip6_hdr)) + 8) return;
+
+    icmp6h = (struct icmp6_hdr *) buffer;
+    quoted = (struct ip6_hdr *) &buffer[sizeof(struct icmp6_hdr)];
+    if (quoted->ip6_nxt != IPPROTO_SCTP) return;
+    sctph = (SCTP_common_header *) &buffer[sizeof(struct icmp6_hdr) + sizeof(struct ip6_hdr)];
+
+    switch (icmp6h->icmp6_type) {
+    case ICMP6_PACKET_TOO_BIG:
+        mtu = ntohl(icmp6h->icmp6_mtu);
+        icmpEvent = MDI_ICMP_PACKET_TOO_BIG;
+        break;
+    case ICMP6_DST_UNREACH:
+        switch (icmp6h->icmp6_code) {
+        case ICMP6_DST_UNREACH_NOROUTE:
+        case ICMP6_DST_UNREACH_BEYONDSCOPE:
+        case ICMP6_DST_UNREACH_ADDR:
+        case ICMP6_DST_UNREACH_NOPORT:
+            icmpEvent = MDI_ICMP_UNREACHABLE;
+            break;
+        default:
+            return;
+        }
+        break;
+    default:
+        return;
+    }
+
+    memset((void *) &peer, 0, sizeof(peer));
+    peer.sin6.sin6_family = AF_INET6;
+#ifdef HAVE_SIN6_LEN
+    peer.sin6.sin6_len = sizeof(struct sockaddr_in6);
+#endif
+    memcpy(&peer.sin6.sin6_addr, &quoted->ip6_dst, sizeof(struct in6_addr));
+
+    event_logii(VERBOSE, "ICMPv6 type %u code %u for an SCTP packet",
+                icmp6h->icmp6_type, icmp6h->icmp6_code);
+    mdi_icmpReceived(&peer, ntohs(sctph->src_port), ntohs(sctph->dest_port),
+                     ntohl(sctph->verification_tag), icmpEvent, mtu);
+}
+#endif
+
+
+/**
+ * callback function for the ICMP sockets
+ */
+static void adl_icmp_cb(gint sfd, unsigned char *buffer, int length,
+                        unsigned char *hoststring, unsigned short port)
+{
+    if (buffer == NULL || length <= 0) return;
+#ifdef HAVE_IPV6
+    if (sfd == icmpv6_sfd) {
+        adl_icmpv6_message(buffer, length);
+        return;
+    }
+#endif
+    adl_icmp_message(buffer, length);
+}
+#endif /* USE_ICMP_SOCKETS */
+
+
 /**
  * This function creates a UDP socket bound to localhost, for asynchronous
  * interprocess communication with an Upper Layer process.
@@ -805,7 +1089,10 @@ int adl_send_message(int sfd, void *buf, int len, union sockunion *dest, unsigne
 #endif
 
 #ifdef HAVE_IPV6
-    guchar hostname[MAX_MTU_SIZE];
+    guchar hostname[INET6_ADDRSTRLEN];
+#ifdef IPV6_TCLASS
+    int tclass, old_tclass;
+#endif
 #endif
 
     switch (sockunion_family(dest)) {
@@ -850,11 +1137,17 @@ int adl_send_message(int sfd, void *buf, int len, union sockunion *dest, unsigne
 #ifdef HAVE_IPV6
     case AF_INET6:
         number_of_sendevents++;
-        inet_ntop(AF_INET6, sock2ip6(dest), (char *)hostname, MAX_MTU_SIZE);
+        inet_ntop(AF_INET6, sock2ip6(dest), (char *)hostname, INET6_ADDRSTRLEN);
 
         event_logiiii(VVERBOSE,
                      "AF_INET6: adl_send_message : sfd : %d, len %d, destination : %s, send_events: %u",
                         sfd, len, hostname, number_of_sendevents);
+#ifdef IPV6_TCLASS
+        opt_len = sizeof(old_tclass);
+        tmp = getsockopt(sfd, IPPROTO_IPV6, IPV6_TCLASS, &old_tclass, &opt_len);
+        tclass = tos;
+        tmp = setsockopt(sfd, IPPROTO_IPV6, IPV6_TCLASS, &tclass, sizeof(tclass));
+#endif
 
 #ifdef SCTP_OVER_UDP
         if(len + sizeof(udp_header) > sizeof(outBuffer)) {
@@ -875,6 +1168,9 @@ int adl_send_message(int sfd, void *buf, int len, union sockunion *dest, unsigne
         }
 #else
         txmt_len = sendto(sfd, buf, len, 0, (struct sockaddr *)&(dest->sin6), sizeof(struct sockaddr_in6));
+#endif
+#ifdef IPV6_TCLASS
+        tmp = setsockopt(sfd, IPPROTO_IPV6, IPV6_TCLASS, &old_tclass, sizeof(old_tclass));
 #endif
         break;
 #endif
@@ -1042,7 +1338,8 @@ if (sfd!=0)
  * @param  to       destination address of that message
  * @return returns number of bytes received with this call
  */
-int adl_receive_message(int sfd, void *dest, int maxlen, union sockunion *from, union sockunion *to)
+int adl_receive_message(int sfd, void *dest, int maxlen, union sockunion *from, union sockunion *to,
+                        unsigned char *tos)
 {
     int len;
 #ifdef SCTP_OVER_UDP
@@ -1066,19 +1363,21 @@ int adl_receive_message(int sfd, void *dest, int maxlen, union sockunion *from,
 #endif
 
 #ifdef HAVE_IPV6
-    unsigned char m6buf[(CMSG_SPACE(sizeof (struct in6_pktinfo)))];
-    struct in6_pktinfo *pkt6info;
+    unsigned char m6buf[CMSG_SPACE(sizeof (struct in6_pktinfo)) + CMSG_SPACE(sizeof (int))];
 #endif
 
     len = -1;
-    if ((dest == NULL) || (from == NULL) || (to == NULL)) return -1;
+    if ((dest == NULL) || (from == NULL) || (to == NULL) || (tos == NULL)) return -1;
+    *tos = 0;
 
     if (sfd == sctp_sfd) {
         len = recv (sfd, dest, maxlen, 0);
 #ifdef LINUX
         iph = (struct iphdr *)dest;
+        *tos = iph->tos;
 #else
         iph = (struct ip *)dest;
+        *tos = iph->ip_tos;
 #endif
         to->sa.sa_family = AF_INET;
         to->sin.sin_port = htons(0);
@@ -1136,14 +1435,6 @@ int adl_receive_message(int sfd, void *dest, int maxlen, union sockunion *from,
     data_vec.iov_base = dest;
     data_vec.iov_len  = maxlen;
     if (sfd == sctpv6_sfd) {
-        rcmsgp = (struct cmsghdr *)m6buf;
-        pkt6info = (struct in6_pktinfo *)(CMSG_DATA(rcmsgp));
-
-        /* receive control msg */
-        rcmsgp->cmsg_level = IPPROTO_IPV6;
-        rcmsgp->cmsg_type = IPV6_PKTINFO;
-        rcmsgp->cmsg_len = CMSG_LEN (sizeof (struct in6_pktinfo));
-
         rmsghdr.msg_flags = 0;
         rmsghdr.msg_iov = &data_vec;
         rmsghdr.msg_iovlen = 1;
@@ -1163,7 +1454,20 @@ int adl_receive_message(int sfd, void *dest, int maxlen, union sockunion *from,
         to->sa.sa_family = AF_INET6;
         to->sin6.sin6_port = htons(0);
         to->sin6.sin6_flowinfo = htonl(0);
-        memcpy(&(to->sin6.sin6_addr), &(pkt6info->ipi6_addr), sizeof(struct in6_addr));
+        /* destination address, and the traffic class (for the ECN codepoint) */
+        if (len >= 0) {
+            for (rcmsgp = CMSG_FIRSTHDR(&rmsghdr); rcmsgp != NULL; rcmsgp = CMSG_NXTHDR(&rmsghdr, rcmsgp)) {
+                if (rcmsgp->cmsg_level != IPPROTO_IPV6) continue;
+                if (rcmsgp->cmsg_type == IPV6_PKTINFO) {
+                    memcpy(&(to->sin6.sin6_addr),
+                           &(((struct in6_pktinfo *)CMSG_DATA(rcmsgp))->ipi6_addr), sizeof(struct in6_addr));
+#ifdef IPV6_TCLASS
+                } else if (rcmsgp->cmsg_type == IPV6_TCLASS) {
+                    *tos = (unsigned char)(*(int *)CMSG_DATA(rcmsgp));
+#endif
+                }
+            }
+        }
 
 #ifdef SCTP_OVER_UDP
 #ifdef LINUX
@@ -1245,6 +1549,7 @@ void dispatch_event(int num_of_events)
     struct sockaddr_in *src_in;
     guchar src_address[SCTP_MAX_IP_LEN];
     unsigned short portnum=0;
+    unsigned char tos = 0;
 
 #if !defined (LINUX)
     struct ip *iph;
@@ -1263,7 +1568,9 @@ void dispatch_event(int num_of_events)
             /* We must have specified this callback funtion for treating/logging the error */
             if (event_callbacks[i]->eventcb_type == EVENTCB_TYPE_USER) {
                 event_logi(VERBOSE, "Poll Error Condition on user fd %d", poll_fds[i].fd);
+                adl_profileStart(SCTP_PROFILE_USER_CALLBACKS);
                 ((sctp_userCallback)*(event_callbacks[i]->action)) (poll_fds[i].fd, poll_fds[i].revents, &poll_fds[i].events, event_callbacks[i]->userData);
+                adl_profileStop(SCTP_PROFILE_USER_CALLBACKS);
             } else {
                 error_logi(ERROR_MINOR, "Poll Error Condition on fd %d", poll_fds[i].fd);
                 ((sctp_socketCallback)*(event_callbacks[i]->action)) (poll_fds[i].fd, NULL, 0, NULL, 0);
@@ -1273,9 +1580,12 @@ void dispatch_event(int num_of_events)
         if ((poll_fds[i].revents & POLLPRI) || (poll_fds[i].revents & POLLIN) || (poll_fds[i].revents & POLLOUT)) {
             if (event_callbacks[i]->eventcb_type == EVENTCB_TYPE_USER) {
                     event_logi(VERBOSE, "Activity on user fd %d - Activating USER callback", poll_fds[i].fd);
+                    adl_profileStart(SCTP_PROFILE_USER_CALLBACKS);
                     ((sctp_userCallback)*(event_callbacks[i]->action)) (poll_fds[i].fd, poll_fds[i].revents, &poll_fds[i].events, event_callbacks[i]->userData);
+                    adl_profileStop(SCTP_PROFILE_USER_CALLBACKS);
 
             } else if (event_callbacks[i]->eventcb_type == EVENTCB_TYPE_UDP) {
+                adl_profileStart(SCTP_PROFILE_UDP_CALLBACKS);
                 src_len = sizeof(src);
                 length = adl_get_message(poll_fds[i].fd, rbuf, MAX_MTU_SIZE, &src, &src_len);
                 event_logi(VERBOSE, "Message %d bytes - Activating UDP callback", length);
@@ -1295,11 +1605,16 @@ void dispatch_event(int num_of_events)
                         break;
                 }
                 ((sctp_socketCallback)*(event_callbacks[i]->action)) (poll_fds[i].fd, rbuf, length, src_address, portnum);
+                adl_profileStop(SCTP_PROFILE_UDP_CALLBACKS);
 
             } else if (event_callbacks[i]->eventcb_type == EVENTCB_TYPE_SCTP) {
-                length = adl_receive_message(poll_fds[i].fd, rbuf, MAX_MTU_SIZE, &src, &dest);
+                adl_profileStart(SCTP_PROFILE_SCTP_PACKETS);
+                length = adl_receive_message(poll_fds[i].fd, rbuf, MAX_MTU_SIZE, &src, &dest, &tos);
 
-                if(length < 0) break;
+                if(length < 0) {
+                    adl_profileStop(SCTP_PROFILE_SCTP_PACKETS);
+                    break;
+                }
 
                 event_logiiii(VERBOSE, "SCTP-Message on socket %u , len=%d, portnum=%d, sockunion family %u",
                      poll_fds[i].fd, length, portnum, sockunion_family(&src));
@@ -1325,7 +1640,7 @@ void dispatch_event(int num_of_events)
                                     length, inet_ntoa(src_in->sin_addr));
                     } else {
                         length -= hlen;
-                        mdi_receiveMessage(poll_fds[i].fd, &rbuf[hlen], length, &src, &dest);
+                        mdi_receiveMessage(poll_fds[i].fd, &rbuf[hlen], length, &src, &dest, tos);
                     }
                     break;
 #ifdef HAVE_IPV6
@@ -1335,7 +1650,7 @@ void dispatch_event(int num_of_events)
                     event_logii(VERBOSE, "IPv6/SCTP-Message from %s (%d bytes) -> activating callback",
                                    src_address, length);
 
-                    mdi_receiveMessage(poll_fds[i].fd, &rbuf[hlen], length, &src, &dest);
+                    mdi_receiveMessage(poll_fds[i].fd, &rbuf[hlen], length, &src, &dest, tos);
                     break;
 
 #endif                          /* HAVE_IPV6 */
@@ -1344,10 +1659,22 @@ void dispatch_event(int num_of_events)
                     break;
 
                 }
+                adl_profileStop(SCTP_PROFILE_SCTP_PACKETS);
+
+            } else if (event_callbacks[i]->eventcb_type == EVENTCB_TYPE_ICMP) {
+                length = recv(poll_fds[i].fd, rbuf, MAX_MTU_SIZE, 0);
+                if (length < 0) {
+                    error_logi(ERROR_MINOR, "recv() failed on ICMP socket %d", poll_fds[i].fd);
+                } else {
+                    ((sctp_socketCallback)*(event_callbacks[i]->action)) (poll_fds[i].fd, rbuf, length, NULL, 0);
+                }
             }
         }
         poll_fds[i].revents = 0;
     }                       /*   for(i = 0; i < num_of_fds; i++) */
+    /* data that arrived in this pass is reported once per association */
+    mdi_deliverDataArrivals();
+    mdi_deliverMemoryPressure();
     LEAVE_EVENT_DISPATCHER;
 }
 
@@ -1359,6 +1686,7 @@ void dispatch_event(int num_of_events)
 void dispatch_timer(void)
 {
     int tid, result;
+    unsigned int category;
     AlarmTimer* event;
 
     ENTER_TIMER_DISPATCHER;
@@ -1373,13 +1701,21 @@ void dispatch_timer(void)
 
         tid = event->timer_id;
         current_tid = tid;
+        /* the SCTP_PROFILE_TIMER_xxx categories are numbered like the TIMER_TYPE_xxx values */
+        if (event->timer_type >= TIMER_TYPE_INIT && event->timer_type <= TIMER_TYPE_USER)
+            category = (unsigned int)event->timer_type;
+        else
+            category = SCTP_PROFILE_TIMER_USER;
 
+        adl_profileStart(category);
         (*(event->action)) (tid, event->arg1, event->arg2);
+        adl_profileStop(category);
         current_tid = 0;
 
         result = remove_timer(event);
         if (result) /* this can happen for a timeout that occurs on a deleted assoc ? */
             error_logi(ERROR_MAJOR, "remove_item returned %d", result);
+        mdi_deliverMemoryPressure();
     }
     LEAVE_TIMER_DISPATCHER;
     return;
@@ -1532,6 +1868,7 @@ int adl_eventLoop()
    struct ip *iph;
    struct sockaddr_in *src_in;
    unsigned short portnum;
+   unsigned char tos;
 
 
    msecs = get_msecs_to_nexttimer();
@@ -1576,7 +1913,7 @@ int adl_eventLoop()
                for (j=0; j<NUM_FDS; j++)
                   if (event_callbacks[i]->sfd==fds[i])
                   {
-                  length = adl_receive_message(fds[i], rbuf, MAX_MTU_SIZE, &src, &dest);
+                  length = adl_receive_message(fds[i], rbuf, MAX_MTU_SIZE, &src, &dest, &tos);
                   portnum = ntohs(src.sin.sin_port);
                   if(length < 0) break;
                   event_logiiii(VERBOSE, "SCTP-Message on socket %u , len=%d, portnum=%d, sockunion family %u",
@@ -1595,13 +1932,16 @@ int adl_eventLoop()
                     } else
                {
                         length -= hlen;
-                        mdi_receiveMessage(fds[i], &rbuf[hlen], length, &src, &dest);
+                        mdi_receiveMessage(fds[i], &rbuf[hlen], length, &src, &dest, tos);
                     }
                     break;
                   }
 
             }
          }
+         /* data that arrived in this pass is reported once per association */
+         mdi_deliverDataArrivals();
+         mdi_deliverMemoryPressure();
       }
       return 1;
 #else
@@ -1795,11 +2135,7 @@ int adl_init_adaptation_layer(int * myRwnd)
     }
 #endif
 
-    /* we should - in a later revision - add back the a function that opens
-       appropriate ICMP sockets (IPv4 and/or IPv6) and registers these with
-       callback functions that also set PATH MTU correctly */
 #ifdef HAVE_IPV6
-    /* icmpv6_sfd = int adl_open_icmpv6_socket(); */
     sctpv6_sfd = adl_open_sctp_socket(AF_INET6, &myRwnd6);
     if (sctpv6_sfd < 0) {
         error_log(ERROR_MAJOR, "Could not open IPv6 socket - running IPv4 only !");
@@ -1815,14 +2151,24 @@ int adl_init_adaptation_layer(int * myRwnd)
 #endif
     }
 
-    /* adl_register_socket_cb(icmpv6_sfd, adl_icmpv6_cb); */
-
     /* set a safe default */
     if (myRwnd6 == -1) *myRwnd = 8192;
 #endif
 
-    /* icmp_sfd = int adl_open_icmp_socket(); */
-    /* adl_register_socket_cb(icmp_sfd, adl_icmp_cb); */
+#ifdef USE_ICMP_SOCKETS
+    /* ICMP messages mark paths unreachable, and lower the path MTU. Without
+       them the library still works, only slower to notice these events */
+    icmp_sfd = adl_open_icmp_socket(AF_INET);
+    if (icmp_sfd >= 0)
+        adl_register_fd_cb(icmp_sfd, EVENTCB_TYPE_ICMP, POLLIN | POLLPRI, (void(*)(void *,void *))adl_icmp_cb, NULL);
+#ifdef HAVE_IPV6
+    if (sctpv6_sfd >= 0) {
+        icmpv6_sfd = adl_open_icmp_socket(AF_INET6);
+        if (icmpv6_sfd >= 0)
+            adl_register_fd_cb(icmpv6_sfd, EVENTCB_TYPE_ICMP, POLLIN | POLLPRI, (void(*)(void *,void *))adl_icmp_cb, NULL);
+    }
+#endif
+#endif
 
 /* #if defined(HAVE_SETUID) && defined(HAVE_GETUID) */
      /* now we could drop privileges, if we did not use setsockopt() calls for IP_TOS etc. later */
@@ -59,6 +59,20 @@
 
 unsigned int adl_random(void);
 
+/**
+ * start and stop accounting of time for one of the SCTP_PROFILE_xxx categories.
+ * Calls may nest, only the outermost pair of a category is accounted.
+ */
+void adl_profileStart(unsigned int category);
+
+void adl_profileStop(unsigned int category);
+
+void adl_setEventLoopProfiling(gboolean enable);
+
+void adl_getEventLoopProfile(SCTP_EventLoopProfile* profile);
+
+void adl_resetEventLoopProfile(void);
+
 boolean adl_equal_address(union sockunion *one, union sockunion *two);
 
 
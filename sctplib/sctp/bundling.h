@@ -148,6 +148,18 @@ gint bu_put_SACK_Chunk(SCTP_sack_chunk * chunk, unsigned int* dest_index);
  */
 gint bu_sendAllChunks(guint * ad_idx);
 
+/*
+ * bu_flushDataChunks: sends the data chunks in the buffer to their destination,
+ * before chunks for another destination are put in. Works also while the sender is locked.
+ */
+gint bu_flushDataChunks(guint * ad_idx);
+
+/*
+ * bu_sendProbe: sends a heartbeat padded with a PAD chunk to probe_size bytes
+ * (the size of the IP packet) as a path MTU probe.
+ */
+gint bu_sendProbe(SCTP_simple_chunk * chunk, guint probe_size, guint * ad_idx);
+
 void bu_request_sack(void);
 
 #endif
@@ -161,13 +161,15 @@ static gint32 retrieveVLParamFromString(guint16 paramType, guchar * mstring, gui
                      pType == ECC_STALE_COOKIE_ERROR ||
                      pType == VLPARAM_SUPPORTED_ADDR_TYPES ||
                      pType == VLPARAM_PRSCTP||
+                     pType == VLPARAM_ECN_CAPABLE||
+                     pType == VLPARAM_SUPPORTED_EXTENSIONS||
                      pType == VLPARAM_SET_PRIMARY||
                      pType == VLPARAM_ADAPTATION_LAYER_IND) {
             curs += ntohs(param_header->param_length);
             /* take care of padding */
             while ((curs % 4) != 0)
                 curs++;
-        } else if (pType == VLPARAM_ECN_CAPABLE || pType == VLPARAM_HOST_NAME_ADDR) {
+        } else if (pType == VLPARAM_HOST_NAME_ADDR) {
             event_logi(INTERNAL_EVENT_1, "parameter type %d not supported", pType);
             curs += ntohs(param_header->param_length);
             /* take care of padding here */
@@ -432,6 +434,22 @@ static void enterChunk(SCTP_simple_chunk * chunk, const char *log_text)
     chunkCompleted[freeChunkID] = FALSE;
 }
 
+/*
+ * returns TRUE, if length bytes may be written at position pos of a chunk built here.
+ * These chunks are sized for the default PDU, while parameters copied from a received
+ * chunk may be longer.
+ */
+static gboolean roomInChunk(ChunkID chunkID, guchar * pos, unsigned int length)
+{
+    unsigned int offset = (unsigned int)(pos - chunks[chunkID]->simple_chunk_data);
+
+    if (offset + length > MAX_SIMPLE_CHUNKDATA_LENGTH) {
+        error_logii(ERROR_MINOR, "Chunk %u has no room for %u more bytes", chunkID, length);
+        return FALSE;
+    }
+    return TRUE;
+}
+
 /******************************* external functions ***********************************************/
 
 /*****  create, write into and read from init and initAck ******************************************/
@@ -676,9 +694,203 @@ int ch_enterIPaddresses(ChunkID chunkID, union sockunion sock_addresses[], int n
     return 0;
 }
 
+/**
+ * scans a list of variable length parameters for one of type paramType
+ * @return pointer to the parameter, or NULL if it is not in the list
+ */
+static SCTP_vlparam_header *ch_vlparamsFind(unsigned char *vlparams, guint16 length, guint16 paramType)
+{
+    SCTP_vlparam_header *vl_Ptr;
+    guint16 curs = 0;
+    guint16 pLen;
+
+    while (curs + sizeof(SCTP_vlparam_header) <= length) {
+        vl_Ptr = (SCTP_vlparam_header *) & vlparams[curs];
+        pLen = ntohs(vl_Ptr->param_length);
+        if (pLen < 4 || curs + pLen > length) return NULL; /* peer error - ignore */
+        if (ntohs(vl_Ptr->param_type) == paramType) return vl_Ptr;
+        curs += pLen;
+        while ((curs % 4) != 0) curs++;
+    }
+    return NULL;
+}
+
+/**
+ * scans a list of variable length parameters for one of type paramType
+ * @return TRUE, if the parameter is in the list
+ */
+static gboolean ch_vlparamsContain(unsigned char *vlparams, guint16 length, guint16 paramType)
+{
+    return (ch_vlparamsFind(vlparams, length, paramType) != NULL);
+}
+
+/**
+ * checks, whether a supported extensions parameter (RFC 5061, section 4.2.7) lists a chunk type
+ * @return TRUE, if the chunk type is in the list
+ */
+static gboolean ch_extensionsContain(SCTP_vlparam_header *ext, unsigned char chunkType)
+{
+    unsigned char *types;
+    guint16 count, pLen;
+
+    if (ext == NULL) return FALSE;
+    pLen = ntohs(ext->param_length);
+    types = (unsigned char *) &ext[1];
+    for (count = 0; count + sizeof(SCTP_vlparam_header) < pLen; count++) {
+        if (types[count] == chunkType) return TRUE;
+    }
+    return FALSE;
+}
+
+/**
+ * ch_enterSupportedExtensions enters the supported extensions parameter with the
+ * chunk types of all locally enabled extensions into an init or initAck
+ * @return number of chunk types in the parameter, 0 if none was entered
+ */
+int ch_enterSupportedExtensions(ChunkID initCID)
+{
+    unsigned char types[4];
+    unsigned short count = 0;
+
+    if (mdi_supportsNRSACK()) types[count++] = CHUNK_NR_SACK;
+    if (mdi_offersIDATA()) types[count++] = CHUNK_IDATA;
+
+    if (count > 0) {
+        ch_addParameterToInitChunk(initCID, VLPARAM_SUPPORTED_EXTENSIONS, count, types);
+    }
+    return count;
+}
+
+/**
+ * ch_enterSupportedExtensionsFromInit copies the supported extensions parameter of an
+ * init into the cookie of the initAck that is being built
+ * @return 1 if the init contained the parameter, else 0
+ */
+int ch_enterSupportedExtensionsFromInit(ChunkID initAckCID, ChunkID initCID)
+{
+    SCTP_vlparam_header *ext;
+    guint16 pLen;
+
+    ext = ch_vlparamsFind(&((SCTP_init *)chunks[initCID])->variableParams[0],
+                          (guint16)(((SCTP_init *)chunks[initCID])->chunk_header.chunk_length -
+                                    sizeof(SCTP_chunk_header) - sizeof(SCTP_init_fixed)),
+                          VLPARAM_SUPPORTED_EXTENSIONS);
+    if (ext == NULL) return 0;
+
+    pLen = ntohs(ext->param_length);
+    if (!roomInChunk(initAckCID,
+                     &((SCTP_init *) chunks[initAckCID])->variableParams[writeCursor[initAckCID]], pLen))
+        return 0;
+    memcpy(&((SCTP_init *) chunks[initAckCID])->variableParams[writeCursor[initAckCID]], ext, pLen);
+    writeCursor[initAckCID] += pLen;
+    while ((writeCursor[initAckCID] % 4) != 0) {
+        ((SCTP_init *) chunks[initAckCID])->variableParams[writeCursor[initAckCID]] = 0;
+        writeCursor[initAckCID]++;
+    }
+    return 1;
+}
+
+/**
+ * @return TRUE, if the init or initAck lists chunkType in its supported extensions parameter
+ */
+gboolean ch_getSupportedExtensionFromInitAck(ChunkID initAckCID, unsigned char chunkType)
+{
+    if (chunks[initAckCID] == NULL) {
+        error_log(ERROR_FATAL, "Invalid init or initAck chunk ID");
+        return FALSE;
+    }
+    return ch_extensionsContain(
+               ch_vlparamsFind(&((SCTP_init *)chunks[initAckCID])->variableParams[0],
+                               (guint16)(((SCTP_init *)chunks[initAckCID])->chunk_header.chunk_length -
+                                         sizeof(SCTP_chunk_header) - sizeof(SCTP_init_fixed)),
+                               VLPARAM_SUPPORTED_EXTENSIONS),
+               chunkType);
+}
+
+/**
+ * @return TRUE, if the peer listed chunkType in the supported extensions parameter of
+ *         its init, when the cookie was made
+ */
+gboolean ch_getSupportedExtensionFromCookie(ChunkID cookieCID, unsigned char chunkType)
+{
+    if (chunks[cookieCID] == NULL) {
+        error_log(ERROR_FATAL, "Invalid Cookie chunk ID");
+        return FALSE;
+    }
+    return ch_extensionsContain(
+               ch_vlparamsFind(&((SCTP_cookie_echo *)chunks[cookieCID])->vlparams[0],
+                               (guint16)(((SCTP_cookie_echo *) chunks[cookieCID])->chunk_header.chunk_length -
+                                         COOKIE_FIXED_LENGTH - sizeof(SCTP_chunk_header)),
+                               VLPARAM_SUPPORTED_EXTENSIONS),
+               chunkType);
+}
+
+/**
+ * ch_enterECNchunk enters the ECN capable parameter into an initAck, if the peer
+ * sent it in its init, and ECN is enabled locally
+ * @return 1 if ECN will be used in the association, 0 if not
+ */
 int ch_enterECNchunk(ChunkID initAckID, ChunkID initCID)
 {
-    return 0;
+    if (chunks[initCID] == NULL || chunks[initAckID] == NULL) {
+        error_log(ERROR_FATAL, "Invalid init or initAck chunk ID");
+        return 0;
+    }
+    if (!mdi_supportsECN() || !ch_getECNfromInitAck(initCID)) return 0;
+
+    event_log(VERBOSE, "ch_enterECNchunk: both sides are ECN capable");
+    ch_addParameterToInitChunk(initAckID, VLPARAM_ECN_CAPABLE, 0, NULL);
+    return 1;
+}
+
+/**
+ * ch_enterECNfromInit copies the ECN capable parameter of an init into the cookie
+ * of the initAck that is being built, so the cookie echo tells, whether the peer
+ * is ECN capable
+ * @return 1 if the init contained the parameter, else 0
+ */
+int ch_enterECNfromInit(ChunkID initAckCID, ChunkID initCID)
+{
+    SCTP_vlparam_header *ecn;
+
+    if (!ch_getECNfromInitAck(initCID)) return 0;
+
+    ecn = (SCTP_vlparam_header *) &((SCTP_init *) chunks[initAckCID])->variableParams[writeCursor[initAckCID]];
+    if (!roomInChunk(initAckCID, (guchar *) ecn, sizeof(SCTP_vlparam_header))) return 0;
+    ecn->param_type = htons(VLPARAM_ECN_CAPABLE);
+    ecn->param_length = htons(sizeof(SCTP_vlparam_header));
+    writeCursor[initAckCID] += sizeof(SCTP_vlparam_header);
+    return 1;
+}
+
+/**
+ * @return TRUE, if the cookie echo carries the ECN capable parameter of the peer
+ */
+gboolean ch_getECNfromCookie(ChunkID cookieCID)
+{
+    if (chunks[cookieCID] == NULL) {
+        error_log(ERROR_FATAL, "Invalid Cookie chunk ID");
+        return FALSE;
+    }
+    return ch_vlparamsContain(&((SCTP_cookie_echo *)chunks[cookieCID])->vlparams[0],
+                              (guint16)(((SCTP_cookie_echo *) chunks[cookieCID])->chunk_header.chunk_length -
+                                        COOKIE_FIXED_LENGTH - sizeof(SCTP_chunk_header)),
+                              VLPARAM_ECN_CAPABLE);
+}
+
+/**
+ * @return TRUE, if the init or initAck carries the ECN capable parameter
+ */
+gboolean ch_getECNfromInitAck(ChunkID initAckCID)
+{
+    if (chunks[initAckCID] == NULL) {
+        error_log(ERROR_FATAL, "Invalid init or initAck chunk ID");
+        return FALSE;
+    }
+    return ch_vlparamsContain(&((SCTP_init *)chunks[initAckCID])->variableParams[0],
+                              (guint16)(((SCTP_init *)chunks[initAckCID])->chunk_header.chunk_length -
+                                        sizeof(SCTP_chunk_header) - sizeof(SCTP_init_fixed)),
+                              VLPARAM_ECN_CAPABLE);
 }
 
 gboolean ch_getPRSCTPfromCookie(ChunkID cookieCID)
@@ -808,8 +1020,10 @@ int ch_enterPRSCTPfromInit(ChunkID initAckCID, ChunkID initCID)
 
             if (pLen == 4) result = 0; /* peer supports it, but doesn't send anything unreliably  */
             if (pLen > 4)  result = 1; /* peer supports it, and does send some */
-            memcpy(ack_string, vl_initPtr, pLen);
-            writeCursor[initAckCID] += pLen;
+            if (roomInChunk(initAckCID, ack_string, pLen)) {
+                memcpy(ack_string, vl_initPtr, pLen);
+                writeCursor[initAckCID] += pLen;
+            }
         }
         curs += pLen;
         while ((curs % 4) != 0) curs++;
@@ -931,6 +1145,10 @@ ch_enterCookieVLP(ChunkID initCID, ChunkID initAckID,
 
         /* add peers PRSCTP field to COOKIE parameter */
         result = ch_enterPRSCTPfromInit(initAckID, initCID);
+        /* and whether the peer is ECN capable */
+        ch_enterECNfromInit(initAckID, initCID);
+        /* and the extensions the peer supports */
+        ch_enterSupportedExtensionsFromInit(initAckID, initCID);
 
         /* check if endpoint is ADD-IP capable, store result, and put HIS chunk in cookie */
         if (ch_enterADDIP(initAckID, initCID) > 0) {
@@ -954,6 +1172,7 @@ ch_enterCookieVLP(ChunkID initCID, ChunkID initAckID,
                             (unsigned short)(ntohs(cookie->vlparam_header.param_length) - 4), cookie->ck.hmac);
 
         ch_enterECNchunk(initAckID, initCID);
+        ch_enterSupportedExtensions(initAckID);
         event_logi(VERBOSE, "ch_enterCookieVLP: PRSCTP support: %d", result);
 
         /* if both support PRSCTP, enter our PRSCTP parameter to INIT ACK chunk */
@@ -1029,7 +1248,9 @@ int ch_enterUnrecognizedParameters(ChunkID initCID, ChunkID AckCID, unsigned int
             pType == VLPARAM_SUPPORTED_ADDR_TYPES ||
             pType == VLPARAM_IPV4_ADDRESS ||
             pType == VLPARAM_IPV6_ADDRESS ||
-            pType == VLPARAM_PRSCTP) {
+            pType == VLPARAM_PRSCTP ||
+            pType == VLPARAM_ECN_CAPABLE ||
+            pType == VLPARAM_SUPPORTED_EXTENSIONS) {
 
             curs += pLen;
             /* take care of padding */
@@ -1245,6 +1466,18 @@ int ch_enterUnrecognizedErrors(ChunkID initAckID,
             /* take care of padding */
             while ((curs % 4) != 0) curs++;
             continue;
+        } else if (pType == VLPARAM_ECN_CAPABLE) {
+            event_log(EXTERNAL_EVENT, "found ECN capable parameter - skipping it !");
+            curs += pLen;
+            /* take care of padding */
+            while ((curs % 4) != 0) curs++;
+            continue;
+        } else if (pType == VLPARAM_SUPPORTED_EXTENSIONS) {
+            event_log(EXTERNAL_EVENT, "found supported extensions parameter - skipping it !");
+            curs += pLen;
+            /* take care of padding */
+            while ((curs % 4) != 0) curs++;
+            continue;
         } else if (pType == VLPARAM_ADDIP) {
             event_log(EXTERNAL_EVENT, "found ADDIP parameter - skipping it !");
             *peerSupportsADDIP = TRUE;
@@ -1905,7 +2138,7 @@ boolean ch_goodCookie(ChunkID chunkID)
 /**
  * ch_makeHeartbeat creates a heartbeatchunk.
  */
-ChunkID ch_makeHeartbeat(unsigned int sendingTime, unsigned int pathID)
+ChunkID ch_makeHeartbeat(unsigned int sendingTime, unsigned int pathID, unsigned int probeSize)
 {
 
     SCTP_heartbeat *heartbeatChunk;
@@ -1927,6 +2160,7 @@ ChunkID ch_makeHeartbeat(unsigned int sendingTime, unsigned int pathID)
     heartbeatChunk->HB_Info.param_length = htons(sizeof(SCTP_heartbeat) - 4);
     heartbeatChunk->pathID = htonl((unsigned int) pathID);
     heartbeatChunk->sendingTime = htonl(sendingTime);
+    heartbeatChunk->probeSize = htonl(probeSize);
 
     key =  key_operation(KEY_READ);
     if (key == NULL) abort();
@@ -2030,6 +2264,26 @@ unsigned int ch_HBsendingTime(ChunkID chunkID)
 
 
 
+/* ch_HBprobeSize reads the size of the PLPMTUD probe, that carried the heartbeat.
+*/
+unsigned int ch_HBprobeSize(ChunkID chunkID)
+{
+    if (chunks[chunkID] == NULL) {
+        error_log(ERROR_MAJOR, "Invalid chunk ID");
+        return 0;
+    }
+
+    if (chunks[chunkID]->chunk_header.chunk_id == CHUNK_HBREQ ||
+        chunks[chunkID]->chunk_header.chunk_id == CHUNK_HBACK) {
+        return ntohl(((SCTP_heartbeat *) chunks[chunkID])->probeSize);
+    } else {
+        error_log(ERROR_MINOR, "ch_HBprobeSize: chunk type not heartbeat or heartbeatAck");
+        return 0;
+    }
+}
+
+
+
 /* ch_HBpathID reads the path heartbeat on which the heartbeat was sent.
 */
 unsigned int ch_HBpathID(ChunkID chunkID)
@@ -2112,6 +2366,7 @@ ch_addUnrecognizedParameter(unsigned char* pos, ChunkID cid,
     if (pos == NULL) {
         error_log(ERROR_MAJOR, "Invalid chunk ID");
     }
+    if (!roomInChunk(cid, pos, length + 2*sizeof(unsigned short))) return;
     ec = (SCTP_error_cause*) pos;
     ec->cause_code = htons(VLPARAM_UNRECOGNIZED_PARAM);
     ec->cause_length = htons((unsigned short)(length+2*sizeof(unsigned short)));
@@ -2172,6 +2427,8 @@ ch_enterErrorCauseData(ChunkID chunkID, unsigned short code,
         return;
     }
     index = writeCursor[chunkID];
+    if (!roomInChunk(chunkID, &(chunks[chunkID]->simple_chunk_data[index]),
+                     length + 2*sizeof(unsigned short))) return;
     ec = (SCTP_error_cause*) &(chunks[chunkID]->simple_chunk_data[index]);
     ec->cause_code = htons(code);
     ec->cause_length = htons((unsigned short)(length+2*sizeof(unsigned short)));
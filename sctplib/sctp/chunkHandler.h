@@ -224,9 +224,9 @@ boolean ch_goodCookie(ChunkID chunkID);
 
 /****** create and read from heartbeat chunk ******************************************************/
 
-/* ch_makeHeartbeat creates a heartbeatchunk.
+/* ch_makeHeartbeat creates a heartbeatchunk, probeSize is 0 unless it is sent as PLPMTUD probe.
 */
-ChunkID ch_makeHeartbeat(unsigned int sendingTime, unsigned int pathID);
+ChunkID ch_makeHeartbeat(unsigned int sendingTime, unsigned int pathID, unsigned int probeSize);
 
 /**
  * ch_verifyHeartbeat checks the signature of the received heartbeat.
@@ -247,6 +247,12 @@ unsigned int ch_HBpathID(ChunkID chunkID);
 
 
 
+/* ch_HBprobeSize reads the size of the PLPMTUD probe, that carried the heartbeat.
+*/
+unsigned int ch_HBprobeSize(ChunkID chunkID);
+
+
+
 /***** create simple chunk **********************************************************************/
 
 /* ch_makeSimpleChunk creates a simple chunk. It can be used for parameterless chunks like
@@ -265,6 +271,24 @@ gboolean ch_getPRSCTPfromInitAck(ChunkID initAckCID);
    returns > 0 if peer has unreliable streams set */
 gboolean ch_getPRSCTPfromCookie(ChunkID cookieCID);
 
+/* returns TRUE, if the init or initAck carries the ECN capable parameter */
+gboolean ch_getECNfromInitAck(ChunkID initAckCID);
+/* returns TRUE, if the peer was ECN capable, when the cookie was made */
+gboolean ch_getECNfromCookie(ChunkID cookieCID);
+/* enters the ECN capable parameter into the initAck, if both sides are ECN capable */
+int ch_enterECNchunk(ChunkID initAckID, ChunkID initCID);
+/* copies the ECN capable parameter of the init into the cookie */
+int ch_enterECNfromInit(ChunkID initAckCID, ChunkID initCID);
+
+/* enters the supported extensions parameter (RFC 5061) with the locally enabled extensions */
+int ch_enterSupportedExtensions(ChunkID initCID);
+/* copies the supported extensions parameter of the init into the cookie */
+int ch_enterSupportedExtensionsFromInit(ChunkID initAckCID, ChunkID initCID);
+/* returns TRUE, if the init or initAck lists chunkType as a supported extension */
+gboolean ch_getSupportedExtensionFromInitAck(ChunkID initAckCID, unsigned char chunkType);
+/* returns TRUE, if the peer listed chunkType as a supported extension, when the cookie was made */
+gboolean ch_getSupportedExtensionFromCookie(ChunkID cookieCID, unsigned char chunkType);
+
 /***** write to and read from error chunk *******************************************************/
 
 ChunkID ch_makeErrorChunk(void);
@@ -0,0 +1,353 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *           //=====   //===== ===//=== //===//  //       //   //===//
+ *          //        //         //    //    // //       //   //    //
+ *         //====//  //         //    //===//  //       //   //===<<
+ *              //  //         //    //       //       //   //    //
+ *       ======//  //=====    //    //       //=====  //   //===//
+ *
+ * -------------- An SCTP implementation according to RFC 4960 --------------
+ *
+ * Copyright (C) 2000 by Siemens AG, Munich, Germany.
+ * Copyright (C) 2001-2004 Andreas Jungmaier
+ * Copyright (C) 2004-2026 Thomas Dreibholz
+ *
+ * Acknowledgements:
+ * Realized in co-operation between Siemens AG and the University of
+ * Duisburg-Essen, Institute for Experimental Mathematics, Computer
+ * Networking Technology group.
+ * This work was partially funded by the Bundesministerium fuer Bildung und
+ * Forschung (BMBF) of the Federal Republic of Germany
+ * (Förderkennzeichen 01AK045).
+ * The authors alone are responsible for the contents.
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact: sctp-discussion@sctp.de
+ *          thomas.dreibholz@gmail.com
+ *          tuexen@fh-muenster.de
+ *          andreas.jungmaier@web.de
+ */
+
+#include "congestion.h"
+#include "adaptation.h"
+#include "sctp.h"
+
+#include <stdio.h>
+#include <glib.h>
+
+/* #define Current_event_log_ 6 */
+
+/* CUBIC constants, see RFC 8312 */
+#define CUBIC_C                 0.4
+#define CUBIC_BETA              0.7
+
+/* thresholds of the delay-based module, in MTUs queued at the bottleneck */
+#define DELAY_ALPHA             2
+#define DELAY_BETA              4
+#define DELAY_GAMMA             1
+
+
+/* ---------------------------- Reno, RFC 4960 section 7.2 ------------------------------------- */
+
+static void cc_reno_init(cparm* path)
+{
+    return;
+}
+
+static void cc_reno_ack(cparm* path, unsigned int num_acked, gboolean new_data_acked,
+                        gboolean all_data_acked, unsigned int flightsize, unsigned int srtt)
+{
+    int diff;
+    struct timeval last_update, now;
+
+    /* see section 6.2.1, section 6.2.2 */
+    if (path->cwnd <= path->ssthresh) { /* SLOW START */
+       if (new_data_acked == TRUE) {
+           path->cwnd += min(CC_PACKET_SIZE(path), num_acked);
+           adl_gettime(&(path->time_of_cwnd_adjustment));
+       }
+
+    } else {                    /* CONGESTION AVOIDANCE, as per section 6.2.2 */
+        if (new_data_acked == TRUE) {
+            path->partial_bytes_acked += num_acked;
+            event_logi(VVERBOSE, "CONG. AVOIDANCE : new data acked: increase PBA to %u",
+                path->partial_bytes_acked);
+        }
+        /*
+         * Section 7.2.2 :
+         * "When partial_bytes_acked is equal to or greater than cwnd and
+         * before the arrival of the SACK the sender had cwnd or more bytes
+         * of data outstanding (i.e., before arrival of the SACK, flightsize
+         * was greater than or equal to cwnd), increase cwnd by MTU, and
+         * reset partial_bytes_acked to (partial_bytes_acked - cwnd)."
+         */
+        last_update = path->time_of_cwnd_adjustment;
+        adl_add_msecs_totime(&last_update, srtt);
+        adl_gettime(&now);
+        diff = adl_timediff_to_msecs(&now, &last_update); /* a-b */
+        event_logii(VVERBOSE, "CONG. AVOIDANCE : rtt_time=%u diff=%d", srtt, diff);
+
+        if (diff >= 0) {
+            if ((path->partial_bytes_acked >= path->cwnd) && (flightsize >= path->cwnd)) {
+                path->cwnd += CC_PACKET_SIZE(path);
+                path->partial_bytes_acked -= path->cwnd;
+                /* update time of window adjustment (i.e. now) */
+                event_log(VVERBOSE,
+                          "CONG. AVOIDANCE : updating time of adjustment !!!!!!!!!! NOW ! ");
+                adl_gettime(&(path->time_of_cwnd_adjustment));
+            }
+            event_logii(VERBOSE, "CONG. AVOIDANCE : updated counters: %u bytes outstanding, cwnd=%u",
+                        flightsize, path->cwnd);
+        }
+
+        event_logi(VVERBOSE, "CONG. AVOIDANCE : partial_bytes_acked=%u ", path->partial_bytes_acked);
+
+        /* see section 7.2.2 */
+        if (all_data_acked == TRUE) path->partial_bytes_acked = 0;
+    }
+}
+
+static void cc_reno_loss(cparm* path)
+{
+    /* see sections 7.2.3 and 7.2.4 */
+    path->ssthresh = max(path->cwnd / 2, 2 * path->mtu);
+    path->cwnd = path->ssthresh;
+    /* as per implementor's guide */
+    path->partial_bytes_acked = 0;
+}
+
+static void cc_reno_rto(cparm* path)
+{
+    /* adjust ssthresh, cwnd - section 6.3.3.E1, respectively 7.2.3) */
+    /* basically we halve the ssthresh, and set cwnd = mtu */
+    path->ssthresh = max(path->cwnd / 2, 2 * path->mtu);
+    path->cwnd = path->mtu;
+    /* as per implementor's guide */
+    path->partial_bytes_acked = 0;
+}
+
+static void cc_reno_idle(cparm* path)
+{
+    /* section 6.2.1 : path has been idle for at least one RTO */
+    path->cwnd = 2 * CC_PACKET_SIZE(path);
+}
+
+
+/* ---------------------------- CUBIC, RFC 8312 ------------------------------------------------ */
+
+/**
+ * cube root by Newton iteration, for not having to link the math library
+ */
+static double cc_cbrt(double x)
+{
+    double y;
+    int i;
+
+    if (x <= 0.0) return 0.0;
+    y = (x > 1.0) ? x / 3.0 : 1.0;
+    for (i = 0; i < 100; i++) {
+        double next = y - (y * y * y - x) / (3.0 * y * y);
+        if (next == y) break;
+        y = next;
+    }
+    return y;
+}
+
+static void cc_cubic_init(cparm* path)
+{
+    memset(&(path->cc.cubic), 0, sizeof(cubic_state));
+}
+
+static void cc_cubic_ack(cparm* path, unsigned int num_acked, gboolean new_data_acked,
+                         gboolean all_data_acked, unsigned int flightsize, unsigned int srtt)
+{
+    cubic_state* cs = &(path->cc.cubic);
+    struct timeval now, elapsed;
+    double t, offset, target;
+    guint64 increase;
+
+    if (new_data_acked == FALSE) return;
+
+    if (path->cwnd <= path->ssthresh) {
+        path->cwnd += min(CC_PACKET_SIZE(path), num_acked);
+        adl_gettime(&(path->time_of_cwnd_adjustment));
+        return;
+    }
+
+    adl_gettime(&now);
+    if (!timerisset(&(cs->epoch_start))) {
+        cs->epoch_start = now;
+        cs->acked_bytes = 0;
+        cs->w_est = (double)path->cwnd;
+        if (path->cwnd < cs->w_max) {
+            cs->k = cc_cbrt((double)(cs->w_max - path->cwnd) / (double)path->mtu / CUBIC_C);
+            cs->origin_point = cs->w_max;
+        } else {
+            cs->k = 0.0;
+            cs->origin_point = path->cwnd;
+        }
+    }
+    timersub(&now, &(cs->epoch_start), &elapsed);
+    t = (double)elapsed.tv_sec + (double)elapsed.tv_usec / 1000000.0 + (double)srtt / 1000.0;
+
+    /* W_cubic(t + RTT), in bytes */
+    offset = t - cs->k;
+    target = (double)cs->origin_point + CUBIC_C * offset * offset * offset * (double)path->mtu;
+    if (target < 0.0) target = 0.0;
+    /* do not grow by more than half the window per RTT */
+    if (target > 1.5 * (double)path->cwnd) target = 1.5 * (double)path->cwnd;
+
+    /* TCP friendly region : grow at least as fast as Reno would */
+    cs->w_est += 3.0 * (1.0 - CUBIC_BETA) / (1.0 + CUBIC_BETA) * (double)num_acked * (double)path->mtu / (double)path->cwnd;
+    if (cs->w_est > target) target = cs->w_est;
+
+    if (target <= (double)path->cwnd) return;
+
+    cs->acked_bytes += num_acked;
+    increase = (guint64)((target - (double)path->cwnd) * (double)cs->acked_bytes / (double)path->cwnd);
+    if (increase > 0) {
+        path->cwnd += (unsigned int)increase;
+        cs->acked_bytes = 0;
+        adl_gettime(&(path->time_of_cwnd_adjustment));
+        event_logii(VERBOSE, "CUBIC : cwnd=%u, w_max=%u", path->cwnd, cs->w_max);
+    }
+}
+
+/**
+ * remembers the window at the time of the reduction and returns the new ssthresh
+ */
+static unsigned int cc_cubic_reduce(cparm* path)
+{
+    cubic_state* cs = &(path->cc.cubic);
+
+    /* fast convergence : release bandwidth if the window keeps shrinking */
+    if (path->cwnd < cs->w_last_max) {
+        cs->w_last_max = path->cwnd;
+        cs->w_max = (unsigned int)((double)path->cwnd * (1.0 + CUBIC_BETA) / 2.0);
+    } else {
+        cs->w_last_max = path->cwnd;
+        cs->w_max = path->cwnd;
+    }
+    timerclear(&(cs->epoch_start));
+    path->partial_bytes_acked = 0;
+    return max((unsigned int)((double)path->cwnd * CUBIC_BETA), 2 * path->mtu);
+}
+
+static void cc_cubic_loss(cparm* path)
+{
+    path->ssthresh = cc_cubic_reduce(path);
+    path->cwnd = path->ssthresh;
+}
+
+static void cc_cubic_rto(cparm* path)
+{
+    path->ssthresh = cc_cubic_reduce(path);
+    path->cwnd = path->mtu;
+}
+
+static void cc_cubic_idle(cparm* path)
+{
+    /* start a new epoch, the time without data must not count as growth time */
+    timerclear(&(path->cc.cubic.epoch_start));
+    path->cwnd = 2 * CC_PACKET_SIZE(path);
+}
+
+
+/* ---------------------------- delay-based (Vegas style) -------------------------------------- */
+
+static void cc_delay_init(cparm* path)
+{
+    memset(&(path->cc.delay), 0, sizeof(delay_state));
+}
+
+static void cc_delay_ack(cparm* path, unsigned int num_acked, gboolean new_data_acked,
+                         gboolean all_data_acked, unsigned int flightsize, unsigned int srtt)
+{
+    delay_state* ds = &(path->cc.delay);
+    struct timeval now, round_end;
+    unsigned int queued;
+
+    if (new_data_acked == FALSE) return;
+
+    if (srtt > 0 && (ds->base_rtt == 0 || srtt < ds->base_rtt)) ds->base_rtt = srtt;
+
+    /* bytes this path keeps queued in the network beyond its base RTT */
+    queued = 0;
+    if (srtt > ds->base_rtt && srtt > 0) {
+        queued = (unsigned int)(((guint64)path->cwnd * (srtt - ds->base_rtt)) / srtt);
+    }
+
+    if (path->cwnd <= path->ssthresh) {
+        if (queued > DELAY_GAMMA * path->mtu) {
+            /* the queue starts building up : leave slow start */
+            path->ssthresh = path->cwnd - 1;
+            return;
+        }
+        path->cwnd += min(CC_PACKET_SIZE(path), num_acked);
+        adl_gettime(&(path->time_of_cwnd_adjustment));
+        return;
+    }
+
+    /* congestion avoidance : adjust once per round */
+    adl_gettime(&now);
+    if (!timerisset(&(ds->round_start))) {
+        ds->round_start = now;
+        return;
+    }
+    round_end = ds->round_start;
+    adl_add_msecs_totime(&round_end, srtt);
+    if (timercmp(&now, &round_end, <)) return;
+
+    if (queued < DELAY_ALPHA * path->mtu) {
+        path->cwnd += CC_PACKET_SIZE(path);
+    } else if (queued > DELAY_BETA * path->mtu) {
+        path->cwnd = max(path->cwnd - path->mtu, 2 * path->mtu);
+    }
+    ds->round_start = now;
+    path->time_of_cwnd_adjustment = now;
+    event_logiii(VERBOSE, "DELAY : cwnd=%u, base_rtt=%u, queued=%u", path->cwnd, ds->base_rtt, queued);
+}
+
+static void cc_delay_send(cparm* path, unsigned int bytes)
+{
+    if (!timerisset(&(path->cc.delay.round_start))) adl_gettime(&(path->cc.delay.round_start));
+}
+
+static void cc_delay_idle(cparm* path)
+{
+    /* the route may have changed while the path was idle, measure the base RTT again */
+    path->cc.delay.base_rtt = 0;
+    timerclear(&(path->cc.delay.round_start));
+    path->cwnd = 2 * CC_PACKET_SIZE(path);
+}
+
+
+static const cc_ops congestionControlModules[] = {
+    { SCTP_CC_RENO,  "reno",  cc_reno_init,  cc_reno_ack,  cc_reno_loss,  cc_reno_rto,  NULL,          cc_reno_idle  },
+    { SCTP_CC_CUBIC, "cubic", cc_cubic_init, cc_cubic_ack, cc_cubic_loss, cc_cubic_rto, NULL,          cc_cubic_idle },
+    { SCTP_CC_DELAY, "delay", cc_delay_init, cc_delay_ack, cc_reno_loss,  cc_reno_rto,  cc_delay_send, cc_delay_idle }
+};
+
+
+const cc_ops* cc_getModule(unsigned int algorithm)
+{
+    unsigned int i;
+
+    for (i = 0; i < sizeof(congestionControlModules) / sizeof(congestionControlModules[0]); i++) {
+        if (congestionControlModules[i].algorithm == algorithm) return &congestionControlModules[i];
+    }
+    return NULL;
+}
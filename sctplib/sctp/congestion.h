@@ -0,0 +1,162 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *           //=====   //===== ===//=== //===//  //       //   //===//
+ *          //        //         //    //    // //       //   //    //
+ *         //====//  //         //    //===//  //       //   //===<<
+ *              //  //         //    //       //       //   //    //
+ *       ======//  //=====    //    //       //=====  //   //===//
+ *
+ * -------------- An SCTP implementation according to RFC 4960 --------------
+ *
+ * Copyright (C) 2000 by Siemens AG, Munich, Germany.
+ * Copyright (C) 2001-2004 Andreas Jungmaier
+ * Copyright (C) 2004-2026 Thomas Dreibholz
+ *
+ * Acknowledgements:
+ * Realized in co-operation between Siemens AG and the University of
+ * Duisburg-Essen, Institute for Experimental Mathematics, Computer
+ * Networking Technology group.
+ * This work was partially funded by the Bundesministerium fuer Bildung und
+ * Forschung (BMBF) of the Federal Republic of Germany
+ * (Förderkennzeichen 01AK045).
+ * The authors alone are responsible for the contents.
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact: sctp-discussion@sctp.de
+ *          thomas.dreibholz@gmail.com
+ *          tuexen@fh-muenster.de
+ *          andreas.jungmaier@web.de
+ */
+
+#ifndef CONGESTION_H
+#define CONGESTION_H
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "globals.h"
+
+
+/**
+ * state of the CUBIC module for one path
+ */
+typedef struct __cubic_state
+{
+    /** cwnd just before the last window reduction */
+    unsigned int w_max;
+    /** w_max of the reduction before, used for fast convergence */
+    unsigned int w_last_max;
+    /** cwnd the cubic function grows back to */
+    unsigned int origin_point;
+    /** time (in seconds) the cubic function needs to reach origin_point */
+    double k;
+    /** estimated window of a Reno sender, in bytes */
+    double w_est;
+    /** acked bytes that did not yet result in a window increase */
+    unsigned int acked_bytes;
+    /** start of the current congestion avoidance epoch, cleared if none is running */
+    struct timeval epoch_start;
+} cubic_state;
+
+/**
+ * state of the delay-based module for one path
+ */
+typedef struct __delay_state
+{
+    /** smallest smoothed RTT seen on this path in msecs, 0 if none yet */
+    unsigned int base_rtt;
+    /** start of the current round (one RTT), cleared if none is running */
+    struct timeval round_start;
+} delay_state;
+
+/**
+ * this struct contains all relevant congestion control parameters for
+ * one PATH to the destination/association peer endpoint
+ */
+typedef struct __congestion_parameters
+{
+    /*@{ */
+    /** */
+    unsigned int cwnd;
+    /** */
+    unsigned int cwnd2;
+    /** */
+    unsigned int partial_bytes_acked;
+    /** */
+    unsigned int ssthresh;
+    /** largest SCTP packet (without IP and common header) that may be sent on this path */
+    unsigned int mtu;
+    /** */
+    struct timeval time_of_cwnd_adjustment;
+    /** */
+    struct timeval last_send_time;
+    /** pacing rate in bytes per second, 0 if the path is not paced */
+    unsigned int pacing_rate;
+    /** earliest time the next packet may be sent, if the path is paced */
+    struct timeval next_send_time;
+    /** private state of the congestion control module */
+    union {
+        cubic_state cubic;
+        delay_state delay;
+    } cc;
+    /*@} */
+} cparm;
+
+/* size of a full packet on a path including the IP and common header, i.e. its MTU */
+#define CC_PACKET_SIZE(path)    ((path)->mtu + IP_HEADERLENGTH + sizeof(SCTP_common_header))
+
+
+/**
+ * A congestion control module is a table of functions, that flowcontrol calls
+ * on the respective events of a path. The functions only change the parameters
+ * of the path they are given. Flowcontrol keeps track of the outstanding bytes,
+ * the time of the last transmission and of fast recovery.
+ */
+typedef struct __congestion_control_ops
+{
+    /** SCTP_CC_xxx value of this module */
+    unsigned int algorithm;
+    /** name for debug output */
+    const char* name;
+    /** resets the private state of a path, cwnd and ssthresh were already set */
+    void (*on_init) (cparm* path);
+    /**
+     * called when a SACK arrived for the path
+     * @param num_acked       number of bytes that have been newly acked on this path
+     * @param flightsize      number of bytes still outstanding after the SACK
+     * @param srtt            smoothed RTT of the path in msecs
+     */
+    void (*on_ack) (cparm* path, unsigned int num_acked, gboolean new_data_acked,
+                    gboolean all_data_acked, unsigned int flightsize, unsigned int srtt);
+    /** called on fast retransmission, when not already in fast recovery */
+    void (*on_loss) (cparm* path);
+    /** called on T3 timeout, when not in fast recovery */
+    void (*on_rto) (cparm* path);
+    /** called when a data chunk of length bytes is handed to bundling, may be NULL */
+    void (*on_send) (cparm* path, unsigned int bytes);
+    /** called when data is sent after the path was idle for more than one RTO */
+    void (*on_idle) (cparm* path);
+} cc_ops;
+
+
+/**
+ * @param  algorithm   one of the SCTP_CC_xxx values from sctp.h
+ * @return the congestion control module, or NULL if the algorithm is unknown
+ */
+const cc_ops* cc_getModule(unsigned int algorithm);
+
+#endif
@@ -55,11 +55,16 @@
 #include  "flowcontrol.h"       /* interfaces to flowcontrol */
 #include  "recvctrl.h"          /* interfaces to receive-controller */
 #include  "chunkHandler.h"
+#include  "congestion.h"        /* congestion control modules */
+#include  "scheduler.h"         /* stream scheduler modules */
+#include  "eventqueue.h"        /* completion queues */
+#include  "trace.h"             /* binary event tracing */
 
 #include  <sys/types.h>
 #include  <errno.h>
 #ifdef WIN32
 #include <winsock2.h>
+#include <malloc.h>             /* for _aligned_malloc() */
 #else
 #include  <arpa/inet.h>         /* for inet_ntoa() under both SOLARIS/LINUX */
 #endif
@@ -77,10 +82,20 @@
 static int      myRWND                      = 0x7FFF;
 static union    sockunion *myAddressList    = NULL;
 static unsigned int myNumberOfAddresses     = 0;
+/* largest MTU of the local interfaces */
+static int myMaxMTU = DEFAULT_MTU_SIZE;
 static gboolean sendAbortForOOTB            = TRUE;
 static int      checksumAlgorithm           = SCTP_CHECKSUM_ALGORITHM_CRC32C;
 static gboolean librarySupportsPRSCTP         = TRUE;
 static gboolean supportADDIP                = FALSE;
+static gboolean librarySupportsECN          = FALSE;
+static gboolean librarySupportsNRSACK       = FALSE;
+static gboolean librarySupportsIDATA        = FALSE;
+static unsigned int memoryBudget            = DEFAULT_MEMORY_BUDGET;
+static unsigned int memoryInUse             = 0;
+static gboolean memoryPressure              = FALSE;
+/* TRUE, if associations wait for a memory pressure notification, see mdi_deliverMemoryPressure() */
+static gboolean memoryPressureChanged       = FALSE;
 /*------------------------Structure Definitions --------------------------------------------------*/
 
 /**
@@ -105,6 +120,8 @@ typedef struct SCTPINSTANCE
     gboolean    uses_IPv6;
     /** set of callback functions that were registered by the ULP */
     SCTP_ulpCallbacks ULPcallbackFunctions;
+    /** completion queue, that replaces the callback functions, NULL if not used */
+    void* eventQueue;
     /** maximum number of incoming streams that this instance will take */
     unsigned short noOfInStreams;
     /** maximum number of outgoingng streams that this instance will take */
@@ -123,14 +140,57 @@ typedef struct SCTPINSTANCE
     unsigned int default_maxSendQueue;
     unsigned int default_maxRecvQueue;
     unsigned int default_maxBurst;
+    unsigned int default_congestionControl;
+    unsigned int default_pacingGain;
+    unsigned int default_streamScheduler;
+    /** TRUE, if the ULP changed default_streamScheduler */
+    gboolean    default_streamSchedulerChosen;
+    gboolean    default_concurrentMultipath;
+    gboolean    default_pathMTUDiscovery;
+    gboolean    default_rwndAutotuning;
+    unsigned int default_corkDelay;
+    gboolean    default_coalesceDataArrivals;
     unsigned int supportedAddressTypes;
     gboolean    supportsPRSCTP;
     gboolean    supportsADDIP;
+    gboolean    supportsECN;
+    gboolean    supportsNRSACK;
+    gboolean    supportsIDATA;
    /*@}*/
 }
 SCTP_instance;
 
 
+/**
+ * The statistics counters of an association live in a block of their own. The association
+ * counters and the counters of each path are padded to whole cache lines, so updating them
+ * in the hot paths does not touch the cache lines of the association data or of other paths.
+ */
+#define STATISTICS_CACHE_LINE   64
+#define STATISTICS_PADDED(x)    (((sizeof(x) + STATISTICS_CACHE_LINE - 1) / STATISTICS_CACHE_LINE) * STATISTICS_CACHE_LINE)
+
+typedef union ASSOCIATION_STATISTICS_BLOCK
+{
+    SCTP_AssociationStatistics counters;
+    unsigned char padding[STATISTICS_PADDED(SCTP_AssociationStatistics)];
+} AssociationStatisticsBlock;
+
+typedef union PATH_STATISTICS_BLOCK
+{
+    SCTP_PathStatistics counters;
+    unsigned char padding[STATISTICS_PADDED(SCTP_PathStatistics)];
+} PathStatisticsBlock;
+
+typedef struct STATISTICS_BLOCK
+{
+    AssociationStatisticsBlock assoc;
+    PathStatisticsBlock path[MAX_NUM_ADDRESSES];
+    /* latency histograms, allocated when the first sample is recorded */
+    SCTP_LatencyHistogram* rttHistogram[MAX_NUM_ADDRESSES];
+    SCTP_LatencyHistogram* ackLatencyHistogram;
+} StatisticsBlock;
+
+
 /**
  * This struct contains all data of an association. As far as other modules must know elements
  * of this struct, read functions are provided. No other module has write access to this structure.
@@ -185,14 +245,46 @@ typedef struct ASSOCIATION
     unsigned int supportedAddressTypes;
     unsigned int maxSendQueue;
     unsigned int maxRecvQueue;
+    /** congestion control algorithm (SCTP_CC_xxx) of new flowcontrol instances */
+    unsigned int congestionControl;
+    /** pacing gain in percent of new flowcontrol instances, 0 for no pacing */
+    unsigned int pacingGain;
+    /** stream scheduler (SCTP_SS_xxx) of new flowcontrol instances */
+    unsigned int streamScheduler;
+    /** TRUE, if the ULP chose the stream scheduler, else it follows the use of I-DATA */
+    gboolean    streamSchedulerChosen;
+    /** TRUE, if new data is spread over all active paths (CMT) */
+    gboolean    concurrentMultipath;
+    /** TRUE, if data arrivals are reported with one dataArriveBatchNotif per event loop pass */
+    gboolean    coalesceDataArrivals;
+    /** number of messages per inbound stream, that arrived since the last dataArriveBatchNotif */
+    unsigned int* arrivedMessages;
+    /** number of entries in arrivedMessages */
+    unsigned int arrivedStreams;
+    /** TRUE while the association is in PendingArrivals */
+    gboolean    arrivalsPending;
     gboolean    had_INADDR_ANY_set;
     gboolean    had_IN6ADDR_ANY_set;
     /* do I support the SCTP extensions ? */
     gboolean    supportsPRSCTP;
     gboolean    supportsADDIP;
+    gboolean    supportsECN;
+    gboolean    supportsNRSACK;
+    gboolean    supportsIDATA;
     /* and these values for our peer */
     gboolean    peerSupportsPRSCTP;
     gboolean    peerSupportsADDIP;
+    gboolean    peerSupportsECN;
+    gboolean    peerSupportsNRSACK;
+    gboolean    peerSupportsIDATA;
+    /** bytes of user data held in the queues of this association */
+    unsigned int memoryInUse;
+    /** TRUE, if memory pressure was signalled for this association */
+    gboolean    memoryPressureNotified;
+    /** TRUE, if the ULP has not yet been told the current memoryPressureNotified state */
+    gboolean    memoryPressurePending;
+    /** cumulative protocol counters of this association and its paths */
+    StatisticsBlock* statistics;
     /*@}*/
 } Association;
 
@@ -207,6 +299,11 @@ static gboolean sctpLibraryInitialized = FALSE;
  */
 static GList* AssociationList = NULL;
 
+/**
+ * IDs of the associations with coalesced data arrivals, that the ULP has not been notified of
+ */
+static GList* PendingArrivals = NULL;
+
 /**
  * Whenever an external event (ULP-call, socket-event or timer-event) this variable must
  * contain the addressed sctp instance.
@@ -230,6 +327,11 @@ static unsigned int ipv4_users = 0;
  */
 static Association *currentAssociation;
 static Association tmpAssoc;
+
+/**
+ * counters of packets that could not be assigned to an association
+ */
+static AssociationStatisticsBlock unassignedStatistics;
 static union sockunion tmpAddress;
 
 
@@ -252,6 +354,8 @@ static union sockunion *lastFromAddress;
 static union sockunion *lastDestAddress;
 
 static short lastFromPath;
+/** TRUE, if the last received packet was marked CE (congestion experienced) */
+static gboolean lastCongestionExperienced = FALSE;
 static unsigned short lastFromPort;
 static unsigned short lastDestPort;
 static unsigned int lastInitiateTag;
@@ -272,6 +376,8 @@ static unsigned int numberOfSeizedPorts;
 
 /* ---------------------- Internal Function Prototypes ------------------------------------------- */
 unsigned short mdi_getUnusedInstanceName(void);
+static void mdi_queueDataArrival(Association* assoc, unsigned short streamID);
+static void mdi_queueEvent(SCTP_Event* event, unsigned int type);
 
 
 /* ------------------------- Function Implementations --------------------------------------------- */
@@ -284,13 +390,13 @@ unsigned short mdi_getUnusedInstanceName(void);
 #ifdef LIBRARY_DEBUG
  #define ENTER_LIBRARY(fname)	printf("Entering sctplib  (%s)\n", fname); fflush(stdout);
  #define LEAVE_LIBRARY(fname)	printf("Leaving  sctplib  (%s)\n", fname); fflush(stdout);
- #define ENTER_CALLBACK(fname)	printf("Entering callback (%s)\n", fname); fflush(stdout);
- #define LEAVE_CALLBACK(fname)	printf("Leaving  callback (%s)\n", fname); fflush(stdout);
+ #define ENTER_CALLBACK(fname)	printf("Entering callback (%s)\n", fname); fflush(stdout); adl_profileStart(SCTP_PROFILE_ULP_NOTIFICATIONS);
+ #define LEAVE_CALLBACK(fname)	adl_profileStop(SCTP_PROFILE_ULP_NOTIFICATIONS); printf("Leaving  callback (%s)\n", fname); fflush(stdout);
 #else
  #define ENTER_LIBRARY(fname)
  #define LEAVE_LIBRARY(fname)
- #define ENTER_CALLBACK(fname)
- #define LEAVE_CALLBACK(fname)
+ #define ENTER_CALLBACK(fname)	adl_profileStart(SCTP_PROFILE_ULP_NOTIFICATIONS);
+ #define LEAVE_CALLBACK(fname)	adl_profileStop(SCTP_PROFILE_ULP_NOTIFICATIONS);
 #endif
 /*------------------- Internal LIST Functions ----------------------------------------------------*/
 
@@ -676,6 +782,177 @@ static void releasePort(unsigned short portSeized)
 
 /*------------------- Other Internal Functions ---------------------------------------------------*/
 
+/**
+ * mdi_checkMemoryPressure re-evaluates the fill level of the library-wide memory budget.
+ * When memory pressure starts, the associations that hold most memory are marked, when
+ * it ends, these associations are marked again. As this runs in the middle of sending
+ * or receiving, the ULP is only notified by mdi_deliverMemoryPressure().
+ */
+static void mdi_checkMemoryPressure(void)
+{
+    Association *top[MEMORY_PRESSURE_NOTIFY];
+    Association *assoc = NULL;
+    GList* tmp = NULL;
+    int count = 0, i;
+
+    if (memoryPressure == FALSE) {
+        if (memoryBudget == 0 || memoryInUse < memoryBudget / 100 * MEMORY_PRESSURE_ON) return;
+
+        memoryPressure = TRUE;
+        event_logii(EXTERNAL_EVENT, "mdi_checkMemoryPressure: memory pressure starts, %u of %u bytes in use",
+                    memoryInUse, memoryBudget);
+
+        /* find the largest consumers, keeping top[] sorted by descending usage */
+        for (tmp = g_list_first(AssociationList); tmp != NULL; tmp = g_list_next(tmp)) {
+            assoc = (Association *)tmp->data;
+            if (assoc->deleted || assoc->memoryInUse == 0) continue;
+            for (i = count; i > 0 && top[i-1]->memoryInUse < assoc->memoryInUse; i--) {
+                if (i < MEMORY_PRESSURE_NOTIFY) top[i] = top[i-1];
+            }
+            if (i < MEMORY_PRESSURE_NOTIFY) {
+                top[i] = assoc;
+                if (count < MEMORY_PRESSURE_NOTIFY) count++;
+            }
+        }
+        for (i = 0; i < count; i++) {
+            top[i]->memoryPressureNotified = TRUE;
+            /* a start and an end, that were not yet reported, cancel out */
+            top[i]->memoryPressurePending = !top[i]->memoryPressurePending;
+            memoryPressureChanged = TRUE;
+        }
+    } else {
+        if (memoryBudget != 0 && memoryInUse > memoryBudget / 100 * MEMORY_PRESSURE_OFF) return;
+
+        memoryPressure = FALSE;
+        event_logii(EXTERNAL_EVENT, "mdi_checkMemoryPressure: memory pressure ends, %u of %u bytes in use",
+                    memoryInUse, memoryBudget);
+
+        tmp = g_list_first(AssociationList);
+        while (tmp != NULL) {
+            assoc = (Association *)tmp->data;
+            tmp = g_list_next(tmp);
+            if (assoc->memoryPressureNotified == FALSE) continue;
+            assoc->memoryPressureNotified = FALSE;
+            assoc->memoryPressurePending = !assoc->memoryPressurePending;
+            memoryPressureChanged = TRUE;
+        }
+    }
+}
+
+
+/**
+ * returns all memory that is still charged to an association, whose queues have been freed
+ * @param assoc  pointer to the association
+ */
+static void mdi_releaseAssociationMemory(Association * assoc)
+{
+    if (assoc->memoryInUse > memoryInUse) memoryInUse = 0;
+    else memoryInUse -= assoc->memoryInUse;
+    assoc->memoryInUse = 0;
+    mdi_checkMemoryPressure();
+}
+
+
+/**
+ * allocates a zeroed statistics block, aligned to a cache line, so that the padding
+ * of its counters really keeps them in cache lines of their own
+ * @return pointer to the statistics block, or NULL
+ */
+static StatisticsBlock* mdi_allocStatistics(void)
+{
+    void* statistics;
+
+#ifdef WIN32
+    statistics = _aligned_malloc(sizeof(StatisticsBlock), STATISTICS_CACHE_LINE);
+#else
+    if (posix_memalign(&statistics, STATISTICS_CACHE_LINE, sizeof(StatisticsBlock)) != 0)
+        statistics = NULL;
+#endif
+    if (statistics != NULL) memset(statistics, 0, sizeof(StatisticsBlock));
+    return (StatisticsBlock*)statistics;
+}
+
+
+/**
+ * frees the statistics block of an association, including its histograms
+ * @param statistics  pointer to the statistics block (may be NULL)
+ */
+static void mdi_freeStatistics(StatisticsBlock* statistics)
+{
+    int i;
+
+    if (statistics == NULL) return;
+    for (i = 0; i < MAX_NUM_ADDRESSES; i++) {
+        free(statistics->rttHistogram[i]);
+    }
+    free(statistics->ackLatencyHistogram);
+#ifdef WIN32
+    _aligned_free(statistics);
+#else
+    free(statistics);
+#endif
+}
+
+
+/**
+ * computes the histogram bucket of a value in constant time: values below
+ * SCTP_HISTOGRAM_SUB_BUCKETS are counted exactly, larger values by the position
+ * of their highest bit, refined by the three bits following it.
+ * @param value  the sample
+ * @return index of the bucket
+ */
+static unsigned int mdi_histogramBucket(unsigned int value)
+{
+    unsigned int msb;
+
+    if (value < SCTP_HISTOGRAM_SUB_BUCKETS) return value;
+#if defined(__GNUC__)
+    msb = 31 - __builtin_clz(value);
+#else
+    for (msb = 31; (value & (1u << msb)) == 0; msb--);
+#endif
+    return (msb - 2) * SCTP_HISTOGRAM_SUB_BUCKETS + ((value >> (msb - 3)) & (SCTP_HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+
+/**
+ * adds one sample to a histogram, allocating the histogram on first use
+ * @param histogram  pointer to where the histogram pointer is stored
+ * @param value      the sample
+ */
+static void mdi_recordHistogram(SCTP_LatencyHistogram** histogram, unsigned int value)
+{
+    SCTP_LatencyHistogram* h = *histogram;
+
+    if (h == NULL) {
+        h = (SCTP_LatencyHistogram*) calloc(1, sizeof(SCTP_LatencyHistogram));
+        if (h == NULL) {
+            error_log(ERROR_MINOR, "mdi_recordHistogram: out of memory, dropping sample");
+            return;
+        }
+        *histogram = h;
+    }
+    if (h->samples == 0 || value < h->minimum) h->minimum = value;
+    if (value > h->maximum) h->maximum = value;
+    h->samples++;
+    h->sum += value;
+    h->bucket[mdi_histogramBucket(value)]++;
+}
+
+
+/**
+ * copies a histogram for the ULP; a histogram that has not been allocated yet is empty
+ */
+static void mdi_copyHistogram(SCTP_LatencyHistogram* target, SCTP_LatencyHistogram* source)
+{
+    if (source == NULL) {
+        memset(target, 0, sizeof(SCTP_LatencyHistogram));
+    } else {
+        memcpy(target, source, sizeof(SCTP_LatencyHistogram));
+    }
+}
+
+
 /**
  * deleteAssociation removes the association from the list of associations, frees all data allocated
  *  for it and <calls moduleprefix>_delete*(...) function at all modules.
@@ -710,6 +987,7 @@ static void mdi_removeAssociationData(Association * assoc)
         pm_deletePathman(assoc->pathMan);
         bu_delete(assoc->bundling);
         sci_deleteSCTP_control(assoc->sctp_control);
+        mdi_releaseAssociationMemory(assoc);
 
         assoc->pathMan = NULL;
         assoc->bundling = NULL;
@@ -718,8 +996,11 @@ static void mdi_removeAssociationData(Association * assoc)
         /* free association data */
         free(assoc->destinationAddresses);
         free(assoc->localAddresses);
+        free(assoc->arrivedMessages);
+        mdi_freeStatistics(assoc->statistics);
         assoc->destinationAddresses = NULL;
         assoc->localAddresses = NULL;
+        assoc->statistics = NULL;
         free(assoc);
     } else {
         error_log(ERROR_MAJOR, "mdi_removeAssociationData: association does not exist");
@@ -833,13 +1114,15 @@ mdi_dummy_callback(gint socket_fd,
  *  @param bufferlength       length of datagramm
  *  @param fromAddress        source address of DG
  *  @param portnum            bogus port number
+ *  @param tos                TOS byte / traffic class of the IP header, for the ECN codepoint
  */
 void
 mdi_receiveMessage(gint socket_fd,
                    unsigned char *buffer,
                    int bufferLength,
                    union sockunion * source_addr,
-                   union sockunion * dest_addr)
+                   union sockunion * dest_addr,
+                   unsigned char tos)
 {
     SCTP_message *message;
     SCTP_init_fixed *initChunk = NULL;
@@ -864,17 +1147,21 @@ mdi_receiveMessage(gint socket_fd,
 
     SCTP_instance temporary;
     GList* result = NULL;
+    SCTP_AssociationStatistics* stats;
+    SCTP_PathStatistics* pathStats;
 
     /* FIXME:  check this out, if it works at all :-D */
     lastFromAddress = source_addr;
     lastDestAddress = dest_addr;
 
     lastFromPath = 0;
+    lastCongestionExperienced = ((tos & IPTOS_ECN_MASK) == IPTOS_ECN_CE);
 
     message = (SCTP_message *) buffer;
 
     if (!validate_datagram(buffer, bufferLength)) {
         event_log(INTERNAL_EVENT_0, "received corrupted datagramm");
+        unassignedStatistics.counters.invalidPackets++;
         lastFromAddress = NULL;
         lastDestAddress = NULL;
         return;
@@ -889,6 +1176,7 @@ mdi_receiveMessage(gint socket_fd,
 
     if (lastFromPort == 0 || lastDestPort == 0) {
         error_log(ERROR_MINOR, "received DG with invalid (i.e. 0) ports");
+        unassignedStatistics.counters.invalidPackets++;
         lastFromAddress = NULL;
         lastDestAddress = NULL;
         lastFromPort = 0;
@@ -953,14 +1241,18 @@ mdi_receiveMessage(gint socket_fd,
         error_log(ERROR_FATAL, "mdi_receiveMessage: Unsupported AddressType Received !");
         discard = TRUE;
     }
-    adl_sockunion2str(source_addr, source_addr_string, SCTP_MAX_IP_LEN);
-    adl_sockunion2str(dest_addr, dest_addr_string, SCTP_MAX_IP_LEN);
+    /* address strings are only needed for logging, do not format them per packet otherwise */
+    if (Current_event_log_ >= EXTERNAL_EVENT) {
+        adl_sockunion2str(source_addr, source_addr_string, SCTP_MAX_IP_LEN);
+        adl_sockunion2str(dest_addr, dest_addr_string, SCTP_MAX_IP_LEN);
+    }
 
     event_logiiiii(EXTERNAL_EVENT,
                   "mdi_receiveMessage : len %d, sourceaddress : %s, src_port %u,dest: %s, dest_port %u",
                   bufferLength, source_addr_string, lastFromPort, dest_addr_string,lastDestPort);
 
     if (discard == TRUE) {
+        unassignedStatistics.counters.droppedPackets++;
         lastFromAddress = NULL;
         lastDestAddress = NULL;
         lastFromPort = 0;
@@ -1012,6 +1304,7 @@ mdi_receiveMessage(gint socket_fd,
 
     if (mdi_destination_address_okay(dest_addr) == FALSE) {
          event_log(VERBOSE, "mdi_receiveMsg: this packet is not for me, DISCARDING !!!");
+         mdi_readStatistics()->droppedPackets++;
          lastFromAddress = NULL;
          lastDestAddress = NULL;
          lastFromPort = 0;
@@ -1023,6 +1316,10 @@ mdi_receiveMessage(gint socket_fd,
 
     lastInitiateTag = ntohl(message->common_header.verification_tag);
 
+    trc_event(SCTP_TRACE_MODULE_DISTRIBUTION, TRC_PACKET_RECEIVED,
+              (currentAssociation != NULL) ? currentAssociation->assocId : 0,
+              lastInitiateTag, bufferLength);
+
     chunkArray = rbu_scanPDU(message->sctp_pdu, len);
 
 
@@ -1067,6 +1364,7 @@ mdi_receiveMessage(gint socket_fd,
        ){
 
         error_log(ERROR_MINOR, "mdi_receiveMsg: discarding illegal packet....... :-)");
+        mdi_readStatistics()->droppedPackets++;
 
         /* silently discard */
          lastFromAddress = NULL;
@@ -1081,6 +1379,7 @@ mdi_receiveMessage(gint socket_fd,
     /* check if sctp-message belongs to an existing association */
     if (currentAssociation == NULL) {
          event_log(VVERBOSE, "mdi_receiveMsg: currentAssociation==NULL, start scanning !");
+         unassignedStatistics.counters.ootbPackets++;
          /* This is not very elegant, but....only used when assoc is being build up, so :-D */
          if (rbu_datagramContains(CHUNK_ABORT, chunkArray) == TRUE) {
             event_log(INTERNAL_EVENT_0, "mdi_receiveMsg: Found ABORT chunk, discarding it !");
@@ -1221,6 +1520,7 @@ mdi_receiveMessage(gint socket_fd,
         if (lastFromPort != currentAssociation->remotePort || lastDestPort != currentAssociation->localPort) {
             error_logiiii(ERROR_FATAL,
                           "port mismatch in received DG (lastFromPort=%u, assoc->remotePort=%u, lastDestPort=%u, assoc->localPort=%u ",   lastFromPort, currentAssociation->remotePort,                          lastDestPort, currentAssociation->localPort);
+            mdi_readStatistics()->droppedPackets++;
             currentAssociation = NULL;
             sctpInstance = NULL;
             lastFromAddress = NULL;
@@ -1252,6 +1552,7 @@ mdi_receiveMessage(gint socket_fd,
         if (!sourceAddressExists) {
             error_log(ERROR_MINOR,
                       "source address of received DG is not in the destination addresslist");
+            mdi_readStatistics()->droppedPackets++;
             currentAssociation = NULL;
             sctpInstance = NULL;
             lastFromPort = 0;
@@ -1367,6 +1668,7 @@ mdi_receiveMessage(gint socket_fd,
             event_logii(EXTERNAL_EVENT,
                         "Tag mismatch in receive DG, received Tag = %u, local Tag = %u -> discarding",
                         lastInitiateTag, currentAssociation->tagLocal);
+            mdi_readStatistics()->droppedPackets++;
             currentAssociation = NULL;
             sctpInstance = NULL;
             lastFromPort = 0;
@@ -1415,6 +1717,14 @@ mdi_receiveMessage(gint socket_fd,
         return;
     }
 
+    stats = mdi_readStatistics();
+    stats->packetsReceived++;
+    stats->bytesReceived += bufferLength;
+    if ((pathStats = mdi_readPathStatistics(lastFromPath)) != NULL) {
+        pathStats->packetsReceived++;
+        pathStats->bytesReceived += bufferLength;
+    }
+
     /* forward DG to bundling */
     rbu_rcvDatagram(lastFromPath, message->sctp_pdu, bufferLength - sizeof(SCTP_common_header));
 
@@ -1424,11 +1734,73 @@ mdi_receiveMessage(gint socket_fd,
     lastDestAddress = NULL;
     lastFromAddress = NULL;
     lastFromPath = -1;          /* only valid for functions called via mdi_receiveMessage */
+    lastCongestionExperienced = FALSE;
 
 }                               /* end: mdi_receiveMessage */
 
 
 
+/**
+ *  mdi_icmpReceived is called by the Unix-interface module when an ICMP or ICMPv6 message
+ *  quoting an SCTP packet was received. The association is looked up by the addresses and
+ *  ports of the quoted packet, and the message is only used if the quoted verification tag
+ *  is the one of the peer (see RFC 4960, appendix C). A packet with tag zero carried an INIT,
+ *  these are left to the INIT timer.
+ *
+ *  @param peerAddress        destination address of the quoted packet
+ *  @param localPort          source port of the quoted packet
+ *  @param remotePort         destination port of the quoted packet
+ *  @param verificationTag    verification tag of the quoted packet
+ *  @param icmpEvent          MDI_ICMP_UNREACHABLE or MDI_ICMP_PACKET_TOO_BIG
+ *  @param mtu                next hop MTU for MDI_ICMP_PACKET_TOO_BIG, else 0
+ */
+void mdi_icmpReceived(union sockunion * peerAddress,
+                      unsigned short localPort,
+                      unsigned short remotePort,
+                      unsigned int verificationTag,
+                      int icmpEvent,
+                      unsigned int mtu)
+{
+    short pathID;
+
+    if (verificationTag == 0) return;
+
+    currentAssociation = retrieveAssociationByTransportAddress(peerAddress, remotePort, localPort);
+    if (currentAssociation == NULL) {
+        event_log(VERBOSE, "mdi_icmpReceived: no association for the quoted packet");
+        return;
+    }
+    if (currentAssociation->tagRemote != verificationTag) {
+        event_logii(VERBOSE, "mdi_icmpReceived: tag %08x does not match peer tag %08x",
+                    verificationTag, currentAssociation->tagRemote);
+        currentAssociation = NULL;
+        return;
+    }
+    sctpInstance = currentAssociation->sctpInstance;
+
+    pathID = mdi_getIndexForAddress(peerAddress);
+    if (pathID >= 0) {
+        switch (icmpEvent) {
+        case MDI_ICMP_UNREACHABLE:
+            event_logii(INTERNAL_EVENT_0, "mdi_icmpReceived: path %d of assoc %u unreachable",
+                        pathID, currentAssociation->assocId);
+            pm_pathUnreachable(pathID);
+            break;
+        case MDI_ICMP_PACKET_TOO_BIG:
+            event_logiii(INTERNAL_EVENT_0, "mdi_icmpReceived: path %d of assoc %u has MTU %u",
+                         pathID, currentAssociation->assocId, mtu);
+            pm_pathMTUReduced(pathID, mtu);
+            break;
+        default:
+            break;
+        }
+    }
+    currentAssociation = NULL;
+    sctpInstance = NULL;
+}                               /* end: mdi_icmpReceived */
+
+
+
 
 /*------------------- Functions called by the ULP ------------------------------------------------*/
 /*------------------- Prototypes are defined in sctp.h -------------------------------------------*/
@@ -1500,6 +1872,7 @@ int sctp_initLibrary(void)
         LEAVE_LIBRARY("sctp_initLibrary");
         return SCTP_SPECIFIC_FUNCTION_ERROR;
     }
+    myMaxMTU = maxMTU;
 
     sctpLibraryInitialized = TRUE;
     LEAVE_LIBRARY("sctp_initLibrary");
@@ -1519,6 +1892,7 @@ int mdi_updateMyAddressList(void)
     if (adl_gatherLocalAddresses(&myAddressList, (int *)&myNumberOfAddresses,sfd,TRUE,&maxMTU,flag_Default) == FALSE) {
         return SCTP_SPECIFIC_FUNCTION_ERROR;
     }
+    myMaxMTU = maxMTU;
 
     return SCTP_SUCCESS;
 }
@@ -1754,6 +2128,9 @@ sctp_registerInstance(unsigned short port,
     sctpInstance->uses_IPv6 = TRUE;
     sctpInstance->supportsPRSCTP = librarySupportsPRSCTP;
     sctpInstance->supportsADDIP = supportADDIP;
+    sctpInstance->supportsECN = librarySupportsECN;
+    sctpInstance->supportsNRSACK = librarySupportsNRSACK;
+    sctpInstance->supportsIDATA = librarySupportsIDATA;
 
 
     if (noOfLocalAddresses == 1) {
@@ -1881,6 +2258,7 @@ sctp_registerInstance(unsigned short port,
     }
 
     sctpInstance->ULPcallbackFunctions = ULPcallbackFunctions;
+    sctpInstance->eventQueue = NULL;
 
     sctpInstance->default_rtoInitial = RTO_INITIAL;
     sctpInstance->default_validCookieLife = VALID_COOKIE_LIFE_TIME;
@@ -1896,6 +2274,15 @@ sctp_registerInstance(unsigned short port,
     sctpInstance->default_maxSendQueue = DEFAULT_MAX_SENDQUEUE;
     sctpInstance->default_maxRecvQueue = DEFAULT_MAX_RECVQUEUE;
     sctpInstance->default_maxBurst = DEFAULT_MAX_BURST;
+    sctpInstance->default_congestionControl = SCTP_CC_RENO;
+    sctpInstance->default_pacingGain = 0;
+    sctpInstance->default_streamScheduler = SCTP_SS_FCFS;
+    sctpInstance->default_streamSchedulerChosen = FALSE;
+    sctpInstance->default_concurrentMultipath = FALSE;
+    sctpInstance->default_pathMTUDiscovery = FALSE;
+    sctpInstance->default_rwndAutotuning = FALSE;
+    sctpInstance->default_corkDelay = DEFAULT_CORK_DELAY;
+    sctpInstance->default_coalesceDataArrivals = FALSE;
 
     InstanceList = g_list_insert_sorted(InstanceList, sctpInstance, &CompareInstanceNames);
 
@@ -1991,6 +2378,7 @@ int sctp_unregisterInstance(unsigned short instance_name)
         }
         event_log(VVERBOSE, "sctp_unregisterInstance : freeing instance ");
         releasePort(instance->localPort);
+        eq_delete(instance->eventQueue);
         free(instance);
         InstanceList = g_list_remove(InstanceList, result->data);
         LEAVE_LIBRARY("sctp_unregisterInstance");
@@ -2004,6 +2392,81 @@ int sctp_unregisterInstance(unsigned short instance_name)
 }
 
 
+/**
+ * sctp_setEventQueue switches an SCTP instance to the completion queue mode : instead of
+ * calling the functions in SCTP_ulpCallbacks, the library writes SCTP_Event records into
+ * a ring of size records. The returned file descriptor becomes readable, when there are
+ * records, which are then read with sctp_readEventQueue().
+ * Records that do not fit into a full ring are dropped, and counted in a later
+ * SCTP_EVENT_QUEUE_OVERFLOW record.
+ * The queue can not be replaced, as another thread may be reading it : it stays with
+ * the instance until sctp_unregisterInstance().
+ * @param  instance_name  the instance
+ * @param  size           number of records in the ring (at least SCTP_MIN_EVENT_QUEUE_SIZE),
+ *                        rounded up to a power of two
+ * @param  queue          returns the handle, that is passed to sctp_readEventQueue()
+ * @return file descriptor to poll, or a negative error code (SCTP_WRONG_STATE, if the
+ *         instance already has a completion queue)
+ */
+int sctp_setEventQueue(unsigned short instance_name, unsigned int size, void** queue)
+{
+    SCTP_instance temporary;
+    SCTP_instance* instance;
+    GList* result = NULL;
+
+    ENTER_LIBRARY("sctp_setEventQueue");
+
+    CHECK_LIBRARY;
+
+    if (size < SCTP_MIN_EVENT_QUEUE_SIZE || queue == NULL) {
+        LEAVE_LIBRARY("sctp_setEventQueue");
+        return SCTP_PARAMETER_PROBLEM;
+    }
+
+    temporary.sctpInstanceName = instance_name;
+    result = g_list_find_custom(InstanceList, &temporary, &CompareInstanceNames);
+    if (result == NULL) {
+        error_logi(ERROR_MAJOR, "sctp_setEventQueue : instance %u not found", instance_name);
+        LEAVE_LIBRARY("sctp_setEventQueue");
+        return SCTP_INSTANCE_NOT_FOUND;
+    }
+    instance = (SCTP_instance*)result->data;
+    if (instance->eventQueue != NULL) {
+        error_logi(ERROR_MINOR, "sctp_setEventQueue : instance %u already has a queue", instance_name);
+        LEAVE_LIBRARY("sctp_setEventQueue");
+        return SCTP_WRONG_STATE;
+    }
+
+    instance->eventQueue = eq_new(size);
+    if (instance->eventQueue == NULL) {
+        LEAVE_LIBRARY("sctp_setEventQueue");
+        return SCTP_OUT_OF_RESOURCES;
+    }
+    *queue = instance->eventQueue;
+
+    LEAVE_LIBRARY("sctp_setEventQueue");
+    return eq_getFd(instance->eventQueue);
+}
+
+
+/**
+ * sctp_readEventQueue removes up to max records from a completion queue. It only uses
+ * the queue, not the state of the library, so it may be called from another thread than
+ * the one running the library, as long as only one thread reads the queue, and the
+ * instance is not unregistered meanwhile.
+ * @param  queue          handle returned by sctp_setEventQueue()
+ * @param  events         array of max records, that is filled
+ * @param  max            maximum number of records to read
+ * @return number of records read, or a negative error code
+ */
+int sctp_readEventQueue(void* queue, SCTP_Event* events, unsigned int max)
+{
+    if (queue == NULL || events == NULL) return SCTP_PARAMETER_PROBLEM;
+
+    return (int)eq_get(queue, events, max);
+}
+
+
 /**
  * This function should be called AFTER an association has indicated a
  * COMMUNICATION_LOST or a SHUTDOWN_COMPLETE, and the upper layer has
@@ -2287,7 +2750,9 @@ int sctp_abort(unsigned int associationID)
  *  @param    lifetime       maximum time of chunk in send queue in msecs, 0 for infinite
  *  @param    unorderedDelivery chunk is delivered to peer without resequencing, if true (==1), else ordered (==0).
  *  @param    dontBundle     chunk must not be bundled with other data chunks.
- *                           boolean, 0==normal bundling, 1==do not bundle message
+ *                           boolean, 0==normal bundling, 1==do not bundle message,
+ *                           or'ed with SCTP_SACK_IMMEDIATELY, if the peer shall acknowledge
+ *                           the message without delay
  *  @return   error code     -1 for send error, 1 for association error, 0 if successful
  */
 int sctp_send_private(unsigned int associationID, unsigned short streamID,
@@ -2334,6 +2799,109 @@ int sctp_send_private(unsigned int associationID, unsigned short streamID,
 }                               /* end: sctp_send */
 
 
+/**
+ * sctp_sendv queues a batch of messages on an association. The association is looked
+ * up once, and transmission starts only after all messages have been queued, so that
+ * small messages are bundled into full packets.
+ * Queueing stops at the first message that can not be sent.
+ *
+ *  @param    associationID  the ID of the addressed association.
+ *  @param    msgs           array of message descriptors
+ *  @param    count          number of messages in msgs
+ *  @return   number of messages queued, or a negative error code, if none could be
+ *            queued : SCTP_WRONG_STATE, if the association is shutting down
+ */
+int sctp_sendv(unsigned int associationID, const SCTP_SendDescriptor* msgs, unsigned int count)
+{
+    int result = SCTP_SUCCESS;
+    unsigned int sent = 0;
+    SCTP_instance *old_Instance = sctpInstance;
+    Association *old_assoc = currentAssociation;
+    ENTER_LIBRARY("sctp_sendv");
+
+    CHECK_LIBRARY;
+
+    if (msgs == NULL && count > 0) {
+        LEAVE_LIBRARY("sctp_sendv");
+        return SCTP_PARAMETER_PROBLEM;
+    }
+
+    currentAssociation = retrieveAssociation(associationID);
+
+    if (currentAssociation != NULL) {
+        sctpInstance = currentAssociation->sctpInstance;
+        event_logii(INTERNAL_EVENT_1, "sctp_sendv: sending %u messages on association %u", count, associationID);
+
+        fc_hold_transmission();
+        for (sent = 0; sent < count; sent++) {
+            if ((msgs[sent].path_id < -1) || (msgs[sent].path_id >= currentAssociation->noOfNetworks)) {
+                error_logi(ERROR_MAJOR, "sctp_sendv: invalid destination address %d", msgs[sent].path_id);
+                result = SCTP_PARAMETER_PROBLEM;
+                break;
+            }
+            result = se_ulpsend(msgs[sent].streamID, msgs[sent].buffer, msgs[sent].length,
+                                msgs[sent].protocolId, msgs[sent].path_id, msgs[sent].context,
+                                msgs[sent].lifetime, msgs[sent].unorderedDelivery, msgs[sent].dontBundle);
+            if (result != SCTP_SUCCESS) break;
+        }
+        /* now the whole batch goes out */
+        fc_release_transmission();
+        if (sent > 0) {
+            result = (int)sent;
+        } else if (result == SCTP_SPECIFIC_FUNCTION_ERROR) {
+            /* se_ulpsend refuses data in shutdown states with a positive code, that
+               would read like one queued message */
+            result = SCTP_WRONG_STATE;
+        }
+    } else {
+        error_log(ERROR_MAJOR, "sctp_sendv: addressed association does not exist");
+        result = SCTP_ASSOC_NOT_FOUND ;
+    }
+
+    sctpInstance = old_Instance;
+    currentAssociation = old_assoc;
+    LEAVE_LIBRARY("sctp_sendv");
+    return result;
+}                               /* end: sctp_sendv */
+
+
+/**
+ * sctp_setCork corks or uncorks an association. While an association is corked, data
+ * is held back in the send queue, until a full packet can be sent, or the cork delay
+ * (see SCTP_AssociationStatus) has passed. Uncorking sends all queued data.
+ *
+ *  @param    associationID  the ID of the addressed association.
+ *  @param    cork           1 to cork the association, 0 to uncork it
+ *  @return   error code, 0 for success, 1 (or negative) for error
+ */
+int sctp_setCork(unsigned int associationID, int cork)
+{
+    int result;
+    SCTP_instance *old_Instance = sctpInstance;
+    Association *old_assoc = currentAssociation;
+    ENTER_LIBRARY("sctp_setCork");
+
+    CHECK_LIBRARY;
+
+    currentAssociation = retrieveAssociation(associationID);
+
+    if (currentAssociation != NULL) {
+        sctpInstance = currentAssociation->sctpInstance;
+        event_logii(VERBOSE, "sctp_setCork(assoc=%u, cork=%d)", associationID, cork);
+        fc_set_cork((cork != 0) ? TRUE : FALSE);
+        result = SCTP_SUCCESS;
+    } else {
+        error_log(ERROR_MAJOR, "sctp_setCork: addressed association does not exist");
+        result = SCTP_ASSOC_NOT_FOUND;
+    }
+
+    sctpInstance = old_Instance;
+    currentAssociation = old_assoc;
+    LEAVE_LIBRARY("sctp_setCork");
+    return result;
+}
+
+
 
 /**
  * sctp_setPrimary changes the primary path of an association.
@@ -2474,6 +3042,60 @@ int sctp_receivefrom(unsigned int associationID,
 }                               /* end: sctp_receive */
 
 
+/**
+ * sctp_receivev receives up to max messages in one call, either from one stream, or,
+ * with SCTP_ANY_STREAM, round robin from all streams that have messages ready.
+ * The caller sets buffer and length of each descriptor, the other fields are filled in.
+ * With SCTP_MSG_PEEK, at most one message per stream is returned, and not removed.
+ *  @param   associationID  ID of association.
+ *  @param   streamID       the stream to receive from, or SCTP_ANY_STREAM
+ *  @param   msgs           array of max message descriptors
+ *  @param   max            maximum number of messages to receive
+ *  @param   flags          SCTP_MSG_DEFAULT or SCTP_MSG_PEEK
+ *  @return  number of messages received, SCTP_NO_CHUNKS_IN_QUEUE if there was no data,
+ *           or a negative error code
+*/
+int sctp_receivev(unsigned int associationID,
+                  int streamID,
+                  SCTP_ReceiveDescriptor* msgs,
+                  unsigned int max,
+                  unsigned int flags)
+{
+    int result;
+    unsigned int count = 0;
+    SCTP_instance *old_Instance = sctpInstance;
+    Association *old_assoc = currentAssociation;
+
+    ENTER_LIBRARY("sctp_receivev");
+
+    CHECK_LIBRARY;
+
+    if (msgs == NULL || max == 0) {
+        LEAVE_LIBRARY("sctp_receivev");
+        return SCTP_PARAMETER_PROBLEM;
+    }
+    /* Retrieve association from list, as long as the data is not actually gone ! */
+    currentAssociation = retrieveAssociationForced(associationID);
+
+    if (currentAssociation != NULL) {
+        sctpInstance = currentAssociation->sctpInstance;
+        result = se_ulpreceivev(msgs, max, streamID, flags, &count);
+    } else {
+        error_log(ERROR_MAJOR, "sctp_receivev: addressed association does not exist");
+        result = SCTP_ASSOC_NOT_FOUND;
+    }
+    sctpInstance = old_Instance;
+    currentAssociation = old_assoc;
+
+    if (result == RECEIVE_DATA) result = (int)count;
+    else if (result == STREAM_ID_OVERFLOW) result = SCTP_PARAMETER_PROBLEM;
+    else if (result == NO_DATA_AVAILABLE) result = SCTP_NO_CHUNKS_IN_QUEUE;
+
+    LEAVE_LIBRARY("sctp_receivev");
+    return result;
+}                               /* end: sctp_receivev */
+
+
 
 /**
  * sctp_changeHeartBeat turns the hearbeat on a path of an association on or
@@ -2694,6 +3316,8 @@ int sctp_getPathStatus(unsigned int associationID, short path_id, SCTP_PathStatu
             status->outstandingBytesPerAddress = rtx_get_obpa((unsigned int)path_id, &totalBytesInFlight);
             status->mtu = fc_readMTU(path_id);
             status->ipTos = currentAssociation->ipTos;
+            status->pacingRate = fc_readPacingRate(path_id);
+            status->pacingDelay = fc_readPacingDelay(path_id);
             result = SCTP_SUCCESS;
         }
     } else {
@@ -2725,41 +3349,442 @@ int sctp_setPathStatus(unsigned int associationID, short path_id, SCTP_PathStatu
     return SCTP_UNSPECIFIED_ERROR;
 }
 
-
 /**
- * sctp_setAssocStatus allows for setting a number of association parameters.
- * _Not_ all values that the corresponding sctp_getAssocStatus-function returns
- * may be SET here !
- * Will set protocol parameters per SCTP association
+ * sctp_setPathMTU sets the MTU of a path in an existing association, e.g. to use
+ * jumbo frames. New messages are fragmented according to the smallest MTU of all
+ * paths (or of their destination), and the bundling buffers grow as needed.
+ * The mtu field of SCTP_PathStatus reports the value without IP and common header.
  *
  *  @param  associationID   ID of assocation.
- *  @param  new_status      pointer to new parameters
- *  @return -1
-*/
-int sctp_setAssocStatus(unsigned int associationID, SCTP_AssociationStatus* new_status)
+ *  @param  path_id         path for which to set the MTU
+ *  @param  mtu             size of the largest IP packet to send on the path,
+ *                          between 576 and 65535 bytes
+ *  @return 0 for success, not zero for error
+ */
+int sctp_setPathMTU(unsigned int associationID, short path_id, unsigned int mtu)
 {
-    guint16 result;
+    int result;
     SCTP_instance *old_Instance = sctpInstance;
     Association *old_assoc = currentAssociation;
 
-    ENTER_LIBRARY("sctp_setAssocStatus");
+    ENTER_LIBRARY("sctp_setPathMTU");
 
     CHECK_LIBRARY;
 
-    if (new_status == NULL) {
-        LEAVE_LIBRARY("sctp_setAssocStatus");
-        return SCTP_PARAMETER_PROBLEM;
-    }
+    event_logiii(VERBOSE, "sctp_setPathMTU: Association %u, Path %d, MTU %u", associationID, path_id, mtu);
+
     currentAssociation = retrieveAssociation(associationID);
 
     if (currentAssociation != NULL) {
-        sctpInstance = currentAssociation->sctpInstance;
-        event_logi(VERBOSE, "sctp_setAssocStatus: Association %u", associationID);
-        if (pm_setPrimaryPath(new_status->primaryAddressIndex)) {
-            error_logi(ERROR_MINOR, "pm_setPrimary(%u) returned error", new_status->primaryAddressIndex);
-            sctpInstance = old_Instance;
-            currentAssociation = old_assoc;
-            LEAVE_LIBRARY("sctp_setAssocStatus");
+        if (path_id >= 0 && path_id < currentAssociation->noOfNetworks) {
+            sctpInstance = currentAssociation->sctpInstance;
+            result = fc_setMTU(path_id, mtu);
+        } else {
+            result = SCTP_PARAMETER_PROBLEM;
+        }
+    } else {
+        error_log(ERROR_MAJOR, "sctp_setPathMTU: association does not exist");
+        result = SCTP_ASSOC_NOT_FOUND;
+    }
+    sctpInstance = old_Instance;
+    currentAssociation = old_assoc;
+    LEAVE_LIBRARY("sctp_setPathMTU");
+    return result;
+}
+
+
+/* common part of sctp_setStreamPriority() and sctp_setStreamWeight() */
+static int sctp_setStreamParameter(unsigned int associationID, unsigned short streamID, unsigned int value,
+                                   int (*set)(unsigned short, unsigned int), const char* name)
+{
+    int result;
+    SCTP_instance *old_Instance = sctpInstance;
+    Association *old_assoc = currentAssociation;
+
+    ENTER_LIBRARY(name);
+
+    CHECK_LIBRARY;
+
+    event_logiii(VERBOSE, "%s: Association %u, Stream %u", name, associationID, streamID);
+
+    currentAssociation = retrieveAssociation(associationID);
+
+    if (currentAssociation != NULL) {
+        sctpInstance = currentAssociation->sctpInstance;
+        if (currentAssociation->flowControl != NULL && streamID < se_numOfSendStreams()) {
+            result = set(streamID, value);
+        } else {
+            result = SCTP_PARAMETER_PROBLEM;
+        }
+    } else {
+        error_logi(ERROR_MAJOR, "%s: association does not exist", name);
+        result = SCTP_ASSOC_NOT_FOUND;
+    }
+    sctpInstance = old_Instance;
+    currentAssociation = old_assoc;
+    LEAVE_LIBRARY(name);
+    return result;
+}
+
+/* common part of sctp_getStreamPriority() and sctp_getStreamWeight() */
+static int sctp_getStreamParameter(unsigned int associationID, unsigned short streamID, unsigned int* value,
+                                   int (*get)(unsigned short, unsigned int*), const char* name)
+{
+    int result;
+    SCTP_instance *old_Instance = sctpInstance;
+    Association *old_assoc = currentAssociation;
+
+    ENTER_LIBRARY(name);
+
+    CHECK_LIBRARY;
+
+    if (value == NULL) {
+        LEAVE_LIBRARY(name);
+        return SCTP_PARAMETER_PROBLEM;
+    }
+
+    currentAssociation = retrieveAssociation(associationID);
+
+    if (currentAssociation != NULL) {
+        sctpInstance = currentAssociation->sctpInstance;
+        if (currentAssociation->flowControl != NULL && streamID < se_numOfSendStreams()) {
+            result = get(streamID, value);
+        } else {
+            result = SCTP_PARAMETER_PROBLEM;
+        }
+    } else {
+        error_logi(ERROR_MAJOR, "%s: association does not exist", name);
+        result = SCTP_ASSOC_NOT_FOUND;
+    }
+    sctpInstance = old_Instance;
+    currentAssociation = old_assoc;
+    LEAVE_LIBRARY(name);
+    return result;
+}
+
+/**
+ * sctp_setStreamPriority sets the priority of an outbound stream, that the SCTP_SS_PRIO
+ * stream scheduler uses : data of streams with a lower value is always sent first,
+ * streams of the same priority take turns. The default priority is 0.
+ *
+ *  @param  associationID   ID of assocation.
+ *  @param  streamID        outbound stream
+ *  @param  priority        new priority of the stream
+ *  @return 0 for success, not zero for error
+ */
+int sctp_setStreamPriority(unsigned int associationID, unsigned short streamID, unsigned int priority)
+{
+    return sctp_setStreamParameter(associationID, streamID, priority, fc_set_streamPriority, "sctp_setStreamPriority");
+}
+
+/**
+ * sctp_getStreamPriority returns the priority of an outbound stream, see sctp_setStreamPriority()
+ *
+ *  @param  associationID   ID of assocation.
+ *  @param  streamID        outbound stream
+ *  @param  priority        pointer to the priority, filled by this function
+ *  @return 0 for success, not zero for error
+ */
+int sctp_getStreamPriority(unsigned int associationID, unsigned short streamID, unsigned int* priority)
+{
+    return sctp_getStreamParameter(associationID, streamID, priority, fc_get_streamPriority, "sctp_getStreamPriority");
+}
+
+/**
+ * sctp_setStreamWeight sets the weight of an outbound stream, that the SCTP_SS_WFQ
+ * stream scheduler uses : busy streams share the sending rate in proportion to their
+ * weights. The default weight is 1.
+ *
+ *  @param  associationID   ID of assocation.
+ *  @param  streamID        outbound stream
+ *  @param  weight          new weight of the stream, at least 1
+ *  @return 0 for success, not zero for error
+ */
+int sctp_setStreamWeight(unsigned int associationID, unsigned short streamID, unsigned int weight)
+{
+    return sctp_setStreamParameter(associationID, streamID, weight, fc_set_streamWeight, "sctp_setStreamWeight");
+}
+
+/**
+ * sctp_getStreamWeight returns the weight of an outbound stream, see sctp_setStreamWeight()
+ *
+ *  @param  associationID   ID of assocation.
+ *  @param  streamID        outbound stream
+ *  @param  weight          pointer to the weight, filled by this function
+ *  @return 0 for success, not zero for error
+ */
+int sctp_getStreamWeight(unsigned int associationID, unsigned short streamID, unsigned int* weight)
+{
+    return sctp_getStreamParameter(associationID, streamID, weight, fc_get_streamWeight, "sctp_getStreamWeight");
+}
+
+
+/**
+ * sctp_getAssocStatistics returns the cumulative protocol counters of an association.
+ * Association ID 0 returns the counters of packets that did not belong to any
+ * association (out of the blue, invalid and dropped packets).
+ *
+ *  @param  associationID   ID of assocation, or 0
+ *  @param  statistics      pointer to a SCTP_AssociationStatistics structure to be filled
+ *  @return SCTP_SUCCESS, SCTP_PARAMETER_PROBLEM or SCTP_ASSOC_NOT_FOUND
+ */
+int sctp_getAssocStatistics(unsigned int associationID, SCTP_AssociationStatistics* statistics)
+{
+    int result = SCTP_SUCCESS;
+    Association *assoc = NULL;
+
+    ENTER_LIBRARY("sctp_getAssocStatistics");
+
+    CHECK_LIBRARY;
+
+    if (statistics == NULL) {
+        LEAVE_LIBRARY("sctp_getAssocStatistics");
+        return SCTP_PARAMETER_PROBLEM;
+    }
+
+    if (associationID == 0) {
+        memcpy(statistics, &(unassignedStatistics.counters), sizeof(SCTP_AssociationStatistics));
+    } else {
+        assoc = retrieveAssociation(associationID);
+        if (assoc == NULL) {
+            error_logi(ERROR_MAJOR, "sctp_getAssocStatistics : association %u does not exist", associationID);
+            result = SCTP_ASSOC_NOT_FOUND;
+        } else if (assoc->statistics == NULL) {
+            memset(statistics, 0, sizeof(SCTP_AssociationStatistics));
+        } else {
+            memcpy(statistics, &(assoc->statistics->assoc.counters), sizeof(SCTP_AssociationStatistics));
+        }
+    }
+    LEAVE_LIBRARY("sctp_getAssocStatistics");
+    return result;
+}
+
+
+/**
+ * sctp_getPathStatistics returns the cumulative protocol counters of one path
+ * of an association.
+ *
+ *  @param  associationID   ID of assocation.
+ *  @param  path_id         index of the path
+ *  @param  statistics      pointer to a SCTP_PathStatistics structure to be filled
+ *  @return SCTP_SUCCESS, SCTP_PARAMETER_PROBLEM or SCTP_ASSOC_NOT_FOUND
+ */
+int sctp_getPathStatistics(unsigned int associationID, short path_id, SCTP_PathStatistics* statistics)
+{
+    int result = SCTP_SUCCESS;
+    Association *assoc = NULL;
+
+    ENTER_LIBRARY("sctp_getPathStatistics");
+
+    CHECK_LIBRARY;
+
+    if (statistics == NULL) {
+        LEAVE_LIBRARY("sctp_getPathStatistics");
+        return SCTP_PARAMETER_PROBLEM;
+    }
+
+    assoc = retrieveAssociation(associationID);
+    if (assoc == NULL) {
+        error_logi(ERROR_MAJOR, "sctp_getPathStatistics : association %u does not exist", associationID);
+        result = SCTP_ASSOC_NOT_FOUND;
+    } else if (path_id < 0 || path_id >= assoc->noOfNetworks || path_id >= MAX_NUM_ADDRESSES) {
+        error_logii(ERROR_MINOR, "sctp_getPathStatistics : association %u has no path %d", associationID, path_id);
+        result = SCTP_PARAMETER_PROBLEM;
+    } else if (assoc->statistics == NULL) {
+        memset(statistics, 0, sizeof(SCTP_PathStatistics));
+    } else {
+        memcpy(statistics, &(assoc->statistics->path[path_id].counters), sizeof(SCTP_PathStatistics));
+    }
+    LEAVE_LIBRARY("sctp_getPathStatistics");
+    return result;
+}
+
+
+/**
+ * sctp_getRttHistogram returns the histogram of the raw RTT samples of a path.
+ *
+ *  @param  associationID   ID of assocation.
+ *  @param  path_id         index of the path
+ *  @param  histogram       pointer to a SCTP_LatencyHistogram structure to be filled
+ *  @return SCTP_SUCCESS, SCTP_PARAMETER_PROBLEM or SCTP_ASSOC_NOT_FOUND
+ */
+int sctp_getRttHistogram(unsigned int associationID, short path_id, SCTP_LatencyHistogram* histogram)
+{
+    int result = SCTP_SUCCESS;
+    Association *assoc = NULL;
+
+    ENTER_LIBRARY("sctp_getRttHistogram");
+
+    CHECK_LIBRARY;
+
+    if (histogram == NULL) {
+        LEAVE_LIBRARY("sctp_getRttHistogram");
+        return SCTP_PARAMETER_PROBLEM;
+    }
+
+    assoc = retrieveAssociation(associationID);
+    if (assoc == NULL) {
+        error_logi(ERROR_MAJOR, "sctp_getRttHistogram : association %u does not exist", associationID);
+        result = SCTP_ASSOC_NOT_FOUND;
+    } else if (path_id < 0 || path_id >= assoc->noOfNetworks || path_id >= MAX_NUM_ADDRESSES) {
+        error_logii(ERROR_MINOR, "sctp_getRttHistogram : association %u has no path %d", associationID, path_id);
+        result = SCTP_PARAMETER_PROBLEM;
+    } else {
+        mdi_copyHistogram(histogram, (assoc->statistics != NULL) ? assoc->statistics->rttHistogram[path_id] : NULL);
+    }
+    LEAVE_LIBRARY("sctp_getRttHistogram");
+    return result;
+}
+
+
+/**
+ * sctp_getAckLatencyHistogram returns the histogram of the send-to-ack latencies
+ * of the DATA chunks of an association.
+ *
+ *  @param  associationID   ID of assocation.
+ *  @param  histogram       pointer to a SCTP_LatencyHistogram structure to be filled
+ *  @return SCTP_SUCCESS, SCTP_PARAMETER_PROBLEM or SCTP_ASSOC_NOT_FOUND
+ */
+int sctp_getAckLatencyHistogram(unsigned int associationID, SCTP_LatencyHistogram* histogram)
+{
+    int result = SCTP_SUCCESS;
+    Association *assoc = NULL;
+
+    ENTER_LIBRARY("sctp_getAckLatencyHistogram");
+
+    CHECK_LIBRARY;
+
+    if (histogram == NULL) {
+        LEAVE_LIBRARY("sctp_getAckLatencyHistogram");
+        return SCTP_PARAMETER_PROBLEM;
+    }
+
+    assoc = retrieveAssociation(associationID);
+    if (assoc == NULL) {
+        error_logi(ERROR_MAJOR, "sctp_getAckLatencyHistogram : association %u does not exist", associationID);
+        result = SCTP_ASSOC_NOT_FOUND;
+    } else {
+        mdi_copyHistogram(histogram, (assoc->statistics != NULL) ? assoc->statistics->ackLatencyHistogram : NULL);
+    }
+    LEAVE_LIBRARY("sctp_getAckLatencyHistogram");
+    return result;
+}
+
+
+/**
+ * sctp_resetLatencyHistograms clears all latency histograms of an association.
+ *
+ *  @param  associationID   ID of assocation.
+ *  @return SCTP_SUCCESS or SCTP_ASSOC_NOT_FOUND
+ */
+int sctp_resetLatencyHistograms(unsigned int associationID)
+{
+    int i;
+    Association *assoc = NULL;
+
+    ENTER_LIBRARY("sctp_resetLatencyHistograms");
+
+    CHECK_LIBRARY;
+
+    assoc = retrieveAssociation(associationID);
+    if (assoc == NULL) {
+        error_logi(ERROR_MAJOR, "sctp_resetLatencyHistograms : association %u does not exist", associationID);
+        LEAVE_LIBRARY("sctp_resetLatencyHistograms");
+        return SCTP_ASSOC_NOT_FOUND;
+    }
+    if (assoc->statistics != NULL) {
+        for (i = 0; i < MAX_NUM_ADDRESSES; i++) {
+            if (assoc->statistics->rttHistogram[i] != NULL)
+                memset(assoc->statistics->rttHistogram[i], 0, sizeof(SCTP_LatencyHistogram));
+        }
+        if (assoc->statistics->ackLatencyHistogram != NULL)
+            memset(assoc->statistics->ackLatencyHistogram, 0, sizeof(SCTP_LatencyHistogram));
+    }
+    LEAVE_LIBRARY("sctp_resetLatencyHistograms");
+    return SCTP_SUCCESS;
+}
+
+
+/**
+ * sctp_getHistogramBucketLimit returns the upper limit of the value range of a histogram bucket.
+ *
+ *  @param  bucket    index of the bucket
+ *  @return largest value (in microseconds) that is counted in this bucket
+ */
+unsigned int sctp_getHistogramBucketLimit(unsigned int bucket)
+{
+    unsigned int msb, lower;
+
+    if (bucket < SCTP_HISTOGRAM_SUB_BUCKETS) return bucket;
+    if (bucket >= SCTP_HISTOGRAM_BUCKETS) return 0xFFFFFFFF;
+    msb = bucket / SCTP_HISTOGRAM_SUB_BUCKETS + 2;
+    lower = (SCTP_HISTOGRAM_SUB_BUCKETS + bucket % SCTP_HISTOGRAM_SUB_BUCKETS) << (msb - 3);
+    return lower + ((1u << (msb - 3)) - 1);
+}
+
+
+/**
+ * sctp_getHistogramPercentile estimates a percentile of the samples of a histogram.
+ *
+ *  @param  histogram   pointer to the histogram
+ *  @param  percentile  percentile between 0.0 and 100.0
+ *  @return upper limit (in microseconds) of the bucket that contains the percentile,
+ *          never larger than the largest sample; 0 for an empty histogram
+ */
+unsigned int sctp_getHistogramPercentile(const SCTP_LatencyHistogram* histogram, double percentile)
+{
+    unsigned int i;
+    double rank, seen = 0.0;
+
+    if (histogram == NULL || histogram->samples == 0) return 0;
+    if (percentile < 0.0) percentile = 0.0;
+    if (percentile > 100.0) percentile = 100.0;
+
+    rank = percentile / 100.0 * histogram->samples;
+    for (i = 0; i < SCTP_HISTOGRAM_BUCKETS; i++) {
+        seen += histogram->bucket[i];
+        if (histogram->bucket[i] > 0 && seen >= rank) {
+            return min(sctp_getHistogramBucketLimit(i), histogram->maximum);
+        }
+    }
+    return histogram->maximum;
+}
+
+
+/**
+ * sctp_setAssocStatus allows for setting a number of association parameters.
+ * _Not_ all values that the corresponding sctp_getAssocStatus-function returns
+ * may be SET here !
+ * Will set protocol parameters per SCTP association
+ *
+ *  @param  associationID   ID of assocation.
+ *  @param  new_status      pointer to new parameters
+ *  @return -1
+*/
+int sctp_setAssocStatus(unsigned int associationID, SCTP_AssociationStatus* new_status)
+{
+    guint16 result;
+    SCTP_instance *old_Instance = sctpInstance;
+    Association *old_assoc = currentAssociation;
+
+    ENTER_LIBRARY("sctp_setAssocStatus");
+
+    CHECK_LIBRARY;
+
+    if (new_status == NULL) {
+        LEAVE_LIBRARY("sctp_setAssocStatus");
+        return SCTP_PARAMETER_PROBLEM;
+    }
+    currentAssociation = retrieveAssociation(associationID);
+
+    if (currentAssociation != NULL) {
+        sctpInstance = currentAssociation->sctpInstance;
+        event_logi(VERBOSE, "sctp_setAssocStatus: Association %u", associationID);
+        if (pm_setPrimaryPath(new_status->primaryAddressIndex)) {
+            error_logi(ERROR_MINOR, "pm_setPrimary(%u) returned error", new_status->primaryAddressIndex);
+            sctpInstance = old_Instance;
+            currentAssociation = old_assoc;
+            LEAVE_LIBRARY("sctp_setAssocStatus");
             return SCTP_PARAMETER_PROBLEM;
         }
         if (pm_setRtoInitial(new_status->rtoInitial)) {
@@ -2790,12 +3815,37 @@ int sctp_setAssocStatus(unsigned int associationID, SCTP_AssociationStatus* new_
             LEAVE_LIBRARY("sctp_setAssocStatus");
             return SCTP_PARAMETER_PROBLEM;
         }
+        if (fc_set_congestionControl(new_status->congestionControl) != SCTP_SUCCESS) {
+            error_logi(ERROR_MINOR, "fc_set_congestionControl(%u) returned error", new_status->congestionControl);
+            sctpInstance = old_Instance;
+            currentAssociation = old_assoc;
+            LEAVE_LIBRARY("sctp_setAssocStatus");
+            return SCTP_PARAMETER_PROBLEM;
+        }
+        currentAssociation->congestionControl = new_status->congestionControl;
+        fc_set_pacingGain(new_status->pacingGain);
+        currentAssociation->pacingGain = new_status->pacingGain;
+        if (fc_set_streamScheduler(new_status->streamScheduler) != SCTP_SUCCESS) {
+            error_logi(ERROR_MINOR, "fc_set_streamScheduler(%u) returned error", new_status->streamScheduler);
+            sctpInstance = old_Instance;
+            currentAssociation = old_assoc;
+            LEAVE_LIBRARY("sctp_setAssocStatus");
+            return SCTP_PARAMETER_PROBLEM;
+        }
+        if (new_status->streamScheduler != currentAssociation->streamScheduler)
+            currentAssociation->streamSchedulerChosen = TRUE;
+        currentAssociation->streamScheduler = new_status->streamScheduler;
+        currentAssociation->concurrentMultipath = (new_status->concurrentMultipath != 0) ? TRUE : FALSE;
+        pm_setPathMTUDiscovery((new_status->pathMTUDiscovery != 0) ? TRUE : FALSE);
         sci_setCookieLifeTime(new_status->validCookieLife);
 
         sci_setMaxAssocRetransmissions(new_status->assocMaxRetransmits);
         sci_setMaxInitRetransmissions(new_status->maxInitRetransmits);
 
         rxc_set_local_receiver_window(new_status->myRwnd);
+        rxc_set_rwndAutotuning((new_status->rwndAutotuning != 0) ? TRUE : FALSE);
+        fc_set_corkDelay(new_status->corkDelay);
+        currentAssociation->coalesceDataArrivals = (new_status->coalesceDataArrivals != 0) ? TRUE : FALSE;
         rxc_set_sack_delay(new_status->delay);
         currentAssociation->ipTos = new_status->ipTos;
         result = fc_set_maxSendQueue(new_status->maxSendQueue);
@@ -2863,6 +3913,15 @@ int sctp_getAssocStatus(unsigned int associationID, SCTP_AssociationStatus* stat
         status->delay = rxc_get_sack_delay();
         result = fc_get_maxSendQueue(&(status->maxSendQueue));
         status->maxRecvQueue = 0;
+        fc_get_congestionControl(&(status->congestionControl));
+        fc_get_pacingGain(&(status->pacingGain));
+        fc_get_streamScheduler(&(status->streamScheduler));
+        status->concurrentMultipath = (currentAssociation->concurrentMultipath == TRUE) ? 1 : 0;
+        status->pathMTUDiscovery = (pm_getPathMTUDiscovery() == TRUE) ? 1 : 0;
+        status->rwndAutotuning = (rxc_get_rwndAutotuning() == TRUE) ? 1 : 0;
+        status->tunedRwnd = rxc_get_tuned_receiver_window();
+        fc_get_corkDelay(&(status->corkDelay));
+        status->coalesceDataArrivals = (currentAssociation->coalesceDataArrivals == TRUE) ? 1 : 0;
         status->ipTos = 0;
         result = SCTP_SUCCESS;
 
@@ -2910,6 +3969,16 @@ int sctp_setAssocDefaults(unsigned short SCTP_InstanceName, SCTP_InstanceParamet
         LEAVE_LIBRARY("sctp_setAssocDefaults");
         return SCTP_PARAMETER_PROBLEM;
     }
+    if (cc_getModule(params->congestionControl) == NULL) {
+        error_logi(ERROR_MINOR, "sctp_setAssocDefaults : unknown congestion control %u", params->congestionControl);
+        LEAVE_LIBRARY("sctp_setAssocDefaults");
+        return SCTP_PARAMETER_PROBLEM;
+    }
+    if (ss_getModule(params->streamScheduler) == NULL) {
+        error_logi(ERROR_MINOR, "sctp_setAssocDefaults : unknown stream scheduler %u", params->streamScheduler);
+        LEAVE_LIBRARY("sctp_setAssocDefaults");
+        return SCTP_PARAMETER_PROBLEM;
+    }
     instance->default_rtoInitial =  params->rtoInitial;
     instance->default_rtoMin = params->rtoMin;
     instance->default_rtoMax = params->rtoMax;
@@ -2922,6 +3991,16 @@ int sctp_setAssocDefaults(unsigned short SCTP_InstanceName, SCTP_InstanceParamet
     instance->default_ipTos = params->ipTos;
     instance->default_maxSendQueue = params->maxSendQueue;
     instance->default_maxRecvQueue = params->maxRecvQueue;
+    instance->default_congestionControl = params->congestionControl;
+    instance->default_pacingGain = params->pacingGain;
+    if (params->streamScheduler != instance->default_streamScheduler)
+        instance->default_streamSchedulerChosen = TRUE;
+    instance->default_streamScheduler = params->streamScheduler;
+    instance->default_concurrentMultipath = (params->concurrentMultipath != 0) ? TRUE : FALSE;
+    instance->default_pathMTUDiscovery = (params->pathMTUDiscovery != 0) ? TRUE : FALSE;
+    instance->default_rwndAutotuning = (params->rwndAutotuning != 0) ? TRUE : FALSE;
+    instance->default_corkDelay = params->corkDelay;
+    instance->default_coalesceDataArrivals = (params->coalesceDataArrivals != 0) ? TRUE : FALSE;
     instance->noOfInStreams = params->inStreams;
     instance->noOfOutStreams = params->outStreams;
     LEAVE_LIBRARY("sctp_setAssocDefaults");
@@ -2991,6 +4070,14 @@ int sctp_getAssocDefaults(unsigned short SCTP_InstanceName, SCTP_InstanceParamet
     params->ipTos = instance->default_ipTos ;
     params->maxSendQueue = instance->default_maxSendQueue;
     params->maxRecvQueue = instance->default_maxRecvQueue;
+    params->congestionControl = instance->default_congestionControl;
+    params->pacingGain = instance->default_pacingGain;
+    params->streamScheduler = instance->default_streamScheduler;
+    params->concurrentMultipath = (instance->default_concurrentMultipath == TRUE) ? 1 : 0;
+    params->pathMTUDiscovery = (instance->default_pathMTUDiscovery == TRUE) ? 1 : 0;
+    params->rwndAutotuning = (instance->default_rwndAutotuning == TRUE) ? 1 : 0;
+    params->corkDelay = instance->default_corkDelay;
+    params->coalesceDataArrivals = (instance->default_coalesceDataArrivals == TRUE) ? 1 : 0;
     params->inStreams = instance->noOfInStreams;
     params->outStreams = instance->noOfOutStreams;
 
@@ -3046,6 +4133,34 @@ int sctp_setLibraryParameters(SCTP_LibraryParameters *params)
         LEAVE_LIBRARY("sctp_setLibraryParameters");
         return SCTP_PARAMETER_PROBLEM;
     }
+    if (params->supportECN == 0) {
+        librarySupportsECN = FALSE;
+    } else if (params->supportECN == 1) {
+        librarySupportsECN = TRUE;
+    } else {
+        LEAVE_LIBRARY("sctp_setLibraryParameters");
+        return SCTP_PARAMETER_PROBLEM;
+    }
+    if (params->supportNRSACK == 0) {
+        librarySupportsNRSACK = FALSE;
+    } else if (params->supportNRSACK == 1) {
+        librarySupportsNRSACK = TRUE;
+    } else {
+        LEAVE_LIBRARY("sctp_setLibraryParameters");
+        return SCTP_PARAMETER_PROBLEM;
+    }
+    if (params->supportIDATA == 0) {
+        librarySupportsIDATA = FALSE;
+    } else if (params->supportIDATA == 1) {
+        librarySupportsIDATA = TRUE;
+    } else {
+        LEAVE_LIBRARY("sctp_setLibraryParameters");
+        return SCTP_PARAMETER_PROBLEM;
+    }
+    if (memoryBudget != params->memoryBudget) {
+        memoryBudget = params->memoryBudget;
+        mdi_checkMemoryPressure();
+    }
 
     event_logi(INTERNAL_EVENT_0, "sctp_setLibraryParameters: Set Parameter sendAbortForOOTB to %s",
                                   (sendAbortForOOTB==TRUE)?"TRUE":"FALSE");
@@ -3055,6 +4170,14 @@ int sctp_setLibraryParameters(SCTP_LibraryParameters *params)
                                   (params->supportPRSCTP==TRUE)?"ENABLED":"DISABLED");
     event_logi(INTERNAL_EVENT_0, "sctp_setLibraryParameters: Support of ADDIP is now %s",
                                   (params->supportADDIP==TRUE)?"ENABLED":"DISABLED");
+    event_logi(INTERNAL_EVENT_0, "sctp_setLibraryParameters: Support of ECN is now %s",
+                                  (params->supportECN==TRUE)?"ENABLED":"DISABLED");
+    event_logi(INTERNAL_EVENT_0, "sctp_setLibraryParameters: Support of NR-SACK is now %s",
+                                  (params->supportNRSACK==TRUE)?"ENABLED":"DISABLED");
+    event_logi(INTERNAL_EVENT_0, "sctp_setLibraryParameters: Support of I-DATA is now %s",
+                                  (params->supportIDATA==TRUE)?"ENABLED":"DISABLED");
+    event_logi(INTERNAL_EVENT_0, "sctp_setLibraryParameters: Memory budget is now %u bytes",
+                                  memoryBudget);
 
     LEAVE_LIBRARY("sctp_setLibraryParameters");
     return SCTP_SUCCESS;
@@ -3078,6 +4201,11 @@ int sctp_getLibraryParameters(SCTP_LibraryParameters *params)
     params->checksumAlgorithm = checksumAlgorithm;
     params->supportPRSCTP = (librarySupportsPRSCTP == TRUE) ? 1 : 0;
     params->supportADDIP = (supportADDIP == TRUE) ? 1 : 0;
+    params->supportECN = (librarySupportsECN == TRUE) ? 1 : 0;
+    params->supportNRSACK = (librarySupportsNRSACK == TRUE) ? 1 : 0;
+    params->supportIDATA = (librarySupportsIDATA == TRUE) ? 1 : 0;
+    params->memoryBudget = memoryBudget;
+    params->memoryInUse = memoryInUse;
     event_logi(INTERNAL_EVENT_0, "sctp_getLibraryParameters: Checksum Algorithm is currently %s",
                                   (checksumAlgorithm==SCTP_CHECKSUM_ALGORITHM_CRC32C)?"CRC32C":"ADLER32");
 
@@ -3412,6 +4540,54 @@ int sctp_extendedEventLoop(void (*lock)(void* data), void (*unlock)(void* data),
 }
 
 
+/**
+ * sctp_setEventLoopProfiling switches accounting of the event loop dispatch categories on or off
+ * @param  enable   TRUE to switch profiling on, FALSE to switch it off
+ * @return SCTP_SUCCESS
+ */
+int sctp_setEventLoopProfiling(int enable)
+{
+    ENTER_LIBRARY("sctp_setEventLoopProfiling");
+    CHECK_LIBRARY;
+    adl_setEventLoopProfiling(enable ? TRUE : FALSE);
+    LEAVE_LIBRARY("sctp_setEventLoopProfiling");
+    return SCTP_SUCCESS;
+}
+
+
+/**
+ * sctp_getEventLoopProfile returns the time spent per dispatch category of the event loop
+ * @param  profile  pointer to the structure to be filled in
+ * @return SCTP_SUCCESS, or SCTP_PARAMETER_PROBLEM if profile is NULL
+ */
+int sctp_getEventLoopProfile(SCTP_EventLoopProfile* profile)
+{
+    ENTER_LIBRARY("sctp_getEventLoopProfile");
+    CHECK_LIBRARY;
+    if (profile == NULL) {
+        LEAVE_LIBRARY("sctp_getEventLoopProfile");
+        return SCTP_PARAMETER_PROBLEM;
+    }
+    adl_getEventLoopProfile(profile);
+    LEAVE_LIBRARY("sctp_getEventLoopProfile");
+    return SCTP_SUCCESS;
+}
+
+
+/**
+ * sctp_resetEventLoopProfile clears all counters of the event loop profile
+ * @return SCTP_SUCCESS
+ */
+int sctp_resetEventLoopProfile(void)
+{
+    ENTER_LIBRARY("sctp_resetEventLoopProfile");
+    CHECK_LIBRARY;
+    adl_resetEventLoopProfile();
+    LEAVE_LIBRARY("sctp_resetEventLoopProfile");
+    return SCTP_SUCCESS;
+}
+
+
 #ifdef BAKEOFF
 int sctp_sendRawData(unsigned int associationID, short path_id,
                      unsigned char *buffer, unsigned int length)
@@ -3479,8 +4655,11 @@ int mdi_send_message(SCTP_message * message, unsigned int length, short destAddr
     SCTP_simple_chunk *chunk;
     unsigned char tos = 0;
     unsigned short dIdx;
+    short pathIndex = -1;
     int txmit_len = 0;
     guchar hoststring[SCTP_MAX_IP_LEN];
+    SCTP_AssociationStatistics* stats;
+    SCTP_PathStatistics* pathStats;
 
 
     if (message == NULL) {
@@ -3526,6 +4705,7 @@ int mdi_send_message(SCTP_message * message, unsigned int length, short destAddr
         if (destAddressIndex != -1) {
             /* Use given destination address from current association */
             dest_ptr = &(currentAssociation->destinationAddresses[destAddressIndex]);
+            pathIndex = destAddressIndex;
         } else { /* use last from address */
             if (lastFromAddress == NULL) {
                 dIdx = pm_readPrimaryPath();
@@ -3537,10 +4717,12 @@ int mdi_send_message(SCTP_message * message, unsigned int length, short destAddr
                     return 1;
                 }
                 dest_ptr = &(currentAssociation->destinationAddresses[dIdx]);
+                pathIndex = (short)dIdx;
             } else {
                 event_log(VVERBOSE,  "mdi_send_message : last From Address was not NULL");
                 memcpy(&dest_su, lastFromAddress, sizeof(union sockunion));
                 dest_ptr = &dest_su;
+                pathIndex = lastFromPath;
             }
         }
 
@@ -3568,6 +4750,9 @@ int mdi_send_message(SCTP_message * message, unsigned int length, short destAddr
                      ntohl(message->common_header.verification_tag),
                      currentAssociation->localPort, currentAssociation->remotePort);
         tos = currentAssociation->ipTos;
+        /* ECN capable transport, once both sides agreed on it (RFC 4960, appendix A) */
+        if (currentAssociation->supportsECN && currentAssociation->peerSupportsECN)
+            tos = (tos & ~IPTOS_ECN_MASK) | IPTOS_ECN_ECT0;
     }
 
     /* calculate and insert checksum */
@@ -3587,6 +4772,16 @@ int mdi_send_message(SCTP_message * message, unsigned int length, short destAddr
         break;
     }
 
+    if (txmit_len == (int)length) {
+        stats = mdi_readStatistics();
+        stats->packetsSent++;
+        stats->bytesSent += length;
+        if ((pathStats = mdi_readPathStatistics(pathIndex)) != NULL) {
+            pathStats->packetsSent++;
+            pathStats->bytesSent += length;
+        }
+    }
+
     adl_sockunion2str(dest_ptr, hoststring, SCTP_MAX_IP_LEN);
     event_logiii(INTERNAL_EVENT_0, "sent SCTP message of %d bytes to %s, result was %d",
                     length, hoststring, txmit_len);
@@ -3611,7 +4806,7 @@ int mdi_send_message(SCTP_message * message, unsigned int length, short destAddr
 void mdi_dataArriveNotif(unsigned short streamID, unsigned int length, unsigned short streamSN,
                          unsigned int tsn, unsigned int protoID, unsigned int unordered)
 {
-
+    SCTP_Event event;
     SCTP_instance *old_Instance = sctpInstance;
     Association *old_assoc = currentAssociation;
 
@@ -3619,8 +4814,21 @@ void mdi_dataArriveNotif(unsigned short streamID, unsigned int length, unsigned
 
         event_logiiii(INTERNAL_EVENT_0, "mdi_dataArriveNotif(assoc %u, streamID %u, length %u, tsn %u)",
                currentAssociation->assocId, streamID,  length, tsn);
-        /* Forward dataArriveNotif to the ULP */
-        if (sctpInstance->ULPcallbackFunctions.dataArriveNotif) {
+        if (sctpInstance->eventQueue != NULL) {
+            memset(&event, 0, sizeof(event));
+            event.param[0] = streamID;
+            event.param[1] = length;
+            event.param[2] = streamSN;
+            event.param[3] = tsn;
+            event.param[4] = protoID;
+            event.param[5] = unordered;
+            mdi_queueEvent(&event, SCTP_EVENT_DATA_ARRIVE);
+        } else if (currentAssociation->coalesceDataArrivals == TRUE &&
+            sctpInstance->ULPcallbackFunctions.dataArriveBatchNotif != NULL) {
+            /* the ULP is notified after the current event, see mdi_deliverDataArrivals() */
+            mdi_queueDataArrival(currentAssociation, streamID);
+        } else if (sctpInstance->ULPcallbackFunctions.dataArriveNotif) {
+            /* Forward dataArriveNotif to the ULP */
             ENTER_CALLBACK("dataArriveNotif");
             sctpInstance->ULPcallbackFunctions.dataArriveNotif(currentAssociation->assocId,
                                                                streamID,
@@ -3640,6 +4848,137 @@ void mdi_dataArriveNotif(unsigned short streamID, unsigned int length, unsigned
 }                               /* end: mdi_dataArriveNotif */
 
 
+/**
+ * writes an event record of the current association into the completion queue
+ * of the current instance
+ *  @param event  record with the parameters of the event
+ *  @param type   SCTP_EVENT_xxx
+ */
+static void mdi_queueEvent(SCTP_Event* event, unsigned int type)
+{
+    event->type = type;
+    event->associationID = currentAssociation->assocId;
+    event->ulpData = currentAssociation->ulp_dataptr;
+    if (eq_put(sctpInstance->eventQueue, event) == FALSE) {
+        event_logii(VERBOSE, "completion queue of instance %u full, event %u dropped",
+                    sctpInstance->sctpInstanceName, type);
+    }
+}
+
+
+/**
+ * counts a message, that arrived on an association with coalesced data arrivals,
+ * and puts the association into the list of pending notifications
+ *  @param assoc     association, on which the message arrived
+ *  @param streamID  received data belongs to this stream
+ */
+static void mdi_queueDataArrival(Association* assoc, unsigned short streamID)
+{
+    unsigned int* counts;
+    unsigned int streams;
+
+    if (streamID >= assoc->arrivedStreams) {
+        streams = max(se_numOfRecvStreams(), (unsigned int)streamID + 1);
+        counts = (unsigned int*)realloc(assoc->arrivedMessages, streams * sizeof(unsigned int));
+        if (counts == NULL) error_log(ERROR_FATAL, "Malloc failed");
+        memset(&counts[assoc->arrivedStreams], 0, (streams - assoc->arrivedStreams) * sizeof(unsigned int));
+        assoc->arrivedMessages = counts;
+        assoc->arrivedStreams = streams;
+    }
+    assoc->arrivedMessages[streamID]++;
+    if (assoc->arrivalsPending == FALSE) {
+        PendingArrivals = g_list_append(PendingArrivals, GUINT_TO_POINTER(assoc->assocId));
+        assoc->arrivalsPending = TRUE;
+    }
+}
+
+
+/**
+ * calls the dataArriveBatchNotif callback for all associations, on which messages arrived
+ * since the last call, with the number of messages per stream. Called by the event loop
+ * after the received packets have been processed.
+ */
+void mdi_deliverDataArrivals(void)
+{
+    GList* pending;
+    Association* assoc;
+    unsigned int assocId;
+    SCTP_instance *old_Instance = sctpInstance;
+    Association *old_assoc = currentAssociation;
+
+    while (PendingArrivals != NULL) {
+        pending = PendingArrivals;
+        PendingArrivals = g_list_remove_link(PendingArrivals, pending);
+        assocId = GPOINTER_TO_UINT(pending->data);
+        g_list_free_1(pending);
+
+        /* data of an association may still be read, while it is being shut down */
+        assoc = retrieveAssociationForced(assocId);
+        if (assoc == NULL) continue;
+        assoc->arrivalsPending = FALSE;
+        currentAssociation = assoc;
+        sctpInstance = assoc->sctpInstance;
+
+        event_logii(INTERNAL_EVENT_0, "mdi_deliverDataArrivals(assoc %u, %u streams)",
+                    assocId, assoc->arrivedStreams);
+        if (sctpInstance->ULPcallbackFunctions.dataArriveBatchNotif) {
+            ENTER_CALLBACK("dataArriveBatchNotif");
+            sctpInstance->ULPcallbackFunctions.dataArriveBatchNotif(assocId,
+                                                                    assoc->arrivedStreams,
+                                                                    assoc->arrivedMessages,
+                                                                    assoc->ulp_dataptr);
+            LEAVE_CALLBACK("dataArriveBatchNotif");
+        }
+        /* the ULP may have removed the association in the callback */
+        assoc = retrieveAssociationForced(assocId);
+        if (assoc != NULL && assoc->arrivalsPending == FALSE)
+            memset(assoc->arrivedMessages, 0, assoc->arrivedStreams * sizeof(unsigned int));
+    }
+    sctpInstance = old_Instance;
+    currentAssociation = old_assoc;
+}
+
+
+/**
+ * calls the queueStatusChangeNotif callback (SCTP_MEMORY_QUEUE) for all associations,
+ * for which memory pressure started or ended since the last call. Called by the event
+ * loop after an event has been processed, so that the ULP may use the library.
+ */
+void mdi_deliverMemoryPressure(void)
+{
+    GList* pending = NULL;
+    GList* tmp;
+    Association* assoc;
+    unsigned int assocId;
+    SCTP_instance *old_Instance = sctpInstance;
+    Association *old_assoc = currentAssociation;
+
+    if (memoryPressureChanged == FALSE) return;
+    memoryPressureChanged = FALSE;
+
+    /* the ULP may add or remove associations in the callback */
+    for (tmp = g_list_first(AssociationList); tmp != NULL; tmp = g_list_next(tmp)) {
+        assoc = (Association *)tmp->data;
+        if (assoc->memoryPressurePending == FALSE) continue;
+        assoc->memoryPressurePending = FALSE;
+        if (assoc->deleted) continue;
+        pending = g_list_append(pending, GUINT_TO_POINTER(assoc->assocId));
+    }
+    for (tmp = pending; tmp != NULL; tmp = g_list_next(tmp)) {
+        assocId = GPOINTER_TO_UINT(tmp->data);
+        assoc = retrieveAssociation(assocId);
+        if (assoc == NULL) continue;
+        currentAssociation = assoc;
+        sctpInstance = assoc->sctpInstance;
+        mdi_queueStatusChangeNotif(SCTP_MEMORY_QUEUE, (assoc->memoryPressureNotified == TRUE) ? 1 : 0,
+                                   (int)assoc->memoryInUse);
+    }
+    g_list_free(pending);
+    sctpInstance = old_Instance;
+    currentAssociation = old_assoc;
+}
+
+
 
 /**
  * indicates a change of network status (chapter 10.2.C). Calls the respective ULP callback function.
@@ -3648,13 +4987,19 @@ void mdi_dataArriveNotif(unsigned short streamID, unsigned int length, unsigned
  */
 void mdi_networkStatusChangeNotif(short destinationAddress, unsigned short newState)
 {
+    SCTP_Event event;
     SCTP_instance *old_Instance = sctpInstance;
     Association *old_assoc = currentAssociation;
     if (currentAssociation != NULL) {
 
         event_logiii(INTERNAL_EVENT_0, "mdi_networkStatusChangeNotif(assoc %u, path-id %d, state %u)",
                currentAssociation->assocId, destinationAddress,newState);
-        if (sctpInstance->ULPcallbackFunctions.networkStatusChangeNotif) {
+        if (sctpInstance->eventQueue != NULL) {
+            memset(&event, 0, sizeof(event));
+            event.param[0] = (unsigned int)destinationAddress;
+            event.param[1] = newState;
+            mdi_queueEvent(&event, SCTP_EVENT_NETWORK_STATUS_CHANGE);
+        } else if (sctpInstance->ULPcallbackFunctions.networkStatusChangeNotif) {
             ENTER_CALLBACK("networkStatusChangeNotif");
             sctpInstance->ULPcallbackFunctions.networkStatusChangeNotif(currentAssociation->assocId,
                                                                         destinationAddress, newState,
@@ -3678,10 +5023,17 @@ void mdi_networkStatusChangeNotif(short destinationAddress, unsigned short newSt
  */
 void mdi_sendFailureNotif(unsigned char *data, unsigned int dataLength, unsigned int *context)
 {
+    SCTP_Event event;
     SCTP_instance *old_Instance = sctpInstance;
     Association *old_assoc = currentAssociation;
     if (currentAssociation != NULL) {
-        if(sctpInstance->ULPcallbackFunctions.sendFailureNotif) {
+        if (sctpInstance->eventQueue != NULL) {
+            /* the data itself is only valid during the call */
+            memset(&event, 0, sizeof(event));
+            event.param[0] = dataLength;
+            event.context = context;
+            mdi_queueEvent(&event, SCTP_EVENT_SEND_FAILURE);
+        } else if(sctpInstance->ULPcallbackFunctions.sendFailureNotif) {
             ENTER_CALLBACK("sendFailureNotif");
             sctpInstance->ULPcallbackFunctions.sendFailureNotif(currentAssociation->assocId,
                                                                 data, dataLength, context,
@@ -3702,12 +5054,16 @@ void mdi_sendFailureNotif(unsigned char *data, unsigned int dataLength, unsigned
  */
 void mdi_peerShutdownReceivedNotif(void)
 {
+    SCTP_Event event;
     SCTP_instance *old_Instance = sctpInstance;
     Association *old_assoc = currentAssociation;
     if (currentAssociation != NULL) {
 
         event_logi(INTERNAL_EVENT_0, "mdi_peerShutdownReceivedNotif(assoc %u)", currentAssociation->assocId);
-        if(sctpInstance->ULPcallbackFunctions.peerShutdownReceivedNotif) {
+        if (sctpInstance->eventQueue != NULL) {
+            memset(&event, 0, sizeof(event));
+            mdi_queueEvent(&event, SCTP_EVENT_PEER_SHUTDOWN_RECEIVED);
+        } else if(sctpInstance->ULPcallbackFunctions.peerShutdownReceivedNotif) {
             ENTER_CALLBACK("shutdownCompleteNotif");
             sctpInstance->ULPcallbackFunctions.peerShutdownReceivedNotif(currentAssociation->assocId,
                                                                          currentAssociation->ulp_dataptr);
@@ -3727,12 +5083,16 @@ void mdi_peerShutdownReceivedNotif(void)
  */
 void mdi_shutdownCompleteNotif(void)
 {
+    SCTP_Event event;
     SCTP_instance *old_Instance = sctpInstance;
     Association *old_assoc = currentAssociation;
     if (currentAssociation != NULL) {
 
         event_logi(INTERNAL_EVENT_0, "mdi_shutdownCompleteNotif(assoc %u)", currentAssociation->assocId);
-        if(sctpInstance->ULPcallbackFunctions.shutdownCompleteNotif) {
+        if (sctpInstance->eventQueue != NULL) {
+            memset(&event, 0, sizeof(event));
+            mdi_queueEvent(&event, SCTP_EVENT_SHUTDOWN_COMPLETE);
+        } else if(sctpInstance->ULPcallbackFunctions.shutdownCompleteNotif) {
             ENTER_CALLBACK("shutdownCompleteNotif");
             sctpInstance->ULPcallbackFunctions.shutdownCompleteNotif(currentAssociation->assocId,
                                                                      currentAssociation->ulp_dataptr);
@@ -3752,13 +5112,17 @@ void mdi_shutdownCompleteNotif(void)
  */
 void mdi_restartNotif(void)
 {
+    SCTP_Event event;
     SCTP_instance *old_Instance = sctpInstance;
     Association *old_assoc = currentAssociation;
     if (currentAssociation != NULL) {
 
         event_logi(INTERNAL_EVENT_0, "mdi_restartNotif(assoc %u)", currentAssociation->assocId);
 
-        if(sctpInstance->ULPcallbackFunctions.restartNotif) {
+        if (sctpInstance->eventQueue != NULL) {
+            memset(&event, 0, sizeof(event));
+            mdi_queueEvent(&event, SCTP_EVENT_RESTART);
+        } else if(sctpInstance->ULPcallbackFunctions.restartNotif) {
             ENTER_CALLBACK("restartNotif");
             sctpInstance->ULPcallbackFunctions.restartNotif(currentAssociation->assocId,
                                                             currentAssociation->ulp_dataptr);
@@ -3780,6 +5144,7 @@ void mdi_restartNotif(void)
  */
 void mdi_communicationLostNotif(unsigned short status)
 {
+    SCTP_Event event;
     SCTP_instance *old_Instance = sctpInstance;
     Association *old_assoc = currentAssociation;
 
@@ -3787,7 +5152,11 @@ void mdi_communicationLostNotif(unsigned short status)
 
         event_logii(INTERNAL_EVENT_0, "mdi_communicationLostNotif(assoc %u, status %u)",
             currentAssociation->assocId, status);
-        if(sctpInstance->ULPcallbackFunctions.communicationLostNotif) {
+        if (sctpInstance->eventQueue != NULL) {
+            memset(&event, 0, sizeof(event));
+            event.param[0] = status;
+            mdi_queueEvent(&event, SCTP_EVENT_COMMUNICATION_LOST);
+        } else if(sctpInstance->ULPcallbackFunctions.communicationLostNotif) {
             ENTER_CALLBACK("communicationLostNotif");
             sctpInstance->ULPcallbackFunctions.communicationLostNotif(currentAssociation->assocId,
                                                                       status,
@@ -3817,6 +5186,7 @@ void mdi_communicationUpNotif(unsigned short status)
     short primaryPath;
     unsigned short noOfInStreams;
     unsigned short noOfOutStreams;
+    SCTP_Event event;
     SCTP_instance *old_Instance = sctpInstance;
     Association *old_assoc = currentAssociation;
 
@@ -3850,7 +5220,21 @@ void mdi_communicationUpNotif(unsigned short status)
         /* FIXME (???) : retreive sctp-instance from list */
 
         /* Forward mdi_communicationup Notification to the ULP */
-        if(sctpInstance->ULPcallbackFunctions.communicationUpNotif) {
+        if (sctpInstance->eventQueue != NULL) {
+            /* the ULP data is the one given to sctp_associate() */
+            memset(&event, 0, sizeof(event));
+            event.param[0] = status;
+            event.param[1] = currentAssociation->noOfNetworks;
+            event.param[2] = noOfInStreams;
+            event.param[3] = noOfOutStreams;
+            event.param[4] = currentAssociation->supportsPRSCTP;
+            mdi_queueEvent(&event, SCTP_EVENT_COMMUNICATION_UP);
+            for (pathNum = 0; pathNum < currentAssociation->noOfNetworks; pathNum++) {
+                if (pm_readState((short)pathNum) == PM_ACTIVE) {
+                    mdi_networkStatusChangeNotif((short)pathNum, PM_ACTIVE);
+                }
+            }
+        } else if(sctpInstance->ULPcallbackFunctions.communicationUpNotif) {
             ENTER_CALLBACK("communicationUpNotif");
             currentAssociation->ulp_dataptr = sctpInstance->ULPcallbackFunctions.communicationUpNotif(
                                                                 currentAssociation->assocId,
@@ -3889,6 +5273,7 @@ void mdi_communicationUpNotif(unsigned short status)
  */
 void mdi_queueStatusChangeNotif(int queueType, int queueId, int queueLen)
 {
+    SCTP_Event event;
     SCTP_instance *old_Instance = sctpInstance;
     Association *old_assoc = currentAssociation;
 
@@ -3896,7 +5281,13 @@ void mdi_queueStatusChangeNotif(int queueType, int queueId, int queueLen)
 
         event_logiiii(INTERNAL_EVENT_0, "mdi_queueStatusChangeNotif(assoc %u, queueType %d, queueId %d, len: %d)",
             currentAssociation->assocId, queueType,queueId,queueLen);
-        if (sctpInstance->ULPcallbackFunctions.queueStatusChangeNotif) {
+        if (sctpInstance->eventQueue != NULL) {
+            memset(&event, 0, sizeof(event));
+            event.param[0] = (unsigned int)queueType;
+            event.param[1] = (unsigned int)queueId;
+            event.param[2] = (unsigned int)queueLen;
+            mdi_queueEvent(&event, SCTP_EVENT_QUEUE_STATUS_CHANGE);
+        } else if (sctpInstance->ULPcallbackFunctions.queueStatusChangeNotif) {
             ENTER_CALLBACK("queueStatusChangeNotif");
             sctpInstance->ULPcallbackFunctions.queueStatusChangeNotif(currentAssociation->assocId,
                                                                       queueType, queueId, queueLen,
@@ -3911,6 +5302,123 @@ void mdi_queueStatusChangeNotif(int queueType, int queueId, int queueLen)
 }                               /* end: mdi_queueStatusChangeNotif */
 
 
+/*------------------- Functions for the library-wide memory budget -------------------------------*/
+
+/**
+ * mdi_chargeMemory accounts for user data that the current association has queued
+ * (in its send queue or in the stream engine), and checks for memory pressure
+ * @param  bytes     number of bytes that have been queued
+ */
+void mdi_chargeMemory(unsigned int bytes)
+{
+    if (currentAssociation == NULL) {
+        error_log(ERROR_MAJOR, "mdi_chargeMemory: association not set");
+        return;
+    }
+    currentAssociation->memoryInUse += bytes;
+    memoryInUse += bytes;
+    if (memoryBudget != 0) mdi_checkMemoryPressure();
+}
+
+
+/**
+ * mdi_releaseMemory is called when the current association frees queued user data
+ * @param  bytes     number of bytes that have been freed
+ */
+void mdi_releaseMemory(unsigned int bytes)
+{
+    if (currentAssociation == NULL) {
+        error_log(ERROR_MAJOR, "mdi_releaseMemory: association not set");
+        return;
+    }
+    if (bytes > currentAssociation->memoryInUse) bytes = currentAssociation->memoryInUse;
+    currentAssociation->memoryInUse -= bytes;
+    memoryInUse -= bytes;
+    if (memoryPressure == TRUE) mdi_checkMemoryPressure();
+}
+
+
+/**
+ * mdi_memoryAvailable is called before a new message is queued for sending. No new
+ * messages are accepted under memory pressure, so that there is memory left for
+ * the data we receive.
+ * @param  bytes     size of the message
+ * @return TRUE if the message may be queued, else FALSE
+ */
+gboolean mdi_memoryAvailable(unsigned int bytes)
+{
+    if (memoryBudget == 0) return TRUE;
+    if (memoryPressure == TRUE || memoryInUse >= memoryBudget) return FALSE;
+    return (bytes <= memoryBudget - memoryInUse) ? TRUE : FALSE;
+}
+
+
+/**
+ * mdi_limitReceiverWindow shrinks the receiver window under memory pressure,
+ * so that peers can not send more than what is left of the memory budget
+ * @param  rwnd      receiver window that the association would advertise
+ * @return receiver window that may be advertised
+ */
+unsigned int mdi_limitReceiverWindow(unsigned int rwnd)
+{
+    if (memoryPressure == FALSE) return rwnd;
+    if (memoryInUse >= memoryBudget) return 0;
+    return min(rwnd, memoryBudget - memoryInUse);
+}
+
+
+/**
+ * mdi_readStatistics returns the counters that the modules increment for the
+ * current association. Packets that do not belong to an association are counted
+ * in a library wide block.
+ * @return pointer to the statistics counters, never NULL
+ */
+SCTP_AssociationStatistics* mdi_readStatistics(void)
+{
+    if (currentAssociation == NULL || currentAssociation->statistics == NULL) {
+        return &(unassignedStatistics.counters);
+    }
+    return &(currentAssociation->statistics->assoc.counters);
+}
+
+
+/**
+ * mdi_readPathStatistics returns the counters of a path of the current association
+ * @param  pathID    index of the path
+ * @return pointer to the statistics counters, or NULL if there are none
+ */
+SCTP_PathStatistics* mdi_readPathStatistics(short pathID)
+{
+    if (currentAssociation == NULL || currentAssociation->statistics == NULL) return NULL;
+    if (pathID < 0 || pathID >= currentAssociation->noOfNetworks || pathID >= MAX_NUM_ADDRESSES) return NULL;
+    return &(currentAssociation->statistics->path[pathID].counters);
+}
+
+
+/**
+ * mdi_recordRttSample adds a raw RTT sample to the histogram of a path
+ * @param  pathID    index of the path
+ * @param  usecs     RTT sample in microseconds
+ */
+void mdi_recordRttSample(short pathID, unsigned int usecs)
+{
+    if (currentAssociation == NULL || currentAssociation->statistics == NULL) return;
+    if (pathID < 0 || pathID >= currentAssociation->noOfNetworks || pathID >= MAX_NUM_ADDRESSES) return;
+    mdi_recordHistogram(&(currentAssociation->statistics->rttHistogram[pathID]), usecs);
+}
+
+
+/**
+ * mdi_recordAckLatency adds the send-to-ack latency of a chunk to the association histogram
+ * @param  usecs     latency in microseconds
+ */
+void mdi_recordAckLatency(unsigned int usecs)
+{
+    if (currentAssociation == NULL || currentAssociation->statistics == NULL) return;
+    mdi_recordHistogram(&(currentAssociation->statistics->ackLatencyHistogram), usecs);
+}
+
+
 /*------------------- Functions called by the SCTP to get current association data----------------*/
 
 /* When processing external events from outside the SCTP (socket events, timer events and
@@ -4554,6 +6062,15 @@ gboolean mdi_supportsPRSCTP(void)
     return (librarySupportsPRSCTP);
 }
 
+/**
+ * @return TRUE, if the current association spreads new data over all active paths
+ */
+gboolean mdi_usesCMT(void)
+{
+    if (currentAssociation == NULL) return FALSE;
+    return currentAssociation->concurrentMultipath;
+}
+
 gboolean mdi_peerSupportsPRSCTP(void)
 {
     if (currentAssociation == NULL)
@@ -4561,6 +6078,76 @@ gboolean mdi_peerSupportsPRSCTP(void)
     return currentAssociation->peerSupportsPRSCTP;
 }
 
+/**
+ * @return TRUE, if ECN is used in the current association, or (without an association)
+ *         if the current instance offers it in its INIT/INIT ACK chunks
+ */
+gboolean mdi_supportsECN(void)
+{
+    if (currentAssociation != NULL) {
+        return  (currentAssociation->supportsECN && currentAssociation->peerSupportsECN);
+    }
+    if (sctpInstance != NULL) {
+        return   sctpInstance->supportsECN;
+    }
+    return (librarySupportsECN);
+}
+
+/**
+ * @return TRUE, if NR-SACKs are used in the current association, or (without an
+ *         association) if the current instance offers them in its INIT/INIT ACK chunks
+ */
+gboolean mdi_supportsNRSACK(void)
+{
+    if (currentAssociation != NULL) {
+        return  (currentAssociation->supportsNRSACK && currentAssociation->peerSupportsNRSACK);
+    }
+    if (sctpInstance != NULL) {
+        return   sctpInstance->supportsNRSACK;
+    }
+    return (librarySupportsNRSACK);
+}
+
+/**
+ * @return TRUE, if user data is sent in I-DATA chunks in the current association, or
+ *         (without an association) if the current instance offers them in its INIT/INIT ACK chunks
+ */
+gboolean mdi_supportsIDATA(void)
+{
+    if (currentAssociation != NULL) {
+        return  (currentAssociation->supportsIDATA && currentAssociation->peerSupportsIDATA);
+    }
+    if (sctpInstance != NULL) {
+        return   sctpInstance->supportsIDATA;
+    }
+    return (librarySupportsIDATA);
+}
+
+/**
+ * @return TRUE, if the current association, or (without an association) the current
+ *         instance offers I-DATA chunks in its INIT/INIT ACK chunks
+ */
+gboolean mdi_offersIDATA(void)
+{
+    if (currentAssociation != NULL) {
+        return  currentAssociation->supportsIDATA;
+    }
+    if (sctpInstance != NULL) {
+        return   sctpInstance->supportsIDATA;
+    }
+    return (librarySupportsIDATA);
+}
+
+/**
+ * @return TRUE, if the packet that is currently being processed was marked CE
+ *         by a router, and ECN is used in the current association
+ */
+gboolean mdi_congestionExperienced(void)
+{
+    if (currentAssociation == NULL) return FALSE;
+    return (lastCongestionExperienced && mdi_supportsECN());
+}
+
 
 int mdi_getDefaultRtoInitial(void* sctpInstance)
 {
@@ -4600,6 +6187,34 @@ int mdi_getDefaultMyRwnd()
         return ((SCTP_instance*)sctpInstance)->default_myRwnd;
     }
 }
+/**
+ * @return the receiver window advertised in INIT and INIT ACK chunks : with autotuning,
+ * new associations start with a small window, that grows when it is used
+ */
+unsigned int mdi_getInitialMyRwnd(void)
+{
+    if (sctpInstance == NULL) return 0;
+    if (sctpInstance->default_rwndAutotuning == FALSE) return sctpInstance->default_myRwnd;
+    return (sctpInstance->default_myRwnd < DEFAULT_INITIAL_RWND) ?
+            sctpInstance->default_myRwnd : DEFAULT_INITIAL_RWND;
+}
+
+gboolean mdi_getDefaultRwndAutotuning(void* sctpInstance)
+{
+    if (sctpInstance == NULL) return FALSE;
+    else
+        return ((SCTP_instance*)sctpInstance)->default_rwndAutotuning;
+}
+
+/**
+ * @return the cork delay of new associations of the current instance, in msecs
+ */
+unsigned int mdi_getDefaultCorkDelay(void)
+{
+    if (sctpInstance == NULL) return DEFAULT_CORK_DELAY;
+    return sctpInstance->default_corkDelay;
+}
+
 int mdi_getDefaultRtoMin(void* sctpInstance)
 {
     if (sctpInstance == NULL) return -1;
@@ -4614,6 +6229,21 @@ int mdi_getDefaultRtoMax(void* sctpInstance)
         return ((SCTP_instance*)sctpInstance)->default_rtoMax;
 }
 
+gboolean mdi_getDefaultPathMTUDiscovery(void* sctpInstance)
+{
+    if (sctpInstance == NULL) return FALSE;
+    else
+        return ((SCTP_instance*)sctpInstance)->default_pathMTUDiscovery;
+}
+
+/**
+ * @return the largest MTU of the local interfaces, the limit of path MTU discovery
+ */
+unsigned int mdi_readLocalMaxMTU(void)
+{
+    return (myMaxMTU > 0) ? (unsigned int)myMaxMTU : DEFAULT_MTU_SIZE;
+}
+
 int mdi_getDefaultMaxBurst(void)
 {
     if (sctpInstance == NULL) return DEFAULT_MAX_BURST;
@@ -4785,6 +6415,22 @@ mdi_newAssociation(void*  sInstance,
     currentAssociation->ulp_dataptr = NULL;
     currentAssociation->ipTos = instance->default_ipTos;
     currentAssociation->maxSendQueue = instance->default_maxSendQueue;
+    currentAssociation->congestionControl = instance->default_congestionControl;
+    currentAssociation->pacingGain = instance->default_pacingGain;
+    currentAssociation->streamScheduler = instance->default_streamScheduler;
+    currentAssociation->streamSchedulerChosen = instance->default_streamSchedulerChosen;
+    currentAssociation->concurrentMultipath = instance->default_concurrentMultipath;
+    currentAssociation->coalesceDataArrivals = instance->default_coalesceDataArrivals;
+    currentAssociation->arrivedMessages = NULL;
+    currentAssociation->arrivedStreams = 0;
+    currentAssociation->arrivalsPending = FALSE;
+    currentAssociation->memoryInUse = 0;
+    currentAssociation->memoryPressureNotified = FALSE;
+    currentAssociation->memoryPressurePending = FALSE;
+    currentAssociation->statistics = mdi_allocStatistics();
+    if (currentAssociation->statistics == NULL) {
+        error_log(ERROR_MAJOR, "mdi_newAssociation: could not allocate statistics counters");
+    }
 
     result = mdi_updateMyAddressList();
     if (result != SCTP_SUCCESS) {
@@ -4867,6 +6513,16 @@ mdi_newAssociation(void*  sInstance,
     currentAssociation->supportsADDIP = FALSE;
     currentAssociation->peerSupportsADDIP = FALSE;
 
+    currentAssociation->supportsECN = instance->supportsECN;
+    currentAssociation->peerSupportsECN = instance->supportsECN;
+
+    currentAssociation->supportsNRSACK = instance->supportsNRSACK;
+    currentAssociation->peerSupportsNRSACK = instance->supportsNRSACK;
+
+    /* DATA or I-DATA is only decided, when the peer's INIT or INIT ACK has arrived */
+    currentAssociation->supportsIDATA = instance->supportsIDATA;
+    currentAssociation->peerSupportsIDATA = FALSE;
+
 
     event_logii(INTERNAL_EVENT_1, "new Association created ID=%08x, local tag=%08x",
         currentAssociation->assocId, currentAssociation->tagLocal);
@@ -4880,6 +6536,21 @@ mdi_newAssociation(void*  sInstance,
 }                               /* end: mdi_newAssociation */
 
 
+/*
+ * Helper function that picks the stream scheduler after the extensions have been negotiated :
+ * fragments of I-DATA messages are only interleaved by a scheduler that chooses between
+ * streams, so an association using I-DATA goes round robin, unless the ULP chose a scheduler.
+ */
+static void mdi_chooseStreamScheduler(void)
+{
+    if (currentAssociation->streamSchedulerChosen == TRUE) return;
+    if (currentAssociation->supportsIDATA == TRUE && currentAssociation->peerSupportsIDATA == TRUE)
+        currentAssociation->streamScheduler = SCTP_SS_RR;
+    else
+        currentAssociation->streamScheduler = currentAssociation->sctpInstance->default_streamScheduler;
+}
+
+
 /**
  * This is the second function needed to fully create and initialize an association (after
  * mdi_newAssociation()) THe association is created in two steps because data become available
@@ -4905,7 +6576,9 @@ mdi_initAssociation(unsigned int remoteSideReceiverWindow,
                     unsigned short noOfOutStreams,
                     unsigned int remoteInitialTSN,
                     unsigned int tagRemote, unsigned int localInitialTSN,
-                    gboolean assocSupportsPRSCTP, gboolean assocSupportsADDIP)
+                    gboolean assocSupportsPRSCTP, gboolean assocSupportsADDIP,
+                    gboolean assocSupportsECN, gboolean assocSupportsNRSACK,
+                    gboolean assocSupportsIDATA)
 {
     gboolean withPRSCTP;
 
@@ -4936,11 +6609,25 @@ mdi_initAssociation(unsigned int remoteSideReceiverWindow,
     currentAssociation->peerSupportsPRSCTP = withPRSCTP;
     currentAssociation->supportsPRSCTP = withPRSCTP;
 
+    currentAssociation->peerSupportsECN = assocSupportsECN && currentAssociation->supportsECN;
+    currentAssociation->supportsECN = currentAssociation->peerSupportsECN;
+
+    currentAssociation->peerSupportsNRSACK = assocSupportsNRSACK && currentAssociation->supportsNRSACK;
+    currentAssociation->supportsNRSACK = currentAssociation->peerSupportsNRSACK;
+
+    /* without I-FORWARD-TSN, abandoned messages can not be skipped in I-DATA streams */
+    currentAssociation->peerSupportsIDATA = assocSupportsIDATA && currentAssociation->supportsIDATA && !withPRSCTP;
+    currentAssociation->supportsIDATA = currentAssociation->peerSupportsIDATA;
+    mdi_chooseStreamScheduler();
+
     currentAssociation->reliableTransfer =
         (void *) rtx_new_reltransfer(currentAssociation->noOfNetworks, localInitialTSN);
     currentAssociation->flowControl =
         (void *) fc_new_flowcontrol(remoteSideReceiverWindow, localInitialTSN,
-                                    currentAssociation->noOfNetworks, currentAssociation->maxSendQueue);
+                                    currentAssociation->noOfNetworks, currentAssociation->maxSendQueue,
+                                    currentAssociation->congestionControl,
+                                    currentAssociation->pacingGain,
+                                    currentAssociation->streamScheduler);
 
     currentAssociation->rx_control = (void *) rxc_new_recvctrl(remoteInitialTSN,currentAssociation->noOfNetworks,
                                                                currentAssociation->sctpInstance);
@@ -4965,7 +6652,9 @@ mdi_restartAssociation(unsigned short noOfInStreams,
                     short  noOfPaths,
                     short primaryAddress,
                     union sockunion *destinationAddressList,
-                    gboolean assocSupportsPRSCTP, gboolean assocSupportsADDIP)
+                    gboolean assocSupportsPRSCTP, gboolean assocSupportsADDIP,
+                    gboolean assocSupportsECN, gboolean assocSupportsNRSACK,
+                    gboolean assocSupportsIDATA)
 {
     int result;
     gboolean withPRSCTP;
@@ -4997,6 +6686,16 @@ mdi_restartAssociation(unsigned short noOfInStreams,
     currentAssociation->peerSupportsPRSCTP = withPRSCTP;
     currentAssociation->supportsPRSCTP     = withPRSCTP;
 
+    /* the association may only keep ECN, if the restarted peer still supports it */
+    currentAssociation->peerSupportsECN = assocSupportsECN && currentAssociation->supportsECN;
+    currentAssociation->supportsECN     = currentAssociation->peerSupportsECN;
+    currentAssociation->peerSupportsNRSACK = assocSupportsNRSACK && currentAssociation->supportsNRSACK;
+    currentAssociation->supportsNRSACK     = currentAssociation->peerSupportsNRSACK;
+    currentAssociation->peerSupportsIDATA = assocSupportsIDATA && currentAssociation->supportsIDATA && !withPRSCTP;
+    currentAssociation->supportsIDATA     = currentAssociation->peerSupportsIDATA;
+    mdi_chooseStreamScheduler();
+    fc_set_streamScheduler(currentAssociation->streamScheduler);
+
     if(currentAssociation->streamengine) {
        se_delete_stream_engine(currentAssociation->streamengine);
     }
@@ -5005,6 +6704,8 @@ mdi_restartAssociation(unsigned short noOfInStreams,
     }
     currentAssociation->streamengine = (void *) se_new_stream_engine(noOfInStreams,
                                                                      noOfOutStreams,withPRSCTP);
+    /* all queued data has been discarded */
+    mdi_releaseAssociationMemory(currentAssociation);
 
     if(currentAssociation->pathMan) {
        pm_deletePathman(currentAssociation->pathMan);
@@ -49,6 +49,7 @@
 #endif
 
 #include  "globals.h"           /* for public association data structure */
+#include  "sctp.h"
 #include  "messages.h"
 
 /* define some important constants */
@@ -62,11 +63,27 @@
 #define SACK_DELAY              200
 #define RTO_INITIAL             3000
 #define IPTOS_DEFAULT           0x10    /* IPTOS_LOWDELAY */
+/* ECN codepoints in the TOS byte / traffic class, see RFC 3168 */
+#ifndef IPTOS_ECN_MASK
+#define IPTOS_ECN_MASK          0x03
+#endif
+#ifndef IPTOS_ECN_ECT0
+#define IPTOS_ECN_ECT0          0x02
+#endif
+#ifndef IPTOS_ECN_CE
+#define IPTOS_ECN_CE            0x03
+#endif
 #define RTO_MIN                 1000
 #define DEFAULT_MAX_SENDQUEUE   0       /* unlimited send queue */
 #define DEFAULT_MAX_RECVQUEUE   0       /* unlimited recv queue - unused really */
 #define DEFAULT_MAX_BURST       4       /* maximum burst parameter */
 #define RTO_MAX                 60000
+#define DEFAULT_MEMORY_BUDGET   0       /* no library-wide memory budget */
+#define DEFAULT_INITIAL_RWND    65536   /* receiver window, with which autotuning starts */
+#define DEFAULT_CORK_DELAY      20      /* msecs that corked data waits for a full packet */
+#define MEMORY_PRESSURE_ON      90      /* percent of memory budget where pressure starts */
+#define MEMORY_PRESSURE_OFF     75      /* percent of memory budget where pressure ends */
+#define MEMORY_PRESSURE_NOTIFY  4       /* number of largest consumers that get notified */
 
 
 /******************** Function Definitions ********************************************************/
@@ -92,10 +109,36 @@
  *  @param bufferlength       length of datagramm
  *  @param fromAddress        source address of DG
  *  @param portnum            bogus port number
+ *  @param tos                TOS byte / traffic class of the IP header, for the ECN codepoint
  */
 void mdi_receiveMessage(gint socket_fd, unsigned char *buffer,
                    int bufferLength, union sockunion * source_addr,
-                   union sockunion * dest_addr);
+                   union sockunion * dest_addr, unsigned char tos);
+
+/* kinds of ICMP/ICMPv6 messages passed to mdi_icmpReceived */
+#define MDI_ICMP_UNREACHABLE      1   /* destination (host, port, network) unreachable */
+#define MDI_ICMP_PACKET_TOO_BIG   2   /* fragmentation needed / packet too big */
+
+/**
+ * \fn mdi_icmpReceived
+ *  mdi_icmpReceived is called by the Unix-interface module for an ICMP or ICMPv6 error
+ *  message that quotes an SCTP packet. If the quoted packet belongs to an association
+ *  (addresses, ports and verification tag match), the path it was sent on is marked
+ *  unreachable, or gets the smaller MTU.
+ *
+ *  @param peerAddress        destination address of the quoted packet
+ *  @param localPort          source port of the quoted packet
+ *  @param remotePort         destination port of the quoted packet
+ *  @param verificationTag    verification tag of the quoted packet (host byte order)
+ *  @param icmpEvent          MDI_ICMP_UNREACHABLE or MDI_ICMP_PACKET_TOO_BIG
+ *  @param mtu                next hop MTU for MDI_ICMP_PACKET_TOO_BIG
+ */
+void mdi_icmpReceived(union sockunion * peerAddress,
+                      unsigned short localPort,
+                      unsigned short remotePort,
+                      unsigned int verificationTag,
+                      int icmpEvent,
+                      unsigned int mtu);
 
 /*------------------- Functions called by the SCTP bundling --------------------------------------*/
 
@@ -127,6 +170,18 @@ int mdi_send_message(SCTP_message * message, unsigned int length, short destAddr
 void mdi_dataArriveNotif(unsigned short streamID, unsigned int length, unsigned short streamSN,
                          unsigned int tsn, unsigned int protoID, unsigned int unordered);
 
+/**
+ *  notifies the ULP of the data, that arrived on associations with coalesced data arrivals
+ *  since the last call (one dataArriveBatchNotif per association)
+ */
+void mdi_deliverDataArrivals(void);
+
+/**
+ *  notifies the ULP of associations, for which memory pressure started or ended
+ *  since the last call (queueStatusChangeNotif with SCTP_MEMORY_QUEUE)
+ */
+void mdi_deliverMemoryPressure(void);
+
 
 
 /* indicates a change of network status (chapter 10.2.C).
@@ -183,6 +238,64 @@ void mdi_communicationUpNotif(unsigned short status);
  */
 void mdi_queueStatusChangeNotif(int queueType, int queueId, int queueLen);
 
+/*------------------- Functions for the library-wide memory budget -------------------------------*/
+
+/**
+ * charge bytes of user data queued by the current association against the memory budget
+ * @param  bytes     number of bytes that have been queued
+ */
+void mdi_chargeMemory(unsigned int bytes);
+
+/**
+ * release bytes of user data that the current association no longer holds
+ * @param  bytes     number of bytes that have been freed
+ */
+void mdi_releaseMemory(unsigned int bytes);
+
+/**
+ * check, whether the ULP may queue another message of that size
+ * @param  bytes     size of the message the ULP wants to send
+ * @return TRUE if the message fits into the memory budget, else FALSE
+ */
+gboolean mdi_memoryAvailable(unsigned int bytes);
+
+/**
+ * reduce the receiver window that is to be advertised, if the library
+ * is running short of its memory budget
+ * @param  rwnd      the receiver window the association would advertise
+ * @return the receiver window that may be advertised
+ */
+unsigned int mdi_limitReceiverWindow(unsigned int rwnd);
+
+/*------------------- Functions for the protocol statistics --------------------------------------*/
+
+/**
+ * returns the statistics counters of the current association, or the counters for
+ * packets without association, if no association is set. Never returns NULL.
+ * @return pointer to the counters, which the caller may increment
+ */
+SCTP_AssociationStatistics* mdi_readStatistics(void);
+
+/**
+ * returns the statistics counters of one path of the current association
+ * @param  pathID    index of the path
+ * @return pointer to the counters, or NULL if no association is set or the path does not exist
+ */
+SCTP_PathStatistics* mdi_readPathStatistics(short pathID);
+
+/**
+ * records a raw RTT sample of a path of the current association in its histogram
+ * @param  pathID    index of the path
+ * @param  usecs     RTT sample in microseconds
+ */
+void mdi_recordRttSample(short pathID, unsigned int usecs);
+
+/**
+ * records the send-to-ack latency of a DATA chunk of the current association
+ * @param  usecs     time between the transmission of the chunk and its acknowledgement
+ */
+void mdi_recordAckLatency(unsigned int usecs);
+
 
 int mdi_updateMyAddressList(void);
 
@@ -353,16 +466,34 @@ int mdi_getDefaultRtoMin(void* sctpInstance);
 int mdi_getDefaultRtoMax(void* sctpInstance);
 int mdi_getDefaultMaxInitRetransmits(void* sctpInstance);
 int mdi_getDefaultMyRwnd(void);
+unsigned int mdi_getInitialMyRwnd(void);
+gboolean mdi_getDefaultRwndAutotuning(void* sctpInstance);
+unsigned int mdi_getDefaultCorkDelay(void);
 int mdi_getDefaultDelay(void* sctpInstance);
 int mdi_getDefaultIpTos(void* sctpInstance);
 int mdi_getDefaultMaxSendQueue(void* sctpInstance);
 int mdi_getDefaultMaxRecvQueue(void* sctpInstance);
 int mdi_getDefaultMaxBurst(void);
+gboolean mdi_getDefaultPathMTUDiscovery(void* sctpInstance);
+unsigned int mdi_readLocalMaxMTU(void);
 	
 unsigned int mdi_getSupportedAddressTypes(void);
 
 gboolean mdi_supportsPRSCTP(void);
+
+gboolean mdi_usesCMT(void);
 gboolean mdi_peerSupportsPRSCTP(void);
+
+gboolean mdi_supportsECN(void);
+
+gboolean mdi_supportsNRSACK(void);
+
+gboolean mdi_supportsIDATA(void);
+
+gboolean mdi_offersIDATA(void);
+
+/* TRUE, if the packet being processed was marked CE, and the association uses ECN */
+gboolean mdi_congestionExperienced(void);
 /*------------- functions to write and read addresses --------------------------------------------*/
 
 void mdi_writeDestinationAddresses(union sockunion addresses[MAX_NUM_ADDRESSES], int noOfAddresses);
@@ -436,7 +567,9 @@ mdi_initAssociation(unsigned int remoteSideReceiverWindow,
                     unsigned short noOfOutStreams,
                     unsigned int remoteInitialTSN,
                     unsigned int tagRemote, unsigned int localInitialTSN,
-                    gboolean assocSupportsPRSCTP, gboolean assocSupportsADDIP);
+                    gboolean assocSupportsPRSCTP, gboolean assocSupportsADDIP,
+                    gboolean assocSupportsECN, gboolean assocSupportsNRSACK,
+                    gboolean assocSupportsIDATA);
 
 
 unsigned short
@@ -448,7 +581,9 @@ mdi_restartAssociation(unsigned short noOfInStreams,
                     short  noOfPaths,
                     short primaryAddress,
                     union sockunion *destinationAddressList,
-                    gboolean assocSupportsPRSCTP, gboolean assocSupportsADDIP);
+                    gboolean assocSupportsPRSCTP, gboolean assocSupportsADDIP,
+                    gboolean assocSupportsECN, gboolean assocSupportsNRSACK,
+                    gboolean assocSupportsIDATA);
 
 
 
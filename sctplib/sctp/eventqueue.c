@@ -0,0 +1,224 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *           //=====   //===== ===//=== //===//  //       //   //===//
+ *          //        //         //    //    // //       //   //    //
+ *         //====//  //         //    //===//  //       //   //===<<
+ *              //  //         //    //       //       //   //    //
+ *       ======//  //=====    //    //       //=====  //   //===//
+ *
+ * -------------- An SCTP implementation according to RFC 4960 --------------
+ *
+ * Copyright (C) 2000 by Siemens AG, Munich, Germany.
+ * Copyright (C) 2001-2004 Andreas Jungmaier
+ * Copyright (C) 2004-2026 Thomas Dreibholz
+ *
+ * Acknowledgements:
+ * Realized in co-operation between Siemens AG and the University of
+ * Duisburg-Essen, Institute for Experimental Mathematics, Computer
+ * Networking Technology group.
+ * This work was partially funded by the Bundesministerium fuer Bildung und
+ * Forschung (BMBF) of the Federal Republic of Germany
+ * (Förderkennzeichen 01AK045).
+ * The authors alone are responsible for the contents.
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact: sctp-discussion@sctp.de
+ *          thomas.dreibholz@gmail.com
+ *          tuexen@fh-muenster.de
+ *          andreas.jungmaier@web.de
+ */
+
+#include "eventqueue.h"
+
+#include <glib.h>
+#include <errno.h>
+#include <fcntl.h>
+#ifndef WIN32
+#include <unistd.h>
+#endif
+#if defined (LINUX)
+#include <sys/eventfd.h>
+#endif
+
+/**
+ * a completion queue : a single producer, single consumer ring of event records.
+ * The library writes at tail, the ULP reads at head, both count up and wrap around.
+ * The size is a power of two, so that the slots stay in sequence, when the counters
+ * wrap at 2^32.
+ */
+typedef struct
+{
+    /** ring of size records */
+    SCTP_Event* ring;
+    unsigned int size;
+    /** size - 1, maps a counter to its slot */
+    unsigned int mask;
+    /** number of records read, only changed by the reader */
+    volatile gint head;
+    /** number of records written, only changed by the library */
+    volatile gint tail;
+    /** records dropped since the ring was last full, only used by the library */
+    unsigned int dropped;
+    /** descriptor polled by the ULP */
+    int fd;
+    /** descriptor written to signal new records (the same as fd for an eventfd) */
+    int signalFd;
+} EventQueue;
+
+
+/* makes the queue's descriptor readable */
+static void eq_signal(EventQueue* eq)
+{
+#if defined (LINUX)
+    guint64 value = 1;
+#else
+    unsigned char value = 1;
+#endif
+    if (write(eq->signalFd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+        error_logi(ERROR_MINOR, "eq_signal: write() failed, errno %d", errno);
+}
+
+/* resets the queue's descriptor to not readable */
+static void eq_clear(EventQueue* eq)
+{
+#if defined (LINUX)
+    guint64 value;
+    if (read(eq->fd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+        error_logi(ERROR_MINOR, "eq_clear: read() failed, errno %d", errno);
+#else
+    unsigned char buffer[64];
+    while (read(eq->fd, buffer, sizeof(buffer)) > 0) ;
+#endif
+}
+
+
+void* eq_new(unsigned int size)
+{
+    EventQueue* eq;
+    unsigned int slots;
+#if !defined (LINUX) && !defined (WIN32)
+    int fds[2];
+#endif
+
+    if (size == 0 || size > 0x80000000U) return NULL;
+    for (slots = SCTP_MIN_EVENT_QUEUE_SIZE; slots < size; slots <<= 1) ;
+#if defined (WIN32)
+    error_log(ERROR_MAJOR, "eq_new: completion queues are not supported on this platform");
+    return NULL;
+#else
+    eq = (EventQueue*)malloc(sizeof(EventQueue));
+    if (eq == NULL) error_log(ERROR_FATAL, "Malloc failed");
+    eq->ring = (SCTP_Event*)malloc(slots * sizeof(SCTP_Event));
+    if (eq->ring == NULL) error_log(ERROR_FATAL, "Malloc failed");
+    eq->size = slots;
+    eq->mask = slots - 1;
+    eq->head = 0;
+    eq->tail = 0;
+    eq->dropped = 0;
+
+#if defined (LINUX)
+    eq->fd = eventfd(0, EFD_NONBLOCK);
+    eq->signalFd = eq->fd;
+#else
+    if (pipe(fds) == 0) {
+        eq->fd = fds[0];
+        eq->signalFd = fds[1];
+        fcntl(eq->fd, F_SETFL, fcntl(eq->fd, F_GETFL) | O_NONBLOCK);
+        fcntl(eq->signalFd, F_SETFL, fcntl(eq->signalFd, F_GETFL) | O_NONBLOCK);
+    } else {
+        eq->fd = -1;
+    }
+#endif
+    if (eq->fd < 0) {
+        error_logi(ERROR_MAJOR, "eq_new: could not create descriptor, errno %d", errno);
+        free(eq->ring);
+        free(eq);
+        return NULL;
+    }
+    event_logii(VERBOSE, "eq_new: completion queue with %u records, fd %d", slots, eq->fd);
+    return eq;
+#endif
+}
+
+
+void eq_delete(void* queue)
+{
+    EventQueue* eq = (EventQueue*)queue;
+
+    if (eq == NULL) return;
+#ifndef WIN32
+    if (eq->signalFd != eq->fd) close(eq->signalFd);
+    close(eq->fd);
+#endif
+    free(eq->ring);
+    free(eq);
+}
+
+
+int eq_getFd(void* queue)
+{
+    return ((EventQueue*)queue)->fd;
+}
+
+
+gboolean eq_put(void* queue, const SCTP_Event* event)
+{
+    EventQueue* eq = (EventQueue*)queue;
+    guint head, tail, needed;
+
+    head = (guint)g_atomic_int_get(&eq->head);
+    tail = (guint)eq->tail;
+    /* after an overflow, the ULP first learns how many records it has missed */
+    needed = (eq->dropped > 0) ? 2 : 1;
+    if (eq->size - (tail - head) < needed) {
+        eq->dropped++;
+        return FALSE;
+    }
+    if (eq->dropped > 0) {
+        memset(&eq->ring[tail & eq->mask], 0, sizeof(SCTP_Event));
+        eq->ring[tail & eq->mask].type = SCTP_EVENT_QUEUE_OVERFLOW;
+        eq->ring[tail & eq->mask].param[0] = eq->dropped;
+        tail++;
+        eq->dropped = 0;
+    }
+    eq->ring[tail & eq->mask] = *event;
+    tail++;
+    /* publish the records, before the reader is woken up */
+    g_atomic_int_set(&eq->tail, (gint)tail);
+    eq_signal(eq);
+    return TRUE;
+}
+
+
+unsigned int eq_get(void* queue, SCTP_Event* events, unsigned int max)
+{
+    EventQueue* eq = (EventQueue*)queue;
+    guint head, tail;
+    unsigned int count = 0;
+
+    /* clear the signal first, so that records written meanwhile signal again */
+    eq_clear(eq);
+    head = (guint)eq->head;
+    tail = (guint)g_atomic_int_get(&eq->tail);
+    while (head != tail && count < max) {
+        events[count++] = eq->ring[head & eq->mask];
+        head++;
+    }
+    g_atomic_int_set(&eq->head, (gint)head);
+    /* records left in the ring keep the descriptor readable */
+    if (head != tail) eq_signal(eq);
+    return count;
+}
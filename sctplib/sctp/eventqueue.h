@@ -0,0 +1,87 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *           //=====   //===== ===//=== //===//  //       //   //===//
+ *          //        //         //    //    // //       //   //    //
+ *         //====//  //         //    //===//  //       //   //===<<
+ *              //  //         //    //       //       //   //    //
+ *       ======//  //=====    //    //       //=====  //   //===//
+ *
+ * -------------- An SCTP implementation according to RFC 4960 --------------
+ *
+ * Copyright (C) 2000 by Siemens AG, Munich, Germany.
+ * Copyright (C) 2001-2004 Andreas Jungmaier
+ * Copyright (C) 2004-2026 Thomas Dreibholz
+ *
+ * Acknowledgements:
+ * Realized in co-operation between Siemens AG and the University of
+ * Duisburg-Essen, Institute for Experimental Mathematics, Computer
+ * Networking Technology group.
+ * This work was partially funded by the Bundesministerium fuer Bildung und
+ * Forschung (BMBF) of the Federal Republic of Germany
+ * (Förderkennzeichen 01AK045).
+ * The authors alone are responsible for the contents.
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact: sctp-discussion@sctp.de
+ *          thomas.dreibholz@gmail.com
+ *          tuexen@fh-muenster.de
+ *          andreas.jungmaier@web.de
+ */
+
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "globals.h"
+#include "sctp.h"
+
+
+/**
+ * creates a completion queue, i.e. a ring of event records, and the file
+ * descriptor that signals new records. The size is rounded up to a power of two,
+ * and to at least SCTP_MIN_EVENT_QUEUE_SIZE.
+ * @return pointer to the queue, or NULL if the queue could not be created
+ */
+void* eq_new(unsigned int size);
+
+/**
+ * deletes a completion queue, and closes its file descriptor
+ */
+void eq_delete(void* queue);
+
+/**
+ * @return the file descriptor, that becomes readable when new records are queued
+ */
+int eq_getFd(void* queue);
+
+/**
+ * appends a record to the queue, and signals the file descriptor. Only the
+ * thread running the library may call this function.
+ * @return TRUE, or FALSE if the queue was full and the record was dropped
+ */
+gboolean eq_put(void* queue, const SCTP_Event* event);
+
+/**
+ * removes up to max records from the queue. May be called by one other thread,
+ * while the library queues new records.
+ * @return number of records copied to events
+ */
+unsigned int eq_get(void* queue, SCTP_Event* events, unsigned int max);
+
+#endif
@@ -45,34 +45,18 @@
 #include "bundling.h"
 #include "adaptation.h"
 #include "recvctrl.h"
+#include "SCTP-control.h"
+#include "congestion.h"
+#include "scheduler.h"
+#include "trace.h"
 
 #include <stdio.h>
 #include <glib.h>
 
 /* #define Current_event_log_ 6 */
-/**
- * this struct contains all relevant congestion control parameters for
- * one PATH to the destination/association peer endpoint
- */
-typedef struct __congestion_parameters
-{
-    /*@{ */
-    /** */
-    unsigned int cwnd;
-    /** */
-    unsigned int cwnd2;
-    /** */
-    unsigned int partial_bytes_acked;
-    /** */
-    unsigned int ssthresh;
-    /** */
-    unsigned int mtu;
-    /** */
-    struct timeval time_of_cwnd_adjustment;
-    /** */
-    struct timeval last_send_time;
-    /*@} */
-} cparm;
+
+/* packets due within this many microseconds are sent at once, as the timers are not more precise */
+#define PACING_QUANTUM          1000
 
 typedef struct flowcontrol_struct
 {
@@ -85,6 +69,8 @@ typedef struct flowcontrol_struct
     unsigned int number_of_addresses;
     /** pointer to array of congestion window parameters */
     cparm *cparams;
+    /** congestion control module that adjusts the cparams */
+    const cc_ops *cc;
     /** */
     unsigned int current_tsn;
     /** */
@@ -93,6 +79,15 @@ typedef struct flowcontrol_struct
     unsigned int list_length;
     /** one timer may be running per destination address */
     TimerID *T3_timer;
+    /** per destination address : time, when T3 expires. A SACK only moves this deadline,
+        the running timer catches up with it, when it goes off */
+    struct timeval *t3_deadline;
+    /** per destination address : time, for which the running T3 timer was set */
+    struct timeval *t3_expiry;
+    /** timers that release the next paced packet, one per destination address */
+    TimerID *pacing_timer;
+    /** pacing gain in percent, 0 if pacing is off */
+    unsigned int pacing_gain;
     /** for passing as parameter in callback functions */
     unsigned int *addresses;
     /** */
@@ -109,12 +104,41 @@ typedef struct flowcontrol_struct
     boolean doing_retransmission;
     /** */
     unsigned int maxQueueLen;
+    /** TRUE, once the cwnd has been reduced due to an ECNE chunk */
+    boolean ecn_reduced;
+    /** highest TSN sent at the time of the last ECN reduction : later ECNEs for
+        TSNs up to this one belong to the same window, and cause no further reduction */
+    unsigned int ecn_recover_tsn;
+    /** stream scheduler that orders the unsent chunks of different streams */
+    const ss_ops *ss;
+    /** tag of the last chunk, that was sent for the first time */
+    unsigned int virtual_time;
+    /** scheduling state of the outbound streams, grows with the highest stream id used */
+    ss_stream *streams;
+    /** number of entries in streams */
+    unsigned int num_streams;
+    /** while not zero, queued chunks are not sent (see fc_hold_transmission()) */
+    unsigned int hold_count;
+    /** list_length, when the transmission was held */
+    unsigned int hold_list_length;
+    /** TRUE while the ULP keeps the association corked (see fc_set_cork()) */
+    boolean corked;
+    /** TRUE, if the ULP announced more data with its last message (SCTP_SEND_MORE) */
+    boolean more;
+    /** bytes queued since data was last sent for the ULP */
+    unsigned int cork_bytes;
+    /** msecs that corked data may wait for a full packet */
+    unsigned int cork_delay;
+    /** timer that sends corked data after cork_delay */
+    TimerID cork_timer;
     /*@} */
 } fc_data;
 
 
 /* ---------------  Function Prototypes -----------------------------*/
 int fc_check_for_txmit(void *fc_instance, unsigned int oldListLen, gboolean doInitialRetransmit);
+void fc_timer_cb_t3_timeout(TimerID tid, void *assoc, void *data2);
+static void fc_send_queued(fc_data * fc, unsigned int oldListLen);
 /* ---------------  Function Prototypes -----------------------------*/
 
 
@@ -125,12 +149,18 @@ int fc_check_for_txmit(void *fc_instance, unsigned int oldListLen, gboolean doIn
  * @param  peer_rwnd receiver window that peer allowed us when setting up the association
  * @param  my_iTSN my initial TSN value
  * @param  number_of_destination_addresses the number of paths to the association peer
+ * @param  congestionControl  SCTP_CC_xxx value of the congestion control module to use
+ * @param  pacingGain  pacing gain in percent, 0 to send without pacing
+ * @param  streamScheduler  SCTP_SS_xxx value of the stream scheduler to use
  * @return  pointer to the new fc_data instance
 */
 void *fc_new_flowcontrol(unsigned int peer_rwnd,
                          unsigned int my_iTSN,
                          unsigned int number_of_destination_addresses,
-                         unsigned int maxQueueLen)
+                         unsigned int maxQueueLen,
+                         unsigned int congestionControl,
+                         unsigned int pacingGain,
+                         unsigned int streamScheduler)
 {
     fc_data *tmp;
     unsigned int count;
@@ -140,6 +170,18 @@ void *fc_new_flowcontrol(unsigned int peer_rwnd,
         error_log(ERROR_FATAL, "Malloc failed");
     tmp->current_tsn = my_iTSN;
 
+    tmp->cc = cc_getModule(congestionControl);
+    if (tmp->cc == NULL) {
+        error_logi(ERROR_MAJOR, "Unknown congestion control %u, using Reno", congestionControl);
+        tmp->cc = cc_getModule(SCTP_CC_RENO);
+    }
+
+    tmp->ss = ss_getModule(streamScheduler);
+    if (tmp->ss == NULL) {
+        error_logi(ERROR_MAJOR, "Unknown stream scheduler %u, using FCFS", streamScheduler);
+        tmp->ss = ss_getModule(SCTP_SS_FCFS);
+    }
+
     event_logi(VERBOSE,
                "Flowcontrol: ===== Num of number_of_destination_addresses = %d ",
                number_of_destination_addresses);
@@ -152,20 +194,35 @@ void *fc_new_flowcontrol(unsigned int peer_rwnd,
     if (!tmp->T3_timer)
         error_log(ERROR_FATAL, "Malloc failed");
 
+    tmp->pacing_timer = (TimerID*)malloc(number_of_destination_addresses * sizeof(TimerID));
+    if (!tmp->pacing_timer)
+        error_log(ERROR_FATAL, "Malloc failed");
+
+    tmp->t3_deadline = (struct timeval*)malloc(number_of_destination_addresses * sizeof(struct timeval));
+    tmp->t3_expiry = (struct timeval*)malloc(number_of_destination_addresses * sizeof(struct timeval));
+    if (!tmp->t3_deadline || !tmp->t3_expiry)
+        error_log(ERROR_FATAL, "Malloc failed");
+
     tmp->addresses = (unsigned int*)malloc(number_of_destination_addresses * sizeof(unsigned int));
     if (!tmp->addresses)
         error_log(ERROR_FATAL, "Malloc failed");
 
     for (count = 0; count < number_of_destination_addresses; count++) {
         tmp->T3_timer[count] = 0; /* i.e. timer not running */
+        timerclear(&(tmp->t3_deadline[count]));
+        timerclear(&(tmp->t3_expiry[count]));
+        tmp->pacing_timer[count] = 0;
         tmp->addresses[count] = count;
-        (tmp->cparams[count]).cwnd = 2 * MAX_MTU_SIZE;
+        (tmp->cparams[count]).mtu = DEFAULT_SCTP_PDU;
+        (tmp->cparams[count]).cwnd = 2 * CC_PACKET_SIZE(&(tmp->cparams[count]));
         (tmp->cparams[count]).cwnd2 = 0L;
         (tmp->cparams[count]).partial_bytes_acked = 0L;
         (tmp->cparams[count]).ssthresh = peer_rwnd;
-        (tmp->cparams[count]).mtu = MAX_SCTP_PDU;
         adl_gettime( &(tmp->cparams[count].time_of_cwnd_adjustment));
         timerclear(&(tmp->cparams[count].last_send_time));
+        (tmp->cparams[count]).pacing_rate = 0;
+        timerclear(&(tmp->cparams[count].next_send_time));
+        tmp->cc->on_init(&(tmp->cparams[count]));
     }
     tmp->outstanding_bytes = 0;
     tmp->announced_rwnd = peer_rwnd;
@@ -177,6 +234,19 @@ void *fc_new_flowcontrol(unsigned int peer_rwnd,
     tmp->doing_retransmission = FALSE;
     tmp->chunk_list = NULL;
     tmp->maxQueueLen = maxQueueLen;
+    tmp->pacing_gain = pacingGain;
+    tmp->ecn_reduced = FALSE;
+    tmp->ecn_recover_tsn = my_iTSN - 1;
+    tmp->virtual_time = 0;
+    tmp->streams = NULL;
+    tmp->num_streams = 0;
+    tmp->hold_count = 0;
+    tmp->hold_list_length = 0;
+    tmp->corked = FALSE;
+    tmp->more = FALSE;
+    tmp->cork_bytes = 0;
+    tmp->cork_delay = mdi_getDefaultCorkDelay();
+    tmp->cork_timer = 0;
     tmp->list_length = 0;
 
     rtx_set_remote_receiver_window(peer_rwnd);
@@ -206,13 +276,16 @@ void fc_restart(guint32 new_rwnd, unsigned int iTSN, unsigned int maxQueueLen)
     }
     fc_stop_timers();
     for (count = 0; count < tmp->number_of_addresses; count++) {
-        (tmp->cparams[count]).cwnd = 2 * MAX_MTU_SIZE;
+        /* the path MTU is a property of the path, and survives the restart */
+        (tmp->cparams[count]).cwnd = 2 * CC_PACKET_SIZE(&(tmp->cparams[count]));
         (tmp->cparams[count]).cwnd2 = 0L;
         (tmp->cparams[count]).partial_bytes_acked = 0L;
         (tmp->cparams[count]).ssthresh = new_rwnd;
-        (tmp->cparams[count]).mtu = MAX_SCTP_PDU;
         adl_gettime( &(tmp->cparams[count].time_of_cwnd_adjustment) );
         timerclear(&(tmp->cparams[count].last_send_time));
+        (tmp->cparams[count]).pacing_rate = 0;
+        timerclear(&(tmp->cparams[count].next_send_time));
+        tmp->cc->on_init(&(tmp->cparams[count]));
     }
     tmp->outstanding_bytes = 0;
     tmp->announced_rwnd = new_rwnd;
@@ -223,6 +296,14 @@ void fc_restart(guint32 new_rwnd, unsigned int iTSN, unsigned int maxQueueLen)
     tmp->doing_retransmission = FALSE;
     tmp->current_tsn = iTSN;
     tmp->maxQueueLen = maxQueueLen;
+    tmp->ecn_reduced = FALSE;
+    tmp->ecn_recover_tsn = iTSN - 1;
+    /* the streams keep their priority and weight */
+    tmp->virtual_time = 0;
+    for (count = 0; count < tmp->num_streams; count++) {
+        tmp->streams[count].start_tag = 0;
+        tmp->streams[count].finish_tag = 0;
+    }
     rtx_set_remote_receiver_window(new_rwnd);
     if ((tmp->chunk_list) != NULL) {
         /* TODO : pass chunks in this list back up to the ULP ! */
@@ -247,7 +328,11 @@ void fc_delete_flowcontrol(void *fc_instance)
     fc_stop_timers();
     free(tmp->cparams);
     free(tmp->T3_timer);
+    free(tmp->t3_deadline);
+    free(tmp->t3_expiry);
+    free(tmp->pacing_timer);
     free(tmp->addresses);
+    free(tmp->streams);
     if ((tmp->chunk_list) != NULL) {
         error_log(ERROR_MINOR, "FLOWCONTROL : List is deleted with chunks still queued...");
         g_list_foreach(tmp->chunk_list, &free_list_element, GINT_TO_POINTER(1));
@@ -274,7 +359,7 @@ void fc_debug_cparams(short event_log_level)
         }
         event_log(event_log_level,
                   "----------------------------------------------------------------------");
-        event_log(event_log_level, "Debug-output for Congestion Control Parameters ! ");
+        event_logi(event_log_level, "Debug-output for Congestion Control Parameters (%s) ! ", fc->cc->name);
         event_logii(event_log_level, "outstanding_bytes == %u; current_tsn == %u; ",
                                 fc->outstanding_bytes, fc->current_tsn);
         event_logi(event_log_level, "chunks queued in flowcontrol== %lu; ", fc->list_length);
@@ -345,6 +430,14 @@ void fc_stop_timers(void)
                 error_log(ERROR_MINOR, "Timer not correctly reset to 0 !");
             event_logii(VVERBOSE, "Stopping T3-Timer(%d) = %d ", count, result);
         }
+        if (fc->pacing_timer[count] != 0) {
+            sctp_stopTimer(fc->pacing_timer[count]);
+            fc->pacing_timer[count] = 0;
+        }
+    }
+    if (fc->cork_timer != 0) {
+        sctp_stopTimer(fc->cork_timer);
+        fc->cork_timer = 0;
     }
     return;
 }
@@ -384,7 +477,7 @@ int fc_reset_cwnd(unsigned int pathId)
     if (timercmp(&now, &resetTime, > )) {
         event_logi(INTERNAL_EVENT_0, "----- fc_reset_cwnd(): resetting CWND for idle path %u ------", pathId);
         /* path has been idle for at least on RTO */
-        fc->cparams[pathId].cwnd = 2 * MAX_MTU_SIZE;
+        fc->cc->on_idle(&(fc->cparams[pathId]));
         adl_gettime(&(fc->cparams[pathId].last_send_time));
         event_logii(INTERNAL_EVENT_0, "resetting cwnd[%d], setting it to : %d\n", pathId, fc->cparams[pathId].cwnd);
     }
@@ -447,6 +540,97 @@ fc_select_destination(fc_data * fc, chunk_data * dat,
     return (fc_getNextActivePath(fc, next));
 }
 
+/**
+ * CMT destination selection for new data : the current destination is kept, as long as it
+ * has room for another full packet in its cwnd, else the active path with most room is used.
+ * If no path has room, the current destination is returned, and fc_send_okay() will stop.
+ * @param  current  index of the destination of the previous chunk
+ * @param  sent     bytes already put to that destination in this round
+ * @return index of the address where the next new chunk should go to
+ */
+static unsigned int fc_cmt_select_destination(fc_data * fc, unsigned int current, unsigned int sent)
+{
+    unsigned int count, best, total, room, best_room = 0;
+    int obpa;
+
+    best = current;
+    if (pm_readState((short)current) == PM_ACTIVE) {
+        obpa = rtx_get_obpa(current, &total);
+        if (obpa >= 0 &&
+            fc->cparams[current].cwnd + fc->cparams[current].mtu - 1 >= obpa + sent + fc->cparams[current].mtu)
+            return current;
+    }
+    for (count = 0; count < fc->number_of_addresses; count++) {
+        if (pm_readState((short)count) != PM_ACTIVE) continue;
+        obpa = rtx_get_obpa(count, &total);
+        if (obpa < 0) return current;
+        if (count == current) obpa += sent;
+        room = fc->cparams[count].cwnd + fc->cparams[count].mtu - 1;
+        room = (room > (unsigned int)obpa) ? room - obpa : 0;
+        if (room > best_room) {
+            best_room = room;
+            best = count;
+        }
+    }
+    event_logii(VERBOSE, "fc_cmt_select_destination: path %u with %u bytes room", best, best_room);
+    return best;
+}
+
+/**
+ * (re)starts T3 on a destination with the current RTO. A running timer, that goes off
+ * before the new deadline, is left alone : fc_timer_cb_t3_timeout() sets it anew, when
+ * it goes off early. Only a deadline before the running timer's expiry costs a restart.
+ * @return TRUE, if T3 was not running before
+ */
+static gboolean fc_set_t3_deadline(fc_data * fc, unsigned int destination)
+{
+    unsigned int rto = pm_readRTO((short)destination);
+
+    adl_gettime(&(fc->t3_deadline[destination]));
+    adl_add_msecs_totime(&(fc->t3_deadline[destination]), rto);
+
+    if (fc->T3_timer[destination] == 0) {
+        fc->T3_timer[destination] =  adl_startTimer(rto,
+                                                    &fc_timer_cb_t3_timeout,
+                                                    TIMER_TYPE_RTXM,
+                                                   &(fc->my_association),
+                                                    &(fc->addresses[destination]));
+        fc->t3_expiry[destination] = fc->t3_deadline[destination];
+        return TRUE;
+    }
+    if (timercmp(&(fc->t3_deadline[destination]), &(fc->t3_expiry[destination]), <)) {
+        fc->T3_timer[destination] = adl_restartTimer(fc->T3_timer[destination], rto);
+        fc->t3_expiry[destination] = fc->t3_deadline[destination];
+    }
+    return FALSE;
+}
+
+/**
+ * starts T3 on a destination, to which data was sent, if it is not running, or restarts it,
+ * when the lowest outstanding TSN has been retransmitted (sections 5.1 and 6.1)
+ */
+static void fc_start_t3(fc_data * fc, unsigned int destination, gboolean lowest_tsn_is_retransmitted)
+{
+    if (fc->T3_timer[destination] == 0) { /* see section 5.1 */
+
+        fc_set_t3_deadline(fc, destination);
+
+        event_logiii(INTERNAL_EVENT_0,
+                     "fc_check_for_transmit: started T3 Timer with RTO(%u)==%u msecs on address %u",
+                     destination, pm_readRTO((short)destination), fc->addresses[destination]);
+    } else {
+        /* restart only if lowest TSN is being retransmitted, else leave running */
+        /* see section 6.1 */
+        if (lowest_tsn_is_retransmitted) {
+            event_logiii(INTERNAL_EVENT_0,
+                         "RTX of lowest TSN: Restarted T3 Timer with RTO(%u)==%u msecs on address %u",
+                         destination, pm_readRTO((short)destination), fc->addresses[destination]);
+
+            fc_set_t3_deadline(fc, destination);
+        }
+    }
+}
+
 
 /**
  *  timer controlled callback function, called when T3 timer expires and data must be retransmitted
@@ -465,6 +649,9 @@ void fc_timer_cb_t3_timeout(TimerID tid, void *assoc, void *data2)
     int num_of_chunks;
     chunk_data **chunks;
     gboolean removed_association = FALSE;
+    SCTP_PathStatistics* pathStats;
+    struct timeval now;
+    int remaining;
 
     res = mdi_setAssociationData(*(unsigned int *) assoc);
     if (res == 1) {
@@ -483,9 +670,25 @@ void fc_timer_cb_t3_timeout(TimerID tid, void *assoc, void *data2)
     }
 
     ad_idx = *((unsigned int *) data2);
-    event_logi(INTERNAL_EVENT_0, "===============> fc_timer_cb_t3_timeout(address=%u) <========", ad_idx);
     fc->T3_timer[ad_idx] = 0;
 
+    /* the deadline may have moved on, since the timer was set */
+    adl_gettime(&now);
+    remaining = adl_timediff_to_msecs(&(fc->t3_deadline[ad_idx]), &now);
+    if (remaining > 0) {
+        fc->T3_timer[ad_idx] =  adl_startTimer(remaining,
+                                               &fc_timer_cb_t3_timeout,
+                                               TIMER_TYPE_RTXM,
+                                               &(fc->my_association),
+                                               &(fc->addresses[ad_idx]));
+        fc->t3_expiry[ad_idx] = fc->t3_deadline[ad_idx];
+        event_logii(VVERBOSE, "fc_timer_cb_t3_timeout: deadline on address %u is %d msecs ahead",
+                    ad_idx, remaining);
+        mdi_clearAssociationData();
+        return;
+    }
+    event_logi(INTERNAL_EVENT_0, "===============> fc_timer_cb_t3_timeout(address=%u) <========", ad_idx);
+
     num_of_chunks = rtx_readNumberOfUnackedChunks();
     event_logii(INTERNAL_EVENT_0, "Address-Index : %u, Number of Chunks==%d", ad_idx, num_of_chunks);
 
@@ -501,6 +704,9 @@ void fc_timer_cb_t3_timeout(TimerID tid, void *assoc, void *data2)
 
     chunks = (chunk_data**)malloc(num_of_chunks * sizeof(chunk_data *));
     num_of_chunks = rtx_t3_timeout(&(fc->my_association), ad_idx, fc->cparams[ad_idx].mtu, chunks);
+    trc_event(SCTP_TRACE_MODULE_FLOWCONTROL, TRC_T3_TIMEOUT, fc->my_association, ad_idx, num_of_chunks);
+    mdi_readStatistics()->t3Timeouts++;
+    if ((pathStats = mdi_readPathStatistics((short)ad_idx)) != NULL) pathStats->t3Timeouts++;
     if (num_of_chunks <= 0) {
         event_log(VERBOSE, "No Chunks to re-transmit - AFTER calling rtx_t3_timeout - returning");
         free(chunks);
@@ -512,11 +718,7 @@ void fc_timer_cb_t3_timeout(TimerID tid, void *assoc, void *data2)
     /* do not do this if we are in fast recovery mode - see SCTP imp guide */
     if (rtx_is_in_fast_recovery() == FALSE) {
         /* adjust ssthresh, cwnd - section 6.3.3.E1, respectively 7.2.3) */
-        /* basically we halve the ssthresh, and set cwnd = mtu */
-        fc->cparams[ad_idx].ssthresh = max(fc->cparams[ad_idx].cwnd / 2, 2 * fc->cparams[ad_idx].mtu);
-        fc->cparams[ad_idx].cwnd = fc->cparams[ad_idx].mtu;
-        /* as per implementor's guide */
-        fc->cparams[ad_idx].partial_bytes_acked = 0;
+        fc->cc->on_rto(&(fc->cparams[ad_idx]));
     }
 /*
     for (count = 0; count < num_of_chunks; count++) {
@@ -573,6 +775,113 @@ void fc_timer_cb_t3_timeout(TimerID tid, void *assoc, void *data2)
     return;
 }
 
+/**
+ * timer callback, that lets flowcontrol send the next paced packet(s)
+ *  @param  tid the id of the timer that has gone off
+ *  @param  assoc  pointer to the association structure to which this timer belongs
+ *  @param  data2  pointer to the index of the paced address
+ */
+void fc_timer_cb_pacing(TimerID tid, void *assoc, void *data2)
+{
+    fc_data *fc;
+    unsigned int ad_idx, res;
+
+    res = mdi_setAssociationData(*(unsigned int *) assoc);
+    if (res == 1) {
+        error_log(ERROR_MAJOR, " association does not exist !");
+        return;
+    }
+    if (res == 2) {
+        error_log(ERROR_MAJOR, "Association was not cleared..... !!!");
+    }
+    fc = (fc_data *) mdi_readFlowControl();
+    if (!fc) {
+        error_log(ERROR_MAJOR, "fc_data instance not set !");
+        mdi_clearAssociationData();
+        return;
+    }
+    ad_idx = *((unsigned int *) data2);
+    fc->pacing_timer[ad_idx] = 0;
+    event_logi(VVERBOSE, "fc_timer_cb_pacing(address=%u)", ad_idx);
+
+    if (fc->chunk_list != NULL) {
+        fc_check_for_txmit(fc, fc->list_length, FALSE);
+    }
+    mdi_clearAssociationData();
+}
+
+/**
+ * sets the pacing rate of a path from its current cwnd and srtt
+ */
+static void fc_update_pacing_rate(fc_data * fc, unsigned int path)
+{
+    guint64 rate;
+    unsigned int srtt;
+
+    if (fc->pacing_gain == 0) {
+        fc->cparams[path].pacing_rate = 0;
+        return;
+    }
+    srtt = pm_readSRTT((short)path);
+    if (srtt == 0) srtt = 1;
+    /* bytes per second, do not slow down window growth in slow start */
+    rate = (guint64)fc->cparams[path].cwnd * fc->pacing_gain * 10 / srtt;
+    if (fc->cparams[path].cwnd <= fc->cparams[path].ssthresh) rate *= 2;
+    fc->cparams[path].pacing_rate = (rate > 0xFFFFFFFFULL) ? 0xFFFFFFFFU : (unsigned int)rate;
+}
+
+/**
+ * @return TRUE if pacing lets the next packet leave on a path now
+ */
+static gboolean fc_pacing_allows(fc_data * fc, unsigned int path, struct timeval* now)
+{
+    struct timeval horizon;
+
+    if (fc->cparams[path].pacing_rate == 0) return TRUE;
+    horizon = *now;
+    adl_add_msecs_totime(&horizon, PACING_QUANTUM / 1000);
+    return (timercmp(&(fc->cparams[path].next_send_time), &horizon, >)) ? FALSE : TRUE;
+}
+
+/**
+ * moves the pacing slot of a path on by the sending time of bytes
+ */
+static void fc_pacing_charge(fc_data * fc, unsigned int path, unsigned int bytes, struct timeval* now)
+{
+    struct timeval delta, next;
+    guint64 usecs;
+
+    if (fc->cparams[path].pacing_rate == 0) return;
+    if (timercmp(&(fc->cparams[path].next_send_time), now, <)) {
+        fc->cparams[path].next_send_time = *now;
+    }
+    usecs = (guint64)bytes * 1000000 / fc->cparams[path].pacing_rate;
+    delta.tv_sec = (long)(usecs / 1000000);
+    delta.tv_usec = (long)(usecs % 1000000);
+    timeradd(&(fc->cparams[path].next_send_time), &delta, &next);
+    fc->cparams[path].next_send_time = next;
+}
+
+/**
+ * starts the pacing timer of a path, that fires when its next packet is due
+ */
+static void fc_start_pacing_timer(fc_data * fc, unsigned int path, struct timeval* now)
+{
+    struct timeval delay;
+
+    if (fc->pacing_timer[path] != 0) return;
+    if (timercmp(&(fc->cparams[path].next_send_time), now, >)) {
+        timersub(&(fc->cparams[path].next_send_time), now, &delay);
+    } else {
+        timerclear(&delay);
+    }
+    fc->pacing_timer[path] = adl_startMicroTimer((unsigned int)delay.tv_sec, (unsigned int)delay.tv_usec,
+                                                 &fc_timer_cb_pacing, TIMER_TYPE_CWND,
+                                                 &(fc->my_association), &(fc->addresses[path]));
+    event_logii(VVERBOSE, "fc_start_pacing_timer: next packet on path %u in %ld usecs",
+                path, (long)(delay.tv_sec * 1000000 + delay.tv_usec));
+}
+
 /**
  * function increases chunk's number of transmissions, stores used destination, updates counts per addresses
  */
@@ -662,10 +971,16 @@ int fc_check_for_txmit(void *fc_instance, unsigned int oldListLen, gboolean doIn
     fc_data *fc;
     chunk_data *dat;
     unsigned int total_size, destination, oldDestination, peer_rwnd;
+    unsigned int packet_size, count;
+    guint32 paths_used = 0;
+    struct timeval now;
 
+    gboolean cmt;
     gboolean data_is_retransmitted = FALSE;
     gboolean lowest_tsn_is_retransmitted = FALSE;
     gboolean data_is_submitted = FALSE;
+    SCTP_AssociationStatistics* stats;
+    SCTP_PathStatistics* pathStats;
     peer_rwnd = rtx_read_remote_receiver_window();
 
     event_logi(INTERNAL_EVENT_0, "Entering fc_check_for_txmit(rwnd=%u)... ", peer_rwnd);
@@ -680,7 +995,11 @@ int fc_check_for_txmit(void *fc_instance, unsigned int oldListLen, gboolean doIn
 
     if (dat->num_of_transmissions >= 1)  data_is_retransmitted = TRUE;
 
-    destination = fc_select_destination(fc, dat, (unsigned char)data_is_retransmitted, NULL);
+    cmt = mdi_usesCMT();
+    if (cmt == TRUE && data_is_retransmitted == FALSE && dat->initial_destination == -1)
+        destination = fc_cmt_select_destination(fc, pm_readPrimaryPath(), 0);
+    else
+        destination = fc_select_destination(fc, dat, (unsigned char)data_is_retransmitted, NULL);
 
     total_size = 0;
 
@@ -725,8 +1044,25 @@ int fc_check_for_txmit(void *fc_instance, unsigned int oldListLen, gboolean doIn
     /* if so, reset CWND to 2*MTU                                         */
     fc_reset_cwnd(destination);
 
+    fc_update_pacing_rate(fc, destination);
+    adl_gettime(&now);
+    packet_size = 0;
+
     while (fc_send_okay(fc, dat, destination, total_size, obpa) == TRUE) {
 
+        /* a paced path must wait for its slot before a new packet is started, */
+        /* the first packet of a fast retransmission is never held back        */
+        if (fc->doing_retransmission == FALSE &&
+            (packet_size == 0 || packet_size + dat->chunk_len > fc->cparams[destination].mtu)) {
+            if (fc_pacing_allows(fc, destination, &now) == FALSE) {
+                fc_start_pacing_timer(fc, destination, &now);
+                break;
+            }
+            packet_size = 0;
+        }
+        packet_size += dat->chunk_len;
+        fc_pacing_charge(fc, destination, dat->chunk_len, &now);
+
         /* size is used to see, whether we may send this next chunk, too */
         total_size += dat->chunk_len;
 
@@ -737,17 +1073,35 @@ int fc_check_for_txmit(void *fc_instance, unsigned int oldListLen, gboolean doIn
                     dat->ack_time, dat->num_of_transmissions);
         /* -------------------- DEBUGGING --------------------------------------- */
 
+        /* the last chunk before the queue runs empty, and all data during a shutdown,
+           ask the peer for a SACK without delay (I-bit, RFC 7053) */
+        if (g_list_next(fc->chunk_list) == NULL || fc->shutdown_received == TRUE ||
+            sci_shutdown_procedure_started() == TRUE)
+            ((SCTP_data_chunk*)dat->data)->chunk_flags |= SCTP_DATA_SACK_IMMEDIATELY;
+
         bu_put_Data_Chunk((SCTP_simple_chunk *) dat->data, &destination);
         data_is_submitted = TRUE;
+        paths_used |= (1u << destination);
         adl_gettime(&(fc->cparams[destination].last_send_time));
+        if (fc->cc->on_send != NULL) fc->cc->on_send(&(fc->cparams[destination]), dat->chunk_len);
 
         /* -------------------- DEBUGGING --------------------------------------- */
         event_logi(VERBOSE, "sent chunk (tsn=%u) to bundling", dat->chunk_tsn);
+        trc_event(SCTP_TRACE_MODULE_FLOWCONTROL, TRC_DATA_SENT, fc->my_association,
+                  dat->chunk_tsn, dat->chunk_len);
+        stats = mdi_readStatistics();
+        stats->dataChunksSent++;
+        if (dat->num_of_transmissions > 0) stats->retransmittedChunks++;
+        if ((pathStats = mdi_readPathStatistics((short)destination)) != NULL) {
+            pathStats->dataChunksSent++;
+            if (dat->num_of_transmissions > 0) pathStats->retransmittedChunks++;
+        }
         event_log(VVERBOSE, "=======###======== Calling fc_update_chunk_data =========###========");
         /* -------------------- DEBUGGING --------------------------------------- */
 
         fc_update_chunk_data(fc, dat, destination);
         if (dat->num_of_transmissions == 1) {
+            if (after(dat->sched_tag, fc->virtual_time)) fc->virtual_time = dat->sched_tag;
             adl_gettime(&(dat->transmission_time));
             event_log(INTERNAL_EVENT_0, "Storing chunk in retransmission list -> calling rtx_save_retrans");
             rtx_save_retrans_chunks(dat);
@@ -765,14 +1119,21 @@ int fc_check_for_txmit(void *fc_instance, unsigned int oldListLen, gboolean doIn
             if (dat->num_of_transmissions >= 1)    data_is_retransmitted = TRUE;
             else if (dat->num_of_transmissions == 0) data_is_retransmitted = FALSE;
             oldDestination = destination;
-            destination = fc_select_destination(fc, dat, (unsigned char)data_is_retransmitted, &destination);
+            if (cmt == TRUE && data_is_retransmitted == FALSE && dat->initial_destination == -1)
+                destination = fc_cmt_select_destination(fc, destination, total_size);
+            else
+                destination = fc_select_destination(fc, dat, (unsigned char)data_is_retransmitted, &destination);
             if (destination != oldDestination) {
+                /* chunks in the bundling buffer must go out to their own destination */
+                bu_flushDataChunks(&oldDestination);
                 obpa = rtx_get_obpa(destination, &fc->outstanding_bytes);
                 if (obpa < 0) {
                     error_log(ERROR_MAJOR, "rtx_get_obpa error !");
                     break;
                 }
                 total_size = 0;
+                packet_size = 0;
+                fc_update_pacing_rate(fc, destination);
             }
             event_logii(VERBOSE, "Called fc_select_destination == %d, obpa = %d \n", destination, obpa);
 
@@ -799,27 +1160,13 @@ int fc_check_for_txmit(void *fc_instance, unsigned int oldListLen, gboolean doIn
     /* fc_debug_cparams(VVERBOSE);*/
     /* ------------------ DEBUGGING ----------------------------- */
 
-    if (fc->T3_timer[destination] == 0) { /* see section 5.1 */
-
-        fc->T3_timer[destination] =  adl_startTimer(pm_readRTO((short)destination),
-                                                    &fc_timer_cb_t3_timeout,
-                                                    TIMER_TYPE_RTXM,
-                                                   &(fc->my_association),
-                                                    &(fc->addresses[destination]));
-
-        event_logiii(INTERNAL_EVENT_0,
-                     "fc_check_for_transmit: started T3 Timer with RTO(%u)==%u msecs on address %u",
-                     destination, pm_readRTO((short)destination), fc->addresses[destination]);
-    } else {
-        /* restart only if lowest TSN is being retransmitted, else leave running */
-        /* see section 6.1 */
-        if (lowest_tsn_is_retransmitted) {
-            event_logiii(INTERNAL_EVENT_0,
-                         "RTX of lowest TSN: Restarted T3 Timer with RTO(%u)==%u msecs on address %u",
-                         destination, pm_readRTO((short)destination), fc->addresses[destination]);
-
-            fc->T3_timer[destination] =  adl_restartTimer(fc->T3_timer[destination], pm_readRTO((short)destination));
+    /* with CMT, every path that got data in this round needs its T3 timer */
+    if (cmt == TRUE && paths_used != 0) {
+        for (count = 0; count < fc->number_of_addresses; count++) {
+            if (paths_used & (1u << count)) fc_start_t3(fc, count, lowest_tsn_is_retransmitted);
         }
+    } else {
+        fc_start_t3(fc, destination, lowest_tsn_is_retransmitted);
     }
 
     len = fc->list_length;
@@ -902,16 +1249,12 @@ void fc_check_t3(unsigned int ad_idx, boolean all_acked, boolean new_acked)
         /* 6.2.4.4) Restart T3, if SACK acked lowest outstanding tsn, OR
          *                      we are retransmitting the first outstanding data chunk
          */
-        if (fc->T3_timer[ad_idx] != 0) {
-            fc->T3_timer[ad_idx] =
-                adl_restartTimer(fc->T3_timer[ad_idx], pm_readRTO((short)ad_idx));
+        /* this only moves the deadline, in most cases the running timer is left alone */
+        if (fc_set_t3_deadline(fc, ad_idx) == FALSE) {
             event_logii(INTERNAL_EVENT_0,
                         "Restarted T3 Timer with RTO==%u msecs on address %u",
                         pm_readRTO((short)ad_idx), ad_idx);
         } else {
-            fc->T3_timer[ad_idx] =
-                adl_startTimer(pm_readRTO((short)ad_idx), &fc_timer_cb_t3_timeout, TIMER_TYPE_RTXM,
-                                &(fc->my_association), &(fc->addresses[ad_idx]));
             event_logii(INTERNAL_EVENT_0,
                         "Started T3 Timer with RTO==%u msecs on address %u",
                         pm_readRTO((short)ad_idx), ad_idx);
@@ -924,6 +1267,139 @@ void fc_check_t3(unsigned int ad_idx, boolean all_acked, boolean new_acked)
     return;
 }
 
+/*
+  runs the T3 checks after a SACK : with CMT on every path, with the pseudo-cumack
+  of the path deciding about a restart, else on the path the SACK came in on
+*/
+static void fc_check_t3_after_sack(fc_data * fc, unsigned int ad_idx, boolean all_acked, boolean new_acked)
+{
+    unsigned int count;
+    gboolean advanced;
+
+    if (mdi_usesCMT() == FALSE || all_acked == TRUE) {
+        fc_check_t3(ad_idx, all_acked, new_acked);
+        return;
+    }
+    for (count = 0; count < fc->number_of_addresses; count++) {
+        rtx_readNewlyAckedBytes(count, &advanced);
+        if (fc->T3_timer[count] != 0 || advanced == TRUE)
+            fc_check_t3(count, all_acked, advanced);
+    }
+}
+
+/**
+ * returns the scheduling state of an outbound stream, which is created on first use
+ * @param fc    current flowcontrol instance
+ * @param sid   stream id
+ */
+static ss_stream* fc_stream(fc_data * fc, unsigned int sid)
+{
+    unsigned int count;
+
+    if (sid >= fc->num_streams) {
+        fc->streams = (ss_stream*)realloc(fc->streams, (sid + 1) * sizeof(ss_stream));
+        if (!fc->streams)
+            error_log(ERROR_FATAL, "Malloc failed");
+        for (count = fc->num_streams; count <= sid; count++) {
+            fc->streams[count].priority = SS_DEFAULT_PRIORITY;
+            fc->streams[count].weight = SS_DEFAULT_WEIGHT;
+            fc->streams[count].start_tag = fc->virtual_time;
+            fc->streams[count].finish_tag = fc->virtual_time;
+        }
+        fc->num_streams = sid + 1;
+    }
+    return &(fc->streams[sid]);
+}
+
+/**
+ * @return TRUE, if the stream scheduler sends chunk one after chunk two
+ */
+static gboolean fc_scheduled_after(chunk_data * one, chunk_data * two)
+{
+    if (one->sched_priority != two->sched_priority) return (one->sched_priority > two->sched_priority);
+    return after(one->sched_tag, two->sched_tag);
+}
+
+/**
+ * queues a new chunk in the order of the stream scheduler. A scheduling unit is an
+ * I-DATA chunk, or a whole DATA message, as the fragments of a DATA message need
+ * consecutive TSNs. As unsent chunks have not used their TSN yet, the TSNs are
+ * reassigned in queue order.
+ * @param fc    current flowcontrol instance
+ * @param dat   the chunk to be queued
+ */
+static void fc_schedule_chunk(fc_data * fc, chunk_data * dat)
+{
+    GList *pos, *next, *tmp;
+    chunk_data *other;
+    SCTP_data_chunk *s_chunk;
+    ss_stream *stream;
+    unsigned int tsn;
+    gboolean idata;
+
+    s_chunk = (SCTP_data_chunk*)dat->data;
+    idata = (s_chunk->chunk_id == CHUNK_IDATA);
+
+    if (fc->ss->cost == NULL) {
+        /* first come, first served : early TSN assignment, insert chunk at the list's tail */
+        s_chunk->tsn = htonl(fc->current_tsn++);
+        dat->chunk_tsn = ntohl(s_chunk->tsn);
+        dat->sched_priority = 0;
+        dat->sched_tag = fc->virtual_time;
+        fc->chunk_list = g_list_append(fc->chunk_list, dat);
+        return;
+    }
+
+    stream = fc_stream(fc, ntohs(s_chunk->stream_id));
+    if (idata || (s_chunk->chunk_flags & SCTP_DATA_BEGIN_SEGMENT)) {
+        /* a new unit starts at the stream's finish tag, an idle stream joins in at once */
+        stream->start_tag = after(stream->finish_tag, fc->virtual_time) ? stream->finish_tag : fc->virtual_time;
+    }
+    stream->finish_tag = stream->start_tag + fc->ss->cost(stream, dat->chunk_len);
+    dat->sched_tag = stream->start_tag;
+    dat->sched_priority = fc->ss->uses_priority ? stream->priority : 0;
+
+    /* insert the chunk behind the last unsent chunk, that the scheduler sends before it */
+    pos = g_list_last(fc->chunk_list);
+    while (pos != NULL) {
+        other = (chunk_data*)pos->data;
+        if (other->num_of_transmissions > 0 || !fc_scheduled_after(other, dat)) break;
+        pos = g_list_previous(pos);
+    }
+    next = (pos == NULL) ? fc->chunk_list : g_list_next(pos);
+    if (!idata) {
+        /* do not split a DATA message, that has been started already */
+        while (next != NULL) {
+            other = (chunk_data*)next->data;
+            if (other->num_of_transmissions > 0 ||
+                (((SCTP_data_chunk*)other->data)->chunk_flags & SCTP_DATA_BEGIN_SEGMENT)) break;
+            pos = next;
+            next = g_list_next(next);
+        }
+    }
+    if (pos == NULL) {
+        fc->chunk_list = g_list_prepend(fc->chunk_list, dat);
+        tmp = fc->chunk_list;
+    } else {
+        fc->chunk_list = g_list_insert_before(fc->chunk_list, next, dat);
+        tmp = g_list_next(pos);
+    }
+
+    /* the chunk takes over the TSN of its successor, the later ones move up by one */
+    if (g_list_next(tmp) != NULL)
+        tsn = ((chunk_data*)g_list_next(tmp)->data)->chunk_tsn;
+    else
+        tsn = fc->current_tsn;
+    for (; tmp != NULL; tmp = g_list_next(tmp)) {
+        other = (chunk_data*)tmp->data;
+        other->chunk_tsn = tsn++;
+        ((SCTP_data_chunk*)other->data)->tsn = htonl(other->chunk_tsn);
+    }
+    fc->current_tsn = tsn;
+    event_logiiii(VVERBOSE, "fc_schedule_chunk: queued chunk of stream %u with priority %u, tag %u, tsn=%u",
+                  ntohs(s_chunk->stream_id), dat->sched_priority, dat->sched_tag, dat->chunk_tsn);
+}
+
 /**
  * Function called by stream engine to enqueue data chunks in the flowcontrol
  * module. After function returns, we should be able to  delete the pointer
@@ -970,10 +1446,8 @@ int fc_send_data_chunk(chunk_data * chunkd,
 
     s_chunk = (SCTP_data_chunk*)chunkd->data;
 
-    /* early TSN assignment */
-    s_chunk->tsn        =  htonl(fc->current_tsn++);
     chunkd->chunk_len   = CHUNKP_LENGTH(s_chunk);
-    chunkd->chunk_tsn   = ntohl(s_chunk->tsn);
+    mdi_chargeMemory(chunkd->chunk_len);
     chunkd->gap_reports = 0L;
     chunkd->ack_time    = 0;
     chunkd->context     = context;
@@ -1000,119 +1474,222 @@ int fc_send_data_chunk(chunk_data * chunkd,
     chunkd->dontBundle           = dontBundle;
     chunkd->num_of_transmissions = 0;
 
-    /* insert chunk at the list's tail */
-    fc->chunk_list = g_list_append(fc->chunk_list, chunkd);
+    /* the TSN is assigned when the chunk gets its place in the queue */
+    fc_schedule_chunk(fc, chunkd);
     fc->list_length++;
     event_log(VVERBOSE, "Printing Chunk List / Congestion Params in  fc_send_data_chunk - after");
     chunk_list_debug(VVERBOSE, fc->chunk_list);
 
-    fc_check_for_txmit(fc, fc->list_length, FALSE);
+    fc->cork_bytes += chunkd->chunk_len;
+    fc_send_queued(fc, fc->list_length);
 
     return SCTP_SUCCESS;
 }
 
-
-int fc_dequeue_acked_chunks(unsigned int ctsna)
+/**
+ * Chunks queued from now on are not sent, until fc_release_transmission() is called.
+ * Calls may be nested.
+ */
+void fc_hold_transmission(void)
 {
-    chunk_data *dat = NULL;
-    GList* tmp = NULL;
-    fc_data *fc = NULL;
+    fc_data *fc = (fc_data *) mdi_readFlowControl();
 
-    fc = (fc_data *) mdi_readFlowControl();
     if (!fc) {
-        error_log(ERROR_FATAL, "fc_data instance not set in fc_dequeue_acked_chunks !");
-        return (-1);
-    }
-
-    tmp = g_list_first(fc->chunk_list);
-
-    while (tmp != NULL) {
-        dat = (chunk_data*)tmp->data;
-         if (before(dat->chunk_tsn, ctsna) || (dat->chunk_tsn == ctsna)) {
-            tmp = g_list_next(tmp);
-            fc->chunk_list = g_list_remove(fc->chunk_list, (gpointer) dat);
-            fc->list_length--;
-            event_logii(INTERNAL_EVENT_0, "Removed chunk %u from Flowcontrol-List, Listlength now %u",
-                dat->chunk_tsn, fc->list_length);
-        } else
-            break;
+        error_log(ERROR_MAJOR, "fc_data instance not set !");
+        return;
     }
-
-    return 0;
+    if (fc->hold_count == 0) fc->hold_list_length = fc->list_length;
+    fc->hold_count++;
 }
 
-int fc_adjustCounters(fc_data *fc, unsigned int addressIndex,
-                      unsigned int num_acked,
-                      gboolean all_data_acked,
-                      gboolean new_data_acked,
-                      unsigned int number_of_addresses)
-
+/**
+ * Ends a fc_hold_transmission(), and sends the chunks queued in the meantime,
+ * as far as the windows allow
+ */
+void fc_release_transmission(void)
 {
-    unsigned int count;
-    int diff;
-    struct timeval last_update, now;
-    unsigned int rtt_time;
-
-    fc->outstanding_bytes = (fc->outstanding_bytes <= num_acked) ? 0 : (fc->outstanding_bytes - num_acked);
-    /* see section 6.2.1, section 6.2.2 */
-    if (fc->cparams[addressIndex].cwnd <= fc->cparams[addressIndex].ssthresh) { /* SLOW START */
-        for (count = 0; count < number_of_addresses; count++) {
-            fc->cparams[count].partial_bytes_acked = 0;
-        }
-
-       if (new_data_acked == TRUE) {
-           fc->cparams[addressIndex].cwnd += min(MAX_MTU_SIZE, num_acked);
-           adl_gettime(&(fc->cparams[addressIndex].time_of_cwnd_adjustment));
-       }
-
-    } else {                    /* CONGESTION AVOIDANCE, as per section 6.2.2 */
-        if (new_data_acked == TRUE) {
-            fc->cparams[addressIndex].partial_bytes_acked += num_acked;
-            event_logii(VVERBOSE, "CONG. AVOIDANCE : new data acked: increase PBA(%u) to %u",
-                addressIndex, fc->cparams[addressIndex].partial_bytes_acked);
-        }
-        /*
-         * Section 7.2.2 :
-         * "When partial_bytes_acked is equal to or greater than cwnd and
-         * before the arrival of the SACK the sender had cwnd or more bytes
-         * of data outstanding (i.e., before arrival of the SACK, flightsize
-         * was greater than or equal to cwnd), increase cwnd by MTU, and
-         * reset partial_bytes_acked to (partial_bytes_acked - cwnd)."
-         */
-        rtt_time = pm_readSRTT((short)addressIndex);
-        last_update = fc->cparams[addressIndex].time_of_cwnd_adjustment;
-        adl_add_msecs_totime(&last_update, rtt_time);
-        adl_gettime(&now);
-        diff = adl_timediff_to_msecs(&now, &last_update); /* a-b */
-        event_logii(VVERBOSE, "CONG. AVOIDANCE : rtt_time=%u diff=%d", rtt_time, diff);
-
-        if (diff >= 0) {
-            if ((fc->cparams[addressIndex].partial_bytes_acked >= fc->cparams[addressIndex].cwnd)
-                && (fc->outstanding_bytes >= fc->cparams[addressIndex].cwnd)) {
-                fc->cparams[addressIndex].cwnd += MAX_MTU_SIZE;
-                fc->cparams[addressIndex].partial_bytes_acked -= fc->cparams[addressIndex].cwnd;
-                /* update time of window adjustment (i.e. now) */
-                event_log(VVERBOSE,
-                          "CONG. AVOIDANCE : updating time of adjustment !!!!!!!!!! NOW ! ");
-                adl_gettime(&(fc->cparams[addressIndex].time_of_cwnd_adjustment));
-            }
-            event_logii(VERBOSE, "CONG. AVOIDANCE : updated counters: %u bytes outstanding, cwnd=%u",
-                        fc->outstanding_bytes, fc->cparams[addressIndex].cwnd);
-        }
-
-        event_logii(VVERBOSE, "CONG. AVOIDANCE : partial_bytes_acked(%u)=%u ",
-                    addressIndex, fc->cparams[addressIndex].partial_bytes_acked);
-
-        /* see section 7.2.2 */
-        if (all_data_acked == TRUE) fc->cparams[addressIndex].partial_bytes_acked = 0;
+    fc_data *fc = (fc_data *) mdi_readFlowControl();
 
+    if (!fc) {
+        error_log(ERROR_MAJOR, "fc_data instance not set !");
+        return;
     }
-    return SCTP_SUCCESS;
+    if (fc->hold_count == 0) return;
+    fc->hold_count--;
+    if (fc->hold_count == 0) fc_send_queued(fc, fc->hold_list_length);
 }
 
-
 /**
- * function called by Reliable Transfer, when it requests retransmission
+ * timer callback, that sends corked data, which has waited for cork_delay msecs
+ *  @param  tid the id of the timer that has gone off
+ *  @param  assoc  pointer to the association structure to which this timer belongs
+ *  @param  data2  unused
+ */
+void fc_timer_cb_cork(TimerID tid, void *assoc, void *data2)
+{
+    fc_data *fc;
+    unsigned int res;
+
+    res = mdi_setAssociationData(*(unsigned int *) assoc);
+    if (res == 1) {
+        error_log(ERROR_MAJOR, " association does not exist !");
+        return;
+    }
+    if (res == 2) {
+        error_log(ERROR_MAJOR, "Association was not cleared..... !!!");
+    }
+    fc = (fc_data *) mdi_readFlowControl();
+    if (!fc) {
+        error_log(ERROR_MAJOR, "fc_data instance not set !");
+        mdi_clearAssociationData();
+        return;
+    }
+    fc->cork_timer = 0;
+    event_logi(VVERBOSE, "fc_timer_cb_cork: sending %u corked bytes", fc->cork_bytes);
+    fc->cork_bytes = 0;
+    if (fc->chunk_list != NULL) {
+        fc_check_for_txmit(fc, fc->list_length, FALSE);
+    }
+    mdi_clearAssociationData();
+}
+
+/**
+ * checks, whether corking holds back the data queued since the last transmission :
+ * this is the case until a packet can be filled. Starts the cork timer, that sends
+ * the data at the latest after cork_delay msecs.
+ * @return TRUE if queued data is not sent now
+ */
+static gboolean fc_cork_holds(fc_data * fc)
+{
+    if (fc->corked == FALSE && fc->more == FALSE) return FALSE;
+    if (fc->cork_bytes >= fc_readMaxDataLength(-1)) return FALSE;
+    if (fc->cork_timer == 0) {
+        fc->cork_timer = adl_startTimer(fc->cork_delay, &fc_timer_cb_cork, TIMER_TYPE_CWND,
+                                        &(fc->my_association), NULL);
+    }
+    return TRUE;
+}
+
+/**
+ * sends the queued data, unless the transmission is held or corked
+ * @param oldListLen  length of the send queue before the new data was queued
+ */
+static void fc_send_queued(fc_data * fc, unsigned int oldListLen)
+{
+    if (fc->hold_count > 0 || fc_cork_holds(fc) == TRUE) return;
+    if (fc->cork_timer != 0) {
+        sctp_stopTimer(fc->cork_timer);
+        fc->cork_timer = 0;
+    }
+    fc->cork_bytes = 0;
+    if (fc->chunk_list != NULL) fc_check_for_txmit(fc, oldListLen, FALSE);
+}
+
+/**
+ * corks or uncorks the association : uncorking sends the data, that has been held back,
+ * also when the last message announced more data (SCTP_SEND_MORE)
+ */
+void fc_set_cork(gboolean corked)
+{
+    fc_data *fc = (fc_data *) mdi_readFlowControl();
+
+    if (!fc) {
+        error_log(ERROR_MAJOR, "fc_data instance not set !");
+        return;
+    }
+    fc->corked = corked;
+    if (corked == FALSE) {
+        fc->more = FALSE;
+        fc_send_queued(fc, fc->list_length);
+    }
+}
+
+/**
+ * notes, whether the ULP announced more data with the message, that is queued next
+ */
+void fc_set_more(gboolean more)
+{
+    fc_data *fc = (fc_data *) mdi_readFlowControl();
+
+    if (!fc) {
+        error_log(ERROR_MAJOR, "fc_data instance not set !");
+        return;
+    }
+    fc->more = more;
+}
+
+
+int fc_dequeue_acked_chunks(unsigned int ctsna)
+{
+    chunk_data *dat = NULL;
+    GList* tmp = NULL;
+    fc_data *fc = NULL;
+
+    fc = (fc_data *) mdi_readFlowControl();
+    if (!fc) {
+        error_log(ERROR_FATAL, "fc_data instance not set in fc_dequeue_acked_chunks !");
+        return (-1);
+    }
+
+    tmp = g_list_first(fc->chunk_list);
+
+    while (tmp != NULL) {
+        dat = (chunk_data*)tmp->data;
+         if (before(dat->chunk_tsn, ctsna) || (dat->chunk_tsn == ctsna)) {
+            tmp = g_list_next(tmp);
+            fc->chunk_list = g_list_remove(fc->chunk_list, (gpointer) dat);
+            fc->list_length--;
+            event_logii(INTERNAL_EVENT_0, "Removed chunk %u from Flowcontrol-List, Listlength now %u",
+                dat->chunk_tsn, fc->list_length);
+        } else
+            break;
+    }
+
+    return 0;
+}
+
+int fc_adjustCounters(fc_data *fc, unsigned int addressIndex,
+                      unsigned int num_acked,
+                      gboolean all_data_acked,
+                      gboolean new_data_acked,
+                      unsigned int number_of_addresses)
+
+{
+    unsigned int count, acked, total;
+    gboolean advanced;
+    int obpa;
+
+    fc->outstanding_bytes = (fc->outstanding_bytes <= num_acked) ? 0 : (fc->outstanding_bytes - num_acked);
+
+    if (mdi_usesCMT() == TRUE) {
+        /* CMT : each path's cwnd grows with the bytes acked on that path, and in congestion */
+        /* avoidance only when its pseudo-cumack advanced (cwnd update for CMT, CUC)       */
+        for (count = 0; count < number_of_addresses; count++) {
+            acked = rtx_readNewlyAckedBytes(count, &advanced);
+            if (acked == 0) continue;
+            obpa = rtx_get_obpa(count, &total);
+            if (obpa < 0) obpa = 0;
+            if (fc->cparams[count].cwnd <= fc->cparams[count].ssthresh)
+                fc->cparams[count].partial_bytes_acked = 0;
+            fc->cc->on_ack(&(fc->cparams[count]), acked, advanced, all_data_acked,
+                           (unsigned int)obpa, pm_readSRTT((short)count));
+        }
+        return SCTP_SUCCESS;
+    }
+    /* see section 6.2.1, section 6.2.2 */
+    if (fc->cparams[addressIndex].cwnd <= fc->cparams[addressIndex].ssthresh) { /* SLOW START */
+        for (count = 0; count < number_of_addresses; count++) {
+            fc->cparams[count].partial_bytes_acked = 0;
+        }
+    }
+    fc->cc->on_ack(&(fc->cparams[addressIndex]), num_acked, new_data_acked, all_data_acked,
+                   fc->outstanding_bytes, pm_readSRTT((short)addressIndex));
+    return SCTP_SUCCESS;
+}
+
+
+/**
+ * function called by Reliable Transfer, when it requests retransmission
  * in SDL diagram this signal is called (Req_RTX, RetransChunks)
  * @param  all_data_acked indicates whether or not all data chunks have been acked
  * @param   new_data_acked indicates whether or not new data has been acked
@@ -1131,7 +1708,8 @@ int fc_fast_retransmission(unsigned int address_index, unsigned int arwnd, unsig
 {
     fc_data *fc;
     int count, result;
-    unsigned int oldListLen, peer_rwnd;
+    unsigned int oldListLen, peer_rwnd, path;
+    guint32 lossPaths = 0;
 
     fc = (fc_data *) mdi_readFlowControl();
     if (!fc) {
@@ -1161,11 +1739,17 @@ int fc_fast_retransmission(unsigned int address_index, unsigned int arwnd, unsig
     /* We HAVE retransmission, so DO UPDATE OF WINDOW PARAMETERS unless we are in fast recovery, */
     /* see sections 7.2.3 and 7.2.4 and the implementors guide */
     if (rtx_is_in_fast_recovery() == FALSE) {
-        fc->cparams[address_index].ssthresh =
-            max(fc->cparams[address_index].cwnd / 2, 2 * fc->cparams[address_index].mtu);
-        fc->cparams[address_index].cwnd = fc->cparams[address_index].ssthresh;
-        /* as per implementor's guide */
-        fc->cparams[address_index].partial_bytes_acked = 0;
+        if (mdi_usesCMT() == TRUE) {
+            /* CMT : reduce cwnd once on each path, that lost one of the chunks */
+            for (count = 0; count < number_of_rtx_chunks; count++) {
+                path = chunks[count]->last_destination;
+                if (path >= fc->number_of_addresses || (lossPaths & (1u << path))) continue;
+                lossPaths |= (1u << path);
+                fc->cc->on_loss(&(fc->cparams[path]));
+            }
+        } else {
+            fc->cc->on_loss(&(fc->cparams[address_index]));
+        }
         rtx_enter_fast_recovery();
     }
     event_logiii(VERBOSE, "fc_fast_retransmission: updated: %u bytes outstanding,cwnd=%u, ssthresh=%u",
@@ -1191,7 +1775,7 @@ int fc_fast_retransmission(unsigned int address_index, unsigned int arwnd, unsig
     chunk_list_debug(VVERBOSE, fc->chunk_list);
     /* ------------------ DEBUGGING ----------------------------- */
 
-    fc_check_t3(address_index, all_data_acked, new_data_acked);
+    fc_check_t3_after_sack(fc, address_index, all_data_acked, new_data_acked);
 
     /* section 6.2.1.D ?? */
     if (arwnd >= fc->outstanding_bytes) {
@@ -1221,6 +1805,50 @@ int fc_fast_retransmission(unsigned int address_index, unsigned int arwnd, unsig
 }     /* end: fc_fast_retransmission */
 
 
+/**
+ * processes an ECNE chunk received from the peer : the congestion window of the path
+ * the ECNE came from is reduced like on a packet loss, but at most once per window of
+ * data, and a CWR chunk tells the peer that the reduction for this TSN has been done.
+ * @param  chunk  pointer to the ECNE chunk
+ * @param  address_index  index of the path the ECNE chunk arrived from
+ * @return  -1 on error, 0 on success
+ */
+int fc_process_ecne(void* chunk, unsigned int address_index)
+{
+    fc_data *fc;
+    SCTP_ecn_chunk cwr;
+    unsigned int ecne_tsn;
+
+    fc = (fc_data *) mdi_readFlowControl();
+    if (!fc) {
+        error_log(ERROR_MAJOR, "fc_data instance not set !");
+        return (-1);
+    }
+    ecne_tsn = ntohl(((SCTP_ecn_chunk *) chunk)->tsn);
+    if (address_index >= fc->number_of_addresses) address_index = 0;
+
+    if (fc->ecn_reduced == FALSE || after(ecne_tsn, fc->ecn_recover_tsn)) {
+        fc->cc->on_loss(&(fc->cparams[address_index]));
+        fc->ecn_reduced = TRUE;
+        fc->ecn_recover_tsn = fc->current_tsn - 1;
+        event_logiiii(INTERNAL_EVENT_0, "fc_process_ecne: ECNE for TSN %u on path %u, cwnd=%u, ssthresh=%u",
+                      ecne_tsn, address_index, fc->cparams[address_index].cwnd,
+                      fc->cparams[address_index].ssthresh);
+    } else {
+        event_logii(VERBOSE, "fc_process_ecne: ECNE for TSN %u, already reduced up to TSN %u",
+                    ecne_tsn, fc->ecn_recover_tsn);
+    }
+
+    cwr.chunk_header.chunk_id = CHUNK_CWR;
+    cwr.chunk_header.chunk_flags = 0;
+    cwr.chunk_header.chunk_length = htons(sizeof(SCTP_ecn_chunk));
+    cwr.tsn = htonl(ecne_tsn);
+    bu_put_Ctrl_Chunk((SCTP_simple_chunk *) &cwr, &address_index);
+    bu_sendAllChunks(&address_index);
+    return 0;
+}
+
+
 /**
  * function called by Reliable Transfer, after it has got a SACK chunk
  * in SDL diagram this signal is called SACK_Info
@@ -1258,7 +1886,7 @@ void fc_sack_info(unsigned int address_index, unsigned int arwnd,unsigned int ct
     fc_adjustCounters(fc, address_index, num_acked, all_data_acked, new_data_acked,
                       number_of_addresses);
 
-    fc_check_t3(address_index, all_data_acked, new_data_acked);
+    fc_check_t3_after_sack(fc, address_index, all_data_acked, new_data_acked);
 
     if (fc->outstanding_bytes == 0) {
         fc->one_packet_inflight = FALSE;
@@ -1338,6 +1966,8 @@ int fc_dequeueOldestUnsentChunk(unsigned char *buf, unsigned int *len, unsigned
     chunk_data *dat = NULL;
     GList *tmp = NULL;
     SCTP_data_chunk* dchunk;
+    SCTP_idata_chunk* ichunk;
+    unsigned int hlen;
     int listlen;
 
     fc = (fc_data *) mdi_readFlowControl();
@@ -1360,22 +1990,31 @@ int fc_dequeueOldestUnsentChunk(unsigned char *buf, unsigned int *len, unsigned
         /* should be a sorted list, and not happen here */
         } else break;
     }
-    if ((*len) <  (dat->chunk_len - FIXED_DATA_CHUNK_SIZE)) return SCTP_BUFFER_TOO_SMALL;
+    dchunk = (SCTP_data_chunk*) dat->data;
+    hlen = DATA_CHUNK_HEADER_SIZE(dchunk->chunk_id);
+    if ((*len) <  (dat->chunk_len - hlen)) return SCTP_BUFFER_TOO_SMALL;
 
     event_logii(VVERBOSE, "fc_dequeueOldestUnsentChunks(): returning chunk tsn=%u, num_rtx=%u ", dat->chunk_tsn, dat->num_of_transmissions);
 
-    dchunk = (SCTP_data_chunk*) dat->data;
-    *len = dat->chunk_len - FIXED_DATA_CHUNK_SIZE;
-    memcpy(buf, dchunk->data, dat->chunk_len - FIXED_DATA_CHUNK_SIZE);
+    *len = dat->chunk_len - hlen;
+    memcpy(buf, &dat->data[hlen], dat->chunk_len - hlen);
     *tsn = dat->chunk_tsn;
     *sID = ntohs(dchunk->stream_id);
-    *sSN = ntohs(dchunk->stream_sn);
-    *pID = dchunk->protocolId;
-    *flags = dchunk->chunk_flags;
+    if (dchunk->chunk_id == CHUNK_IDATA) {
+        /* the lower bits of the message id stand in for the stream sequence number */
+        ichunk = (SCTP_idata_chunk*) dat->data;
+        *sSN = (unsigned short)ntohl(ichunk->message_id);
+        *pID = (ichunk->chunk_flags & SCTP_DATA_BEGIN_SEGMENT) ? ichunk->ppid_fsn : 0;
+    } else {
+        *sSN = ntohs(dchunk->stream_sn);
+        *pID = dchunk->protocolId;
+    }
+    *flags = dchunk->chunk_flags & ~SCTP_DATA_SACK_IMMEDIATELY;
     *ctx = dat->context;
     fc->chunk_list = g_list_remove(fc->chunk_list, (gpointer) dat);
     fc->list_length--;
     /* be careful ! data may only be freed once: this module ONLY takes care of untransmitted chunks */
+    mdi_releaseMemory(dat->chunk_len);
     free(dat);
     event_log(VVERBOSE, "fc_dequeueOldestUnsentChunks(): checking list");
     chunk_list_debug(VVERBOSE, fc->chunk_list);
@@ -1502,6 +2141,62 @@ int fc_readSsthresh(short path_id)
     return (int)fc->cparams[path_id].ssthresh;
 }
 
+/**
+ * Sets the MTU of a path, i.e. the size of the largest packet that may be sent to it.
+ * New data is fragmented according to the new value, queued chunks keep their size.
+ * @param path_id    path index of which the mtu is set
+ * @param mtu        new MTU in bytes, including IP and SCTP common header
+ * @return SCTP_SUCCESS, or an error code
+ */
+int fc_setMTU(short path_id, unsigned int mtu)
+{
+    fc_data *fc;
+    fc = (fc_data *) mdi_readFlowControl();
+
+    if (!fc) {
+        error_log(ERROR_MAJOR, "flow control instance not set !");
+        return SCTP_MODULE_NOT_FOUND;
+    }
+    if ((unsigned int)path_id >= fc->number_of_addresses || path_id < 0) {
+        error_logi(ERROR_MAJOR, "Association has only %u addresses !!! ", fc->number_of_addresses);
+        return SCTP_PARAMETER_PROBLEM;
+    }
+    if (mtu < MIN_MTU_SIZE || mtu > MAX_MTU_SIZE) return SCTP_PARAMETER_PROBLEM;
+
+    fc->cparams[path_id].mtu = mtu - IP_HEADERLENGTH - sizeof(SCTP_common_header);
+    /* a smaller MTU must not leave the window below what section 7.2.3 allows */
+    if (fc->cparams[path_id].ssthresh < 2 * fc->cparams[path_id].mtu)
+        fc->cparams[path_id].ssthresh = 2 * fc->cparams[path_id].mtu;
+    event_logii(VERBOSE, "fc_setMTU: path %d now has mtu %u", path_id, mtu);
+    return SCTP_SUCCESS;
+}
+
+/**
+ * Returns the largest amount of user data that fits into one DATA chunk.
+ * The same headroom below the packet size is kept, that SCTP_MAXIMUM_DATA_LENGTH
+ * leaves at the default MTU, so that a SACK may still be bundled.
+ * @param path_id    destination of the data, or -1 if the data may go to any path
+ * @return number of bytes of user data per DATA chunk
+ */
+unsigned int fc_readMaxDataLength(short path_id)
+{
+    fc_data *fc;
+    unsigned int count, pdu;
+
+    fc = (fc_data *) mdi_readFlowControl();
+    if (!fc) return SCTP_MAXIMUM_DATA_LENGTH;
+
+    if (path_id >= 0 && (unsigned int)path_id < fc->number_of_addresses) {
+        pdu = fc->cparams[path_id].mtu;
+    } else {
+        /* data may be sent or retransmitted on any path, so it must fit the smallest */
+        pdu = fc->cparams[0].mtu;
+        for (count = 1; count < fc->number_of_addresses; count++)
+            pdu = min(pdu, fc->cparams[count].mtu);
+    }
+    return pdu - (DEFAULT_SCTP_PDU - SCTP_MAXIMUM_DATA_LENGTH);
+}
+
 /**
  * Function returns mtu value of a certain path.
  * @param path_id    path index of which we want to know the mtu
@@ -1561,6 +2256,53 @@ int fc_readOutstandingBytes(void)
     return (int)fc->outstanding_bytes;
 }
 
+/**
+ * Function returns the pacing rate of a certain path.
+ * @param path_id    path index of which we want to know the pacing rate
+ * @return pacing rate in bytes per second, 0 if the path is not paced
+ */
+unsigned int fc_readPacingRate(short path_id)
+{
+    fc_data *fc;
+    fc = (fc_data *) mdi_readFlowControl();
+
+    if (!fc) {
+        error_log(ERROR_MAJOR, "flow control instance not set !");
+        return 0;
+    }
+    if ((unsigned int)path_id >= fc->number_of_addresses || path_id < 0) {
+        error_logi(ERROR_MAJOR, "Association has only %u addresses !!! ", fc->number_of_addresses);
+        return 0;
+    }
+    return fc->cparams[path_id].pacing_rate;
+}
+
+/**
+ * Function returns the time until pacing allows the next packet on a certain path.
+ * @param path_id    path index of which we want to know the pacing delay
+ * @return delay in microseconds, 0 if a packet may be sent now
+ */
+unsigned int fc_readPacingDelay(short path_id)
+{
+    fc_data *fc;
+    struct timeval now, delay;
+
+    fc = (fc_data *) mdi_readFlowControl();
+    if (!fc) {
+        error_log(ERROR_MAJOR, "flow control instance not set !");
+        return 0;
+    }
+    if ((unsigned int)path_id >= fc->number_of_addresses || path_id < 0) {
+        error_logi(ERROR_MAJOR, "Association has only %u addresses !!! ", fc->number_of_addresses);
+        return 0;
+    }
+    if (fc->cparams[path_id].pacing_rate == 0) return 0;
+    adl_gettime(&now);
+    if (!timercmp(&(fc->cparams[path_id].next_send_time), &now, >)) return 0;
+    timersub(&(fc->cparams[path_id].next_send_time), &now, &delay);
+    return (unsigned int)(delay.tv_sec * 1000000 + delay.tv_usec);
+}
+
 int fc_get_maxSendQueue(unsigned int * queueLen)
 {
     fc_data *fc;
@@ -1575,6 +2317,195 @@ int fc_get_maxSendQueue(unsigned int * queueLen)
 
 }
 
+int fc_get_congestionControl(unsigned int * algorithm)
+{
+    fc_data *fc;
+    fc = (fc_data *) mdi_readFlowControl();
+
+    if (!fc) {
+        error_log(ERROR_MAJOR, "flow control instance not set !");
+        return -1;
+    }
+    *algorithm = fc->cc->algorithm;
+    return 0;
+}
+
+int fc_set_congestionControl(unsigned int algorithm)
+{
+    fc_data *fc;
+    const cc_ops *cc;
+    unsigned int count;
+
+    fc = (fc_data *) mdi_readFlowControl();
+    if (!fc) {
+        error_log(ERROR_MAJOR, "flow control instance not set !");
+        return SCTP_MODULE_NOT_FOUND;
+    }
+    cc = cc_getModule(algorithm);
+    if (cc == NULL) {
+        error_logi(ERROR_MINOR, "fc_set_congestionControl: unknown algorithm %u", algorithm);
+        return SCTP_PARAMETER_PROBLEM;
+    }
+    if (cc == fc->cc) return SCTP_SUCCESS;
+
+    fc->cc = cc;
+    for (count = 0; count < fc->number_of_addresses; count++) {
+        fc->cc->on_init(&(fc->cparams[count]));
+    }
+    event_logi(VERBOSE, "fc_set_congestionControl(%s)", fc->cc->name);
+    return SCTP_SUCCESS;
+}
+
+int fc_get_pacingGain(unsigned int * gain)
+{
+    fc_data *fc;
+    fc = (fc_data *) mdi_readFlowControl();
+
+    if (!fc) {
+        error_log(ERROR_MAJOR, "flow control instance not set !");
+        return -1;
+    }
+    *gain = fc->pacing_gain;
+    return 0;
+}
+
+int fc_set_pacingGain(unsigned int gain)
+{
+    fc_data *fc;
+    unsigned int count;
+
+    fc = (fc_data *) mdi_readFlowControl();
+    if (!fc) {
+        error_log(ERROR_MAJOR, "flow control instance not set !");
+        return -1;
+    }
+    fc->pacing_gain = gain;
+    if (gain == 0) {
+        /* send what was held back by pacing right away */
+        for (count = 0; count < fc->number_of_addresses; count++) {
+            fc->cparams[count].pacing_rate = 0;
+            timerclear(&(fc->cparams[count].next_send_time));
+        }
+    }
+    event_logi(VERBOSE, "fc_set_pacingGain(%u)", gain);
+    return 0;
+}
+
+int fc_get_streamScheduler(unsigned int * scheduler)
+{
+    fc_data *fc;
+    fc = (fc_data *) mdi_readFlowControl();
+
+    if (!fc) {
+        error_log(ERROR_MAJOR, "flow control instance not set !");
+        return -1;
+    }
+    *scheduler = fc->ss->scheduler;
+    return 0;
+}
+
+int fc_set_streamScheduler(unsigned int scheduler)
+{
+    fc_data *fc;
+    const ss_ops *ss;
+
+    fc = (fc_data *) mdi_readFlowControl();
+    if (!fc) {
+        error_log(ERROR_MAJOR, "flow control instance not set !");
+        return SCTP_MODULE_NOT_FOUND;
+    }
+    ss = ss_getModule(scheduler);
+    if (ss == NULL) {
+        error_logi(ERROR_MINOR, "fc_set_streamScheduler: unknown scheduler %u", scheduler);
+        return SCTP_PARAMETER_PROBLEM;
+    }
+    fc->ss = ss;
+    event_logi(VERBOSE, "fc_set_streamScheduler(%s)", fc->ss->name);
+    return SCTP_SUCCESS;
+}
+
+int fc_get_corkDelay(unsigned int * delay)
+{
+    fc_data *fc;
+    fc = (fc_data *) mdi_readFlowControl();
+
+    if (!fc) {
+        error_log(ERROR_MAJOR, "flow control instance not set !");
+        return -1;
+    }
+    *delay = fc->cork_delay;
+    return 0;
+}
+
+int fc_set_corkDelay(unsigned int delay)
+{
+    fc_data *fc;
+    fc = (fc_data *) mdi_readFlowControl();
+
+    if (!fc) {
+        error_log(ERROR_MAJOR, "flow control instance not set !");
+        return -1;
+    }
+    fc->cork_delay = delay;
+    event_logi(VERBOSE, "fc_set_corkDelay(%u)", delay);
+    return 0;
+}
+
+int fc_get_streamPriority(unsigned short sid, unsigned int * priority)
+{
+    fc_data *fc;
+    fc = (fc_data *) mdi_readFlowControl();
+
+    if (!fc) {
+        error_log(ERROR_MAJOR, "flow control instance not set !");
+        return SCTP_MODULE_NOT_FOUND;
+    }
+    *priority = fc_stream(fc, sid)->priority;
+    return SCTP_SUCCESS;
+}
+
+int fc_set_streamPriority(unsigned short sid, unsigned int priority)
+{
+    fc_data *fc;
+    fc = (fc_data *) mdi_readFlowControl();
+
+    if (!fc) {
+        error_log(ERROR_MAJOR, "flow control instance not set !");
+        return SCTP_MODULE_NOT_FOUND;
+    }
+    fc_stream(fc, sid)->priority = priority;
+    event_logii(VERBOSE, "fc_set_streamPriority(%u, %u)", sid, priority);
+    return SCTP_SUCCESS;
+}
+
+int fc_get_streamWeight(unsigned short sid, unsigned int * weight)
+{
+    fc_data *fc;
+    fc = (fc_data *) mdi_readFlowControl();
+
+    if (!fc) {
+        error_log(ERROR_MAJOR, "flow control instance not set !");
+        return SCTP_MODULE_NOT_FOUND;
+    }
+    *weight = fc_stream(fc, sid)->weight;
+    return SCTP_SUCCESS;
+}
+
+int fc_set_streamWeight(unsigned short sid, unsigned int weight)
+{
+    fc_data *fc;
+    fc = (fc_data *) mdi_readFlowControl();
+
+    if (!fc) {
+        error_log(ERROR_MAJOR, "flow control instance not set !");
+        return SCTP_MODULE_NOT_FOUND;
+    }
+    if (weight == 0) return SCTP_PARAMETER_PROBLEM;
+    fc_stream(fc, sid)->weight = weight;
+    event_logii(VERBOSE, "fc_set_streamWeight(%u, %u)", sid, weight);
+    return SCTP_SUCCESS;
+}
+
 int fc_set_maxSendQueue(unsigned int maxQueueLen)
 {
     fc_data *fc;
@@ -58,7 +58,10 @@
 void *fc_new_flowcontrol(unsigned int peer_rwnd,
                          unsigned int my_iTSN,
                          unsigned int number_of_destination_addresses,
-                         unsigned int maxQueueLen);
+                         unsigned int maxQueueLen,
+                         unsigned int congestionControl,
+                         unsigned int pacingGain,
+                         unsigned int streamScheduler);
 
 /**
  * Deletes data occupied by a flow_control data structure
@@ -139,6 +142,13 @@ void fc_sack_info(unsigned int address_index, unsigned int arwnd, unsigned int c
                   unsigned int num_acked,
                   unsigned int number_of_addresses);
 
+/**
+ * function called by bundling, when it has received an ECNE chunk
+ * @param  chunk  pointer to the ECNE chunk
+ * @param  address_index  index of the path the chunk arrived from
+ */
+int fc_process_ecne(void* chunk, unsigned int address_index);
+
 int fc_dequeueUnackedChunk(unsigned int tsn);
 
 int fc_dequeue_acked_chunks(unsigned int ctsna);
@@ -189,6 +199,18 @@ int fc_readSsthresh(short path_id);
  */
 unsigned int fc_readMTU(short path_id);
 
+/**
+ * Sets the MTU of a path (IP packet size, MIN_MTU_SIZE..MAX_MTU_SIZE).
+ * @return SCTP_SUCCESS, or an error code
+ */
+int fc_setMTU(short path_id, unsigned int mtu);
+
+/**
+ * Returns the largest amount of user data per DATA chunk, for a destination
+ * or for all paths (path_id == -1).
+ */
+unsigned int fc_readMaxDataLength(short path_id);
+
 
 /**
  * Function returns the partial bytes acked value of a certain path.
@@ -204,9 +226,90 @@ int fc_readPBA(short path_id);
  */
 int fc_readOutstandingBytes(void);
 
+/**
+ * Function returns the pacing rate of a certain path.
+ * @param path_id    path index of which we want to know the pacing rate
+ * @return pacing rate in bytes per second, 0 if the path is not paced
+ */
+unsigned int fc_readPacingRate(short path_id);
+
+/**
+ * Function returns the time until pacing allows the next packet on a certain path.
+ * @param path_id    path index of which we want to know the pacing delay
+ * @return delay in microseconds, 0 if a packet may be sent now
+ */
+unsigned int fc_readPacingDelay(short path_id);
+
+
+/**
+ * Function holds back the transmission of newly queued chunks, e.g. while the ULP
+ * queues a batch of messages. Calls may be nested.
+ */
+void fc_hold_transmission(void);
+
+/**
+ * Function ends fc_hold_transmission(), and sends what has been queued meanwhile
+ */
+void fc_release_transmission(void);
+
+/**
+ * Function corks (TRUE) or uncorks (FALSE) the association: while corked, new data
+ * is only sent when a packet can be filled, or after the cork delay
+ */
+void fc_set_cork(gboolean corked);
+
+/**
+ * Function notes that the ULP announced more data (SCTP_SEND_MORE) with the next message,
+ * which is then held back like corked data
+ */
+void fc_set_more(gboolean more);
+
+int fc_get_corkDelay(unsigned int * delay);
+
+int fc_set_corkDelay(unsigned int delay);
 
 int fc_get_maxSendQueue(unsigned int * queueLen);
 
 int fc_set_maxSendQueue(unsigned int maxQueueLen);
 
+int fc_get_congestionControl(unsigned int * algorithm);
+
+/**
+ * switches the congestion control module of the current association. The windows
+ * of the paths are kept, the module starts with fresh private state.
+ * @param  algorithm   one of the SCTP_CC_xxx values
+ * @return SCTP_SUCCESS, or SCTP_PARAMETER_PROBLEM for an unknown algorithm
+ */
+int fc_set_congestionControl(unsigned int algorithm);
+
+int fc_get_pacingGain(unsigned int * gain);
+
+int fc_set_pacingGain(unsigned int gain);
+
+int fc_get_streamScheduler(unsigned int * scheduler);
+
+/**
+ * switches the stream scheduler of the current association. Chunks that are
+ * already queued keep their place, new chunks are queued by the new scheduler.
+ * @param  scheduler   one of the SCTP_SS_xxx values
+ * @return SCTP_SUCCESS, or SCTP_PARAMETER_PROBLEM for an unknown scheduler
+ */
+int fc_set_streamScheduler(unsigned int scheduler);
+
+int fc_get_streamPriority(unsigned short sid, unsigned int * priority);
+
+/**
+ * sets the priority of an outbound stream for the SCTP_SS_PRIO scheduler,
+ * chunks of streams with lower values are sent first
+ */
+int fc_set_streamPriority(unsigned short sid, unsigned int priority);
+
+int fc_get_streamWeight(unsigned short sid, unsigned int * weight);
+
+/**
+ * sets the weight of an outbound stream for the SCTP_SS_WFQ scheduler
+ * @return SCTP_SUCCESS, or SCTP_PARAMETER_PROBLEM if the weight is 0
+ */
+int fc_set_streamWeight(unsigned short sid, unsigned int weight);
+
 #endif
@@ -157,7 +157,6 @@ typedef struct chunk_data_struct
 {
     unsigned int chunk_len;
     unsigned int chunk_tsn;     /* for efficiency */
-    unsigned char data[MAX_SCTP_PDU];
     unsigned int gap_reports;
     struct timeval transmission_time;
     /* ack_time : in msecs after transmission time, initially 0, -1 if retransmitted */
@@ -175,9 +174,16 @@ typedef struct chunk_data_struct
     gboolean hasBeenDropped;
     gboolean hasBeenFastRetransmitted;
     gboolean hasBeenRequeued;
+    /* order of unsent chunks given by the stream scheduler : priority first, then tag */
+    unsigned int sched_priority;
+    unsigned int sched_tag;
     gpointer context;
+    /* the chunk itself, allocated with CHUNK_DATA_SIZE(chunk length) */
+    unsigned char data[];
 } chunk_data;
 
+#define CHUNK_DATA_SIZE(len)    (sizeof(chunk_data) + (len))
+
 #ifndef max
 #define max(x,y)            ((x)>(y))?(x):(y)
 #endif
@@ -76,7 +76,12 @@ typedef struct UDP_HEADER {
 #endif
 
 
-#define MAX_MTU_SIZE              1500
+/* largest IP packet the library handles, path MTUs may be raised up to this value at runtime */
+#define MAX_MTU_SIZE              65535
+/* path MTU of new associations */
+#define DEFAULT_MTU_SIZE          1500
+/* smallest path MTU that may be configured */
+#define MIN_MTU_SIZE              576
 #define IP_HEADERLENGTH             20
 
 /**
@@ -98,6 +103,12 @@ SCTP_common_header;
  * max. SCTP-datagram length without common header
  */
 #define MAX_SCTP_PDU   (MAX_MTU_SIZE - IP_HEADERLENGTH - sizeof(SCTP_common_header))
+#define DEFAULT_SCTP_PDU   (DEFAULT_MTU_SIZE - IP_HEADERLENGTH - sizeof(SCTP_common_header))
+/*
+ * length of the control chunks built by the library : only DATA follows the path MTU,
+ * control chunks keep the size they had with the default MTU
+ */
+#define MAX_CTRL_PDU   DEFAULT_SCTP_PDU
 
 
 /*
@@ -132,10 +143,13 @@ SCTP_message;
 #define CHUNK_ECNE              0x0C
 #define CHUNK_CWR               0x0D
 #define CHUNK_SHUTDOWN_COMPLETE 0x0E
+#define CHUNK_NR_SACK           0x10
+#define CHUNK_IDATA             0x40
 
 #define CHUNK_FORWARD_TSN       0xC0
 #define CHUNK_ASCONF            0xC1
 #define CHUNK_ASCONF_ACK        0x80
+#define CHUNK_PAD               0x84
 
 #define STOP_PROCESSING(chunk_id)               (((guint8)chunk_id & 0xC0)==0x00))
 #define STOP_PROCESSING_WITH_ERROR(chunk_id)    (((guint8)chunk_id & 0xC0)==0x40))
@@ -177,6 +191,8 @@ SCTP_data_chunk_header;
 #define SCTP_DATA_MIDDLE_SEGMENT     0x00
 #define SCTP_DATA_END_SEGMENT        0x01
 #define SCTP_DATA_UNORDERED          0x04
+/* the sender asks for a SACK without delay, see RFC 7053 */
+#define SCTP_DATA_SACK_IMMEDIATELY   0x08
 
 #define MAX_DATACHUNK_PDU_LENGTH  (MAX_SCTP_PDU-sizeof(SCTP_chunk_header)-sizeof(SCTP_data_chunk_header))
 
@@ -195,6 +211,42 @@ typedef struct SCTP_DATA_CHUNK
 SCTP_data_chunk;
 
 
+/*--------------------------- I-DATA chunk (RFC 8260) ---------------------------------------*/
+/* when chunk_id == CHUNK_IDATA */
+typedef struct SCTP_IDATA_CHUNK_HEADER
+{
+    guint32 tsn;
+    guint16 stream_id;
+    guint16 reserved;
+    guint32 message_id;
+    /* the payload protocol id in the first fragment, the fragment sequence number in all others */
+    guint32 ppid_fsn;
+}
+SCTP_idata_chunk_header;
+
+#define  FIXED_IDATA_CHUNK_SIZE     (sizeof(SCTP_chunk_header) + sizeof(SCTP_idata_chunk_header))
+
+#define MAX_IDATACHUNK_PDU_LENGTH (MAX_SCTP_PDU-sizeof(SCTP_chunk_header)-sizeof(SCTP_idata_chunk_header))
+
+typedef struct SCTP_IDATA_CHUNK
+{
+    guint8 chunk_id;
+    guint8 chunk_flags;
+    guint16 chunk_length;
+    guint32 tsn;
+    guint16 stream_id;
+    guint16 reserved;
+    guint32 message_id;
+    guint32 ppid_fsn;
+    guchar data[MAX_IDATACHUNK_PDU_LENGTH];
+}
+SCTP_idata_chunk;
+
+/* size of the fixed part of a DATA or I-DATA chunk */
+#define  DATA_CHUNK_HEADER_SIZE(chunk_id) \
+    (((chunk_id) == CHUNK_IDATA) ? FIXED_IDATA_CHUNK_SIZE : FIXED_DATA_CHUNK_SIZE)
+
+
 /*--------------------------- variable length parameter definitions ------------------------*/
 /*                                                                                          */
 /*                               See section 3.2.1                                          */
@@ -215,6 +267,7 @@ SCTP_data_chunk;
 #define VLPARAM_UNRECOGNIZED_PARAM      0x0008
 #define VLPARAM_COOKIE_PRESERV          0x0009
 #define VLPARAM_ECN_CAPABLE             0x8000
+#define VLPARAM_SUPPORTED_EXTENSIONS    0x8008
 #define VLPARAM_HOST_NAME_ADDR          0x000B
 #define VLPARAM_SUPPORTED_ADDR_TYPES    0x000C
 
@@ -306,7 +359,7 @@ typedef struct SCTP_INIT_FIXED
 SCTP_init_fixed;
 
 /* max. length of optional parameters */
-#define MAX_INIT_OPTIONS_LENGTH  (MAX_SCTP_PDU - sizeof(SCTP_init_fixed))
+#define MAX_INIT_OPTIONS_LENGTH  (MAX_CTRL_PDU - sizeof(SCTP_init_fixed))
 
 /* init chunk structure, also used for initAck */
 typedef struct SCTP_INIT
@@ -319,7 +372,7 @@ SCTP_init;
 
 
 /*--------------------------- selective acknowledgements defs --------------------------------*/
-#define MAX_VARIABLE_SACK_SIZE  (MAX_SCTP_PDU - 16)
+#define MAX_VARIABLE_SACK_SIZE  (MAX_CTRL_PDU - 16)
 /* see section 2.3.3 */
 typedef struct SCTP_SACK_CHUNK
 {
@@ -332,6 +385,21 @@ typedef struct SCTP_SACK_CHUNK
 }
 SCTP_sack_chunk;
 
+/* non-renegable SACK, see draft-natarajan-tsvwg-sctp-nrsack : the gap ack blocks report
+   all TSNs received out of order, the NR gap ack blocks those, that will not be reneged */
+typedef struct SCTP_NR_SACK_CHUNK
+{
+    SCTP_chunk_header chunk_header;
+    guint32 cumulative_tsn_ack;
+    guint32 a_rwnd;
+    guint16 num_of_fragments;
+    guint16 num_of_nr_fragments;
+    guint16 num_of_duplicates;
+    guint16 reserved;
+    guchar fragments_and_dups[MAX_VARIABLE_SACK_SIZE];
+}
+SCTP_nr_sack_chunk;
+
 typedef struct _fragment32
 {
     guint32 start_tsn;
@@ -361,6 +429,8 @@ typedef struct SCTP_HEARTBEAT
     SCTP_vlparam_header HB_Info;
     guint32 sendingTime;
     guint32 pathID;
+    /* size of the PLPMTUD probe packet this heartbeat was sent in, 0 if none */
+    guint32 probeSize;
 #ifdef MD5_HMAC
     guint8 hmac[16];
 #elif SHA_HMAC
@@ -381,7 +451,7 @@ SCTP_heartbeat;
    simple chunk can also be used for transfering chunks to/from bundling, since bundling
    looks only on the chunk header.
 */
-#define MAX_SIMPLE_CHUNKDATA_LENGTH   (MAX_SCTP_PDU - sizeof(SCTP_chunk_header))
+#define MAX_SIMPLE_CHUNKDATA_LENGTH   (MAX_CTRL_PDU - sizeof(SCTP_chunk_header))
 
 typedef struct SCTP_SIMPLE_CHUNK
 {
@@ -400,10 +470,22 @@ typedef struct SCTP_FORWARD_TSN_CHUNK
 {
     SCTP_chunk_header   chunk_header;
     guint32             forward_tsn;
-    guchar              variableParams[MAX_SCTP_PDU];
+    guchar              variableParams[MAX_CTRL_PDU];
 }
 SCTP_forward_tsn_chunk;
 
+/**
+ * ECN Echo (ECNE) and Congestion Window Reduced (CWR) chunks, see RFC 4960, appendix A
+ */
+typedef struct SCTP_ECN_CHUNK
+{
+    SCTP_chunk_header   chunk_header;
+    /** ECNE : TSN of the last DATA chunk received in a packet marked CE,
+        CWR : that TSN from the ECNE, that caused the cwnd reduction */
+    guint32             tsn;
+}
+SCTP_ecn_chunk;
+
 /*--------------------------- parameter definitions ------------------------------------------*/
 
 /**
@@ -454,7 +536,7 @@ SCTP_cookie_param;
 /* cookie chunks fixed params length including chunk header */
 #define COOKIE_FIXED_LENGTH     (sizeof(SCTP_our_cookie))
 /* max. length of cookie variable length params parameters */
-#define MAX_COOKIE_VLP_LENGTH   (MAX_SCTP_PDU -  COOKIE_FIXED_LENGTH)
+#define MAX_COOKIE_VLP_LENGTH   (MAX_CTRL_PDU -  COOKIE_FIXED_LENGTH)
 
 /* cookie echo chunk structure */
 typedef struct SCTP_COOKIE_ECHO
@@ -475,14 +557,14 @@ SCTP_cookie_echo;
 typedef struct SCTP_ERROR_CHUNK
 {
     SCTP_chunk_header chunk_header;
-    unsigned char data[MAX_DATACHUNK_PDU_LENGTH];
+    unsigned char data[MAX_SIMPLE_CHUNKDATA_LENGTH];
 } SCTP_error_chunk;
 
 typedef struct SCTP_ERROR_CAUSE
 {
     unsigned short cause_code;
     unsigned short cause_length;
-    guchar cause_information[MAX_SCTP_PDU];
+    guchar cause_information[MAX_CTRL_PDU];
 }SCTP_error_cause;
 
 
@@ -530,14 +612,14 @@ SCTP_InvalidStreamIdError;
 typedef struct SCTP_UNRESOLVABLE_ADDRESS_ERROR
 {
     SCTP_vlparam_header vlparam_header;
-    guchar the_address[MAX_SCTP_PDU];
+    guchar the_address[MAX_CTRL_PDU];
 }
 SCTP_UnresolvableAddress;
 
 typedef struct SCTP_UNRECOGNIZED_PARAMS_ERROR
 {
     SCTP_vlparam_header vlparam_header;
-    guchar the_params[MAX_SCTP_PDU];
+    guchar the_params[MAX_CTRL_PDU];
 }
 SCTP_UnrecognizedParams;
 
@@ -557,14 +639,14 @@ typedef struct SCTP_ASCONF_FIXED
     guint8      reserved8;
     guint8      address_type;
     guint32     sctp_address[4];
-    guchar      variableParams[MAX_SCTP_PDU];
+    guchar      variableParams[MAX_CTRL_PDU];
 }
 SCTP_asconf_fixed;
 
 typedef struct SCTP_ASCONF_ACK
 {
     guint32     serial_number;
-    guchar      variableParams[MAX_SCTP_PDU];
+    guchar      variableParams[MAX_CTRL_PDU];
 }
 SCTP_asconf_ack;
 
@@ -47,11 +47,31 @@
 #include "adaptation.h"
 #include "bundling.h"
 #include "pathmanagement.h"
+#include "flowcontrol.h"
+#include "distribution.h"
+#include "trace.h"
 
 /*------------------------ defines -----------------------------------------------------------*/
 #define RTO_ALPHA            0.125
 #define RTO_BETA              0.25
 
+/* packetization layer path MTU discovery (RFC 8899) */
+#define PLPMTUD_DISABLED          0     /* no probe sent yet */
+#define PLPMTUD_BASE              1     /* confirming PLPMTUD_BASE_MTU */
+#define PLPMTUD_SEARCHING         2     /* probing for a larger MTU */
+#define PLPMTUD_SEARCH_COMPLETE   3     /* waiting for PLPMTUD_RAISE_TIMER */
+#define PLPMTUD_ERROR             4     /* not even PLPMTUD_BASE_MTU got through */
+
+#define PLPMTUD_BASE_MTU          1200
+/* unacked probes of one size, after which that size is taken as too large */
+#define PLPMTUD_MAX_PROBES        3
+/* search stops, when the interval of possible MTUs is smaller than this */
+#define PLPMTUD_GRANULARITY       16
+/* msecs after which a completed search is started again, to find a raised MTU */
+#define PLPMTUD_RAISE_TIMER       600000
+/* consecutive timeouts on a path that let the MTU fall back to PLPMTUD_BASE_MTU */
+#define PLPMTUD_BLACKHOLE_RTX     2
+
 
 /*----------------------- Typedefs ------------------------------------------------------------*/
 
@@ -96,6 +116,18 @@ typedef struct PATHDATA
     struct timeval rto_update;
     /** ID of path */
     unsigned int pathID;
+    /** PLPMTUD state of the path, one of the PLPMTUD_xxx values */
+    short plpmtudState;
+    /** size of the probe currently in flight */
+    unsigned int probedSize;
+    /** number of probes of probedSize sent without acknowledgement */
+    unsigned int probeCount;
+    /** largest packet size known to get through */
+    unsigned int searchLow;
+    /** largest packet size that may still get through */
+    unsigned int searchHigh;
+    /** ID of the probe timer */
+    TimerID probeTimer;
     /*@} */
 } PathData;
 
@@ -125,6 +157,8 @@ typedef struct PATHMANDATA
     int rto_min;
     /** maximum RTO, a configurable parameter */
     int rto_max;
+    /** TRUE, if the MTU of the paths is discovered by probing */
+    gboolean plpmtudEnabled;
     /*@} */
 } PathmanData;
 
@@ -137,6 +171,9 @@ typedef struct PATHMANDATA
  */
 PathmanData *pmData;
 
+static void pm_plpmtudProbeAcked(short pathID, unsigned int probeSize);
+static void pm_plpmtudBlackHole(short pathID);
+
 /*-------------------------- Function Implementations -------------------------------------------*/
 
 /*------------------- Internal Functions --------------------------------------------------------*/
@@ -199,6 +236,12 @@ static gboolean handleChunksRetransmitted(short pathID)
         return FALSE;
     }
 
+    if (pmData->plpmtudEnabled &&
+        pmData->pathData[pathID].pathRetranscount == PLPMTUD_BLACKHOLE_RTX &&
+        pmData->pathData[pathID].searchLow > PLPMTUD_BASE_MTU) {
+        pm_plpmtudBlackHole(pathID);
+    }
+
     if (pmData->peerRetranscount >= (unsigned int)sci_getMaxAssocRetransmissions()) {
         mdi_deleteCurrentAssociation();
         mdi_communicationLostNotif(SCTP_COMM_LOST_EXCEEDED_RETRANSMISSIONS);
@@ -259,6 +302,8 @@ static void handleChunksAcked(short pathID, unsigned int newRTT)
     event_logii(INTERNAL_EVENT_0, "handleChunksAcked: pathID: %u, new RTT: %u msecs", pathID, newRTT);
 
     if (newRTT > 0) {
+        trc_event(SCTP_TRACE_MODULE_PATHMANAGEMENT, TRC_RTT_MEASURED, pmData->associationID, pathID, newRTT);
+        mdi_recordRttSample(pathID, newRTT * 1000);
         /* RTO measurement done */
         /* calculate new RTO, SRTT and RTTVAR */
         if (pmData->pathData[pathID].firstRTO) {
@@ -294,6 +339,242 @@ static void handleChunksAcked(short pathID, unsigned int newRTT)
 
 
 
+/*----------------- Packetization layer path MTU discovery ----------------------------------------*/
+
+void pm_probeTimer(TimerID timerID, void *associationIDvoid, void *pathIDvoid);
+
+/**
+ * largest MTU the search may go up to : the largest MTU of the local interfaces
+ */
+static unsigned int pm_plpmtudMaxMTU(void)
+{
+    unsigned int maxMTU = mdi_readLocalMaxMTU();
+
+    if (maxMTU > MAX_MTU_SIZE) maxMTU = MAX_MTU_SIZE;
+    if (maxMTU < PLPMTUD_BASE_MTU) maxMTU = PLPMTUD_BASE_MTU;
+    return maxMTU & ~3;
+}
+
+static void pm_startProbeTimer(short pathID, unsigned int msecs)
+{
+    if (pmData->pathData[pathID].probeTimer != 0)
+        sctp_stopTimer(pmData->pathData[pathID].probeTimer);
+    pmData->pathData[pathID].probeTimer =
+        adl_startTimer(msecs, &pm_probeTimer, TIMER_TYPE_HEARTBEAT,
+                       (void *) &pmData->associationID,
+                       (void *) &pmData->pathData[pathID].pathID);
+}
+
+/**
+ * picks the next size to probe, or ends the search, if the interval between the largest
+ * confirmed and the smallest failed size is small enough. The first probe of a search
+ * tries DEFAULT_MTU_SIZE, as this is the most common MTU.
+ */
+static void pm_plpmtudNextProbe(short pathID)
+{
+    PathData *path = &pmData->pathData[pathID];
+
+    path->probeCount = 0;
+    if (path->searchHigh < path->searchLow + PLPMTUD_GRANULARITY) {
+        path->plpmtudState = PLPMTUD_SEARCH_COMPLETE;
+        path->probedSize = 0;
+        event_logii(INTERNAL_EVENT_0, "PLPMTUD: search on path %d completed, MTU %u", pathID, path->searchLow);
+        return;
+    }
+    path->plpmtudState = PLPMTUD_SEARCHING;
+    if (path->searchLow < DEFAULT_MTU_SIZE && path->searchHigh >= DEFAULT_MTU_SIZE)
+        path->probedSize = DEFAULT_MTU_SIZE;
+    else
+        path->probedSize = ((path->searchLow + path->searchHigh + 1) / 2) & ~3;
+    if (path->probedSize <= path->searchLow) path->probedSize = path->searchLow + 4;
+}
+
+/**
+ * a probe size got no acknowledgement after PLPMTUD_MAX_PROBES attempts, or could not
+ * even be sent, so the path MTU is smaller than that
+ */
+static void pm_plpmtudProbeFailed(short pathID)
+{
+    PathData *path = &pmData->pathData[pathID];
+
+    event_logii(INTERNAL_EVENT_0, "PLPMTUD: probe of %u bytes on path %d failed", path->probedSize, pathID);
+    if (path->plpmtudState == PLPMTUD_BASE) {
+        /* keep sending with the base MTU, and try again later */
+        path->plpmtudState = PLPMTUD_ERROR;
+        path->probedSize = 0;
+        path->probeCount = 0;
+        return;
+    }
+    path->searchHigh = (path->probedSize - 4) & ~3;
+    pm_plpmtudNextProbe(pathID);
+}
+
+/**
+ * sends the next probe on a path, and starts the probe timer for it
+ */
+static void pm_plpmtudSendProbe(short pathID)
+{
+    PathData *path = &pmData->pathData[pathID];
+    ChunkID heartbeatCID;
+    guint32 pid = (guint32)pathID;
+    gint result;
+
+    while (path->plpmtudState == PLPMTUD_BASE || path->plpmtudState == PLPMTUD_SEARCHING) {
+        heartbeatCID = ch_makeHeartbeat(pm_getTime(), pathID, path->probedSize);
+        result = bu_sendProbe(ch_chunkString(heartbeatCID), path->probedSize, &pid);
+        ch_deleteChunk(heartbeatCID);
+        if (result == 0) {
+            path->probeCount++;
+            pm_startProbeTimer(pathID, path->rto);
+            return;
+        }
+        /* the local interface does not take a packet of that size */
+        pm_plpmtudProbeFailed(pathID);
+    }
+    pm_startProbeTimer(pathID, PLPMTUD_RAISE_TIMER);
+}
+
+/**
+ * the peer acknowledged a probe : the path carries packets of that size
+ */
+static void pm_plpmtudProbeAcked(short pathID, unsigned int probeSize)
+{
+    PathData *path = &pmData->pathData[pathID];
+
+    if (!pmData->plpmtudEnabled || probeSize != path->probedSize) return;
+
+    event_logii(INTERNAL_EVENT_0, "PLPMTUD: probe of %u bytes on path %d acked", probeSize, pathID);
+    path->searchLow = probeSize;
+    fc_setMTU(pathID, probeSize);
+    if (path->plpmtudState == PLPMTUD_BASE) path->searchHigh = pm_plpmtudMaxMTU();
+    pm_plpmtudNextProbe(pathID);
+    /* the next probe leaves from the timer, not while the received packet is processed */
+    if (path->plpmtudState == PLPMTUD_SEARCH_COMPLETE)
+        pm_startProbeTimer(pathID, PLPMTUD_RAISE_TIMER);
+    else
+        pm_startProbeTimer(pathID, 1);
+}
+
+/**
+ * data on a path with a discovered MTU above the base was lost repeatedly : the
+ * MTU may have shrunk (e.g. a route change into a tunnel), so fall back to the base
+ * MTU and confirm it again, before searching upward
+ */
+static void pm_plpmtudBlackHole(short pathID)
+{
+    PathData *path = &pmData->pathData[pathID];
+
+    event_logii(INTERNAL_EVENT_0, "PLPMTUD: black hole suspected on path %d with MTU %u", pathID, path->searchLow);
+    fc_setMTU(pathID, PLPMTUD_BASE_MTU);
+    path->searchLow = PLPMTUD_BASE_MTU;
+    path->searchHigh = PLPMTUD_BASE_MTU;
+    path->plpmtudState = PLPMTUD_BASE;
+    path->probedSize = PLPMTUD_BASE_MTU;
+    path->probeCount = 0;
+    pm_startProbeTimer(pathID, path->rto);
+}
+
+/**
+ * timer callback for the probe timer of a path : starts the search, repeats or gives
+ * up a probe that was not acknowledged, or restarts a completed search
+ */
+void pm_probeTimer(TimerID timerID, void *associationIDvoid, void *pathIDvoid)
+{
+    unsigned int associationID;
+    unsigned int pathID;
+    PathData *path;
+
+    associationID = *((unsigned int *) associationIDvoid);
+    pathID = *((unsigned int *) pathIDvoid);
+    if (mdi_setAssociationData(associationID)) {
+        error_logi(ERROR_MAJOR, "probe timer expired, association %08u does not exist", associationID);
+        return;
+    }
+    pmData = (PathmanData *) mdi_readPathMan();
+    if (pmData == NULL || pmData->pathData == NULL || pathID >= (unsigned int)pmData->numberOfPaths) {
+        error_log(ERROR_MAJOR, "pm_probeTimer: no path data");
+        mdi_clearAssociationData();
+        return;
+    }
+    path = &pmData->pathData[pathID];
+    path->probeTimer = 0;
+
+    if (!pmData->plpmtudEnabled) {
+        mdi_clearAssociationData();
+        return;
+    }
+    if (path->state != PM_ACTIVE) {
+        /* probes on a path that does not work tell nothing about its MTU */
+        path->probeCount = 0;
+        pm_startProbeTimer((short)pathID, path->rto);
+        mdi_clearAssociationData();
+        return;
+    }
+
+    switch (path->plpmtudState) {
+    case PLPMTUD_DISABLED:
+        fc_setMTU((short)pathID, PLPMTUD_BASE_MTU);
+        path->searchLow = PLPMTUD_BASE_MTU;
+        path->searchHigh = PLPMTUD_BASE_MTU;
+        path->plpmtudState = PLPMTUD_BASE;
+        path->probedSize = PLPMTUD_BASE_MTU;
+        path->probeCount = 0;
+        break;
+    case PLPMTUD_BASE:
+    case PLPMTUD_SEARCHING:
+        if (path->probeCount >= PLPMTUD_MAX_PROBES) pm_plpmtudProbeFailed((short)pathID);
+        break;
+    case PLPMTUD_ERROR:
+        path->plpmtudState = PLPMTUD_BASE;
+        path->probedSize = PLPMTUD_BASE_MTU;
+        path->probeCount = 0;
+        break;
+    case PLPMTUD_SEARCH_COMPLETE:
+        path->searchHigh = pm_plpmtudMaxMTU();
+        pm_plpmtudNextProbe((short)pathID);
+        break;
+    }
+    pm_plpmtudSendProbe((short)pathID);
+    mdi_clearAssociationData();
+}
+
+/**
+ * switches path MTU discovery on or off for the current association. When it is switched
+ * off, the paths keep their current MTU.
+ */
+int pm_setPathMTUDiscovery(gboolean enabled)
+{
+    short pathID;
+
+    pmData = (PathmanData *) mdi_readPathMan();
+    if (pmData == NULL) {
+        error_log(ERROR_MAJOR, "pm_setPathMTUDiscovery: mdi_readPathMan failed");
+        return SCTP_MODULE_NOT_FOUND;
+    }
+    if (pmData->plpmtudEnabled == enabled) return SCTP_SUCCESS;
+    pmData->plpmtudEnabled = enabled;
+    if (pmData->pathData == NULL) return SCTP_SUCCESS;
+
+    for (pathID = 0; pathID < pmData->numberOfPaths; pathID++) {
+        if (pmData->pathData[pathID].probeTimer != 0) {
+            sctp_stopTimer(pmData->pathData[pathID].probeTimer);
+            pmData->pathData[pathID].probeTimer = 0;
+        }
+        pmData->pathData[pathID].plpmtudState = PLPMTUD_DISABLED;
+        if (enabled) pm_startProbeTimer(pathID, pmData->pathData[pathID].rto);
+    }
+    return SCTP_SUCCESS;
+}
+
+gboolean pm_getPathMTUDiscovery(void)
+{
+    pmData = (PathmanData *) mdi_readPathMan();
+    if (pmData == NULL) return FALSE;
+    return pmData->plpmtudEnabled;
+}
+
+
+
 /*----------------- Functions to answer peer HB requests -----------------------------------------*/
 
 /**
@@ -385,7 +666,7 @@ void pm_heartbeatTimer(TimerID timerID, void *associationIDvoid, void *pathIDvoi
          */
         /* send heartbeat if no chunks have been acked in the last HB-intervall (path is idle). */
         event_log(VERBOSE, "--------------> Sending HB");
-        heartbeatCID = ch_makeHeartbeat(pm_getTime(), pathID);
+        heartbeatCID = ch_makeHeartbeat(pm_getTime(), pathID, 0);
         bu_put_Ctrl_Chunk(ch_chunkString(heartbeatCID), &pathID);
         bu_sendAllChunks(&pathID);
         ch_deleteChunk(heartbeatCID);
@@ -450,7 +731,7 @@ int pm_doHB(gshort pathID)
         return SCTP_PARAMETER_PROBLEM;
     }
     pid = (guint32)pathID;
-    heartbeatCID = ch_makeHeartbeat(pm_getTime(), pathID);
+    heartbeatCID = ch_makeHeartbeat(pm_getTime(), pathID, 0);
     bu_put_Ctrl_Chunk(ch_chunkString(heartbeatCID),&pid);
     bu_sendAllChunks(&pid);
     ch_deleteChunk(heartbeatCID);
@@ -469,6 +750,7 @@ void pm_heartbeatAck(SCTP_heartbeat * heartbeatChunk)
 {
     unsigned int roundtripTime;
     unsigned int sendingTime;
+    unsigned int probeSize;
     short pathID;
     ChunkID heartbeatCID;
     PathmanData *old_pmData = NULL;
@@ -488,6 +770,7 @@ void pm_heartbeatAck(SCTP_heartbeat * heartbeatChunk)
     heartbeatCID = ch_makeChunk((SCTP_simple_chunk *) heartbeatChunk);
     pathID = ch_HBpathID(heartbeatCID);
     sendingTime = ch_HBsendingTime(heartbeatCID);
+    probeSize = ch_HBprobeSize(heartbeatCID);
     roundtripTime = pm_getTime() - sendingTime;
     event_logii(INTERNAL_EVENT_0, "HBAck for path %u, RTT = %u msecs", pathID, roundtripTime);
 
@@ -530,6 +813,8 @@ void pm_heartbeatAck(SCTP_heartbeat * heartbeatChunk)
     pmData->pathData[pathID].heartbeatAcked = TRUE;
     pmData->pathData[pathID].timerBackoff = FALSE;
 
+    if (probeSize != 0) pm_plpmtudProbeAcked(pathID, probeSize);
+
 }                               /* end: pm_heartbeatAck */
 
 
@@ -661,6 +946,90 @@ gboolean pm_chunksRetransmitted(short pathID)
 
 
 
+/**
+  pm_pathUnreachable is called by the message distribution when an ICMP destination
+  unreachable message was received for a packet of this association sent to pathID.
+  The path is set to INACTIVE at once, instead of after maxPathRetransmissions timeouts,
+  so that retransmissions and new data go to another path. The last active path is left
+  to the retransmission counters, as an ICMP message alone must not end the association.
+  Heartbeats on the path bring it back to ACTIVE when it works again.
+  @param pathID  index of the path the ICMP message refers to
+*/
+void pm_pathUnreachable(short pathID)
+{
+    short pID;
+    boolean otherPathActive = FALSE;
+    PathmanData *old_pmData;
+
+    pmData = (PathmanData *) mdi_readPathMan();
+    if (pmData == NULL || pmData->pathData == NULL) {
+        error_log(ERROR_MAJOR, "pm_pathUnreachable: no path data");
+        return;
+    }
+    if (!(pathID >= 0 && pathID < pmData->numberOfPaths)) {
+        error_logi(ERROR_MAJOR, "pm_pathUnreachable: invalid path ID %d", pathID);
+        return;
+    }
+    if (pmData->pathData[pathID].state != PM_ACTIVE) return;
+
+    for (pID = 0; pID < pmData->numberOfPaths; pID++) {
+        if (pID != pathID && pmData->pathData[pID].state == PM_ACTIVE) otherPathActive = TRUE;
+    }
+    if (!otherPathActive) {
+        event_logi(INTERNAL_EVENT_0, "pm_pathUnreachable: path %d is the last active path, ignored", pathID);
+        return;
+    }
+
+    pmData->pathData[pathID].state = PM_INACTIVE;
+    pmData->pathData[pathID].pathRetranscount = pmData->maxPathRetransmissions;
+    event_logi(INTERNAL_EVENT_0, "pm_pathUnreachable: path %d to INACTIVE ", pathID);
+    old_pmData = pmData;
+    mdi_networkStatusChangeNotif(pathID, PM_INACTIVE);
+    pmData = old_pmData;
+}                               /* end: pm_pathUnreachable */
+
+
+
+/**
+  pm_pathMTUReduced is called by the message distribution when an ICMP fragmentation
+  needed or packet too big message reported a smaller MTU for pathID. The MTU of the
+  path is lowered, and a running PLPMTUD search does not probe above it any more.
+  Reports of an MTU that is not smaller than the current one are ignored.
+  @param pathID  index of the path the ICMP message refers to
+  @param mtu     the next hop MTU from the ICMP message (size of the IP packet)
+*/
+void pm_pathMTUReduced(short pathID, unsigned int mtu)
+{
+    PathData *path;
+
+    pmData = (PathmanData *) mdi_readPathMan();
+    if (pmData == NULL || pmData->pathData == NULL) {
+        error_log(ERROR_MAJOR, "pm_pathMTUReduced: no path data");
+        return;
+    }
+    if (!(pathID >= 0 && pathID < pmData->numberOfPaths)) {
+        error_logi(ERROR_MAJOR, "pm_pathMTUReduced: invalid path ID %d", pathID);
+        return;
+    }
+    if (mtu < MIN_MTU_SIZE) mtu = MIN_MTU_SIZE;
+    mtu &= ~3;
+    if (mtu - IP_HEADERLENGTH - sizeof(SCTP_common_header) >= fc_readMTU(pathID)) return;
+
+    event_logii(INTERNAL_EVENT_0, "pm_pathMTUReduced: path %d now has MTU %u", pathID, mtu);
+    fc_setMTU(pathID, mtu);
+
+    if (!pmData->plpmtudEnabled) return;
+    path = &pmData->pathData[pathID];
+    if (path->searchLow > mtu) path->searchLow = mtu;
+    if (path->searchHigh > mtu) path->searchHigh = mtu;
+    if (path->plpmtudState == PLPMTUD_SEARCHING && path->probedSize > mtu) {
+        /* the probe timer that is running sends the next probe */
+        pm_plpmtudNextProbe(pathID);
+    }
+}                               /* end: pm_pathMTUReduced */
+
+
+
 /**
   pm_rto_backoff is called by reliable transfer when the T3 retransmission timer expires.
   Each call of this function may double the RTO (timer back off).
@@ -797,6 +1166,10 @@ void pm_disableAllHB(void)
             pmData->pathData[pathID].heartbeatEnabled = FALSE;
             event_logi(INTERNAL_EVENT_0, "pm_disableAllHB: path %d disabled", (unsigned int) pathID);
         }
+        if (pmData->pathData[pathID].probeTimer != 0) {
+            sctp_stopTimer(pmData->pathData[pathID].probeTimer);
+            pmData->pathData[pathID].probeTimer = 0;
+        }
     }
 }                               /* end: pm_disableAllHB */
 
@@ -1216,6 +1589,20 @@ short pm_setPaths(short noOfPaths, short primaryPathID)
             pmData->pathData[i].hearbeatTimer = 0;
             pmData->pathData[i].pathID = i;
 
+            pmData->pathData[i].plpmtudState = PLPMTUD_DISABLED;
+            pmData->pathData[i].probedSize = 0;
+            pmData->pathData[i].probeCount = 0;
+            pmData->pathData[i].searchLow = 0;
+            pmData->pathData[i].searchHigh = 0;
+            pmData->pathData[i].probeTimer = 0;
+            if (pmData->plpmtudEnabled) {
+                /* first probe after one RTO, when the path may have been confirmed */
+                pmData->pathData[i].probeTimer =
+                    adl_startTimer(pmData->pathData[i].rto, &pm_probeTimer, TIMER_TYPE_HEARTBEAT,
+                                   (void *) &pmData->associationID,
+                                   (void *) &pmData->pathData[i].pathID);
+            }
+
             b = mdi_getDefaultMaxBurst();
 
             if (i != primaryPathID) {
@@ -1284,6 +1671,7 @@ void *pm_newPathman(short numberOfPaths, short primaryPath, void* sctpInstance)
     pmData->rto_initial = mdi_getDefaultRtoInitial(sctpInstance);
     pmData->rto_min = mdi_getDefaultRtoMin(sctpInstance);
     pmData->rto_max = mdi_getDefaultRtoMax(sctpInstance);
+    pmData->plpmtudEnabled = mdi_getDefaultPathMTUDiscovery(sctpInstance);
     return pmData;
 }                               /* end: pm_newPathman */
 
@@ -1308,6 +1696,10 @@ void pm_deletePathman(void *pathmanPtr)
                 adl_stopTimer(pmData->pathData[i].hearbeatTimer);
                 pmData->pathData[i].hearbeatTimer = 0;
             }
+            if (pmData->pathData[i].probeTimer != 0) {
+                adl_stopTimer(pmData->pathData[i].probeTimer);
+                pmData->pathData[i].probeTimer = 0;
+            }
         }
     }
 
@@ -115,6 +115,19 @@ void pm_chunksSentOn(short pathID);
 gboolean pm_chunksRetransmitted(short pathID);
 
 
+/* pm_pathUnreachable is called by message distribution, when an ICMP message reported
+   the destination of a path as unreachable.
+   Params: pathID:      path-ID
+*/
+void pm_pathUnreachable(short pathID);
+
+
+/* pm_pathMTUReduced is called by message distribution, when an ICMP message reported
+   a smaller MTU (IP packet size) for a path.
+*/
+void pm_pathMTUReduced(short pathID, unsigned int mtu);
+
+
 
 /* pm_rto_backoff is called by reliable transfer when the T3 retransmission timer expires.
    Each call of this function doubles the RTO (timer back off).
@@ -173,6 +186,11 @@ int  pm_setHBInterval(unsigned int new_interval);
 
 int pm_getHBInterval(short pathID, unsigned int* current_interval);
 
+/* switches packetization layer path MTU discovery on or off for the current association */
+int pm_setPathMTUDiscovery(gboolean enabled);
+
+gboolean pm_getPathMTUDiscovery(void);
+
 
 int  pm_setMaxPathRetransmisions(int new_max);
 
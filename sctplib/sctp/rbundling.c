@@ -45,6 +45,7 @@
 #include "messages.h"
 #include "recvctrl.h"
 #include "reltransfer.h"
+#include "flowcontrol.h"
 #include "errorhandler.h"
 #include "streamengine.h"
 #include "distribution.h"
@@ -406,9 +407,29 @@ gint rbu_rcvDatagram(guint address_index, guchar * datagram, guint len)
         switch (chunk->chunk_header.chunk_id) {
         case CHUNK_DATA:
             event_log(INTERNAL_EVENT_0, "*******************  Bundling received DATA chunk");
+            if (mdi_supportsIDATA() == TRUE) {
+                /* RFC 8260, section 2.2 : DATA chunks must not be used, once I-DATA was negotiated */
+                error_log(ERROR_MINOR, "DATA chunk received in an association using I-DATA -> ABORT");
+                scu_abort(ECC_PROTOCOL_VIOLATION, 0, NULL);
+                association_state = STATE_STOP_PARSING_REMOVED;
+                break;
+            }
             rxc_data_chunk_rx((SCTP_data_chunk*) chunk, address_index);
             data_chunk_received = TRUE;
             break;
+        case CHUNK_IDATA:
+            if (mdi_supportsIDATA() == TRUE) {
+                event_log(INTERNAL_EVENT_0, "*******************  Bundling received I-DATA chunk");
+                /* TSN and chunk length are at the same position as in a DATA chunk */
+                rxc_data_chunk_rx((SCTP_data_chunk*) chunk, address_index);
+                data_chunk_received = TRUE;
+            } else {
+                /* not negotiated : treat it like any unknown chunk type 01 */
+                processed_len = len;
+                eh_send_unrecognized_chunktype((unsigned char*)chunk,chunk_len);
+                event_log(EXTERNAL_EVENT_X, "I-DATA chunk received, but not negotiated");
+            }
+            break;
         case CHUNK_INIT:
             event_log(INTERNAL_EVENT_0, "*******************  Bundling received INIT chunk");
             association_state = sctlr_init((SCTP_init *) chunk);
@@ -421,6 +442,12 @@ gint rbu_rcvDatagram(guint address_index, guchar * datagram, guint len)
             event_log(INTERNAL_EVENT_0, "*******************  Bundling received SACK chunk");
             rtx_process_sack(address_index, chunk, len);
             break;
+        case CHUNK_NR_SACK:
+            if (mdi_supportsNRSACK() == TRUE) {
+                event_log(INTERNAL_EVENT_0, "*******************  Bundling received NR-SACK chunk");
+                rtx_process_sack(address_index, chunk, len);
+            }
+            break;
         case CHUNK_HBREQ:
             event_log(INTERNAL_EVENT_0, "*******************  Bundling received HB_REQ chunk");
             pm_heartbeat((SCTP_heartbeat *) chunk, address_index);
@@ -453,11 +480,18 @@ gint rbu_rcvDatagram(guint address_index, guchar * datagram, guint len)
             event_log(INTERNAL_EVENT_0, "*******************  Bundling received COOKIE ACK chunk");
             sctlr_cookieAck((SCTP_simple_chunk *) chunk);
             break;
-     /* case CHUNK_ECNE:
+        case CHUNK_ECNE:
+            if (mdi_supportsECN() == TRUE) {
+                event_log(INTERNAL_EVENT_0, "*******************  Bundling received ECNE chunk");
+                fc_process_ecne(chunk, address_index);
+            }
+            break;
         case CHUNK_CWR:
-            event_logi(INTERNAL_EVENT_0,
-                       "Chunktype %u not Supported Yet !!!!!!!!", chunk->chunk_header.chunk_id);
-            break;*/
+            if (mdi_supportsECN() == TRUE) {
+                event_log(INTERNAL_EVENT_0, "*******************  Bundling received CWR chunk");
+                rxc_process_cwr(chunk);
+            }
+            break;
         case CHUNK_SHUTDOWN_COMPLETE:
             event_log(INTERNAL_EVENT_0, "*******************  Bundling received SHUTDOWN_COMPLETE chunk");
             association_state = sctlr_shutdownComplete();
@@ -530,7 +564,13 @@ gint rbu_rcvDatagram(guint address_index, guchar * datagram, guint len)
          * see section 6.2, second paragraph
          */
         if (data_chunk_received == TRUE){
-            send_it = rxc_create_sack(&address_index, FALSE);
+            /* DATA in a packet marked CE is answered by an ECNE chunk at once */
+            if (mdi_congestionExperienced() == TRUE) {
+                rxc_congestion_experienced();
+                send_it = rxc_create_sack(&address_index, TRUE);
+            } else {
+                send_it = rxc_create_sack(&address_index, FALSE);
+            }
             se_doNotifications();
             if (send_it==TRUE) bu_sendAllChunks(&address_index);
         }
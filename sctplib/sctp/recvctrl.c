@@ -45,12 +45,24 @@
 #include "adaptation.h"
 #include "bundling.h"
 #include "distribution.h"
+#include "flowcontrol.h"
+#include "pathmanagement.h"
 #include "streamengine.h"
 #include "SCTP-control.h"
+#include "trace.h"
 
 #include <glib.h>
 #include <string.h>
 
+/* a bulk receiver acks at most every RXC_MAX_ACK_PACKETS packets ... */
+#define RXC_MAX_ACK_PACKETS     16
+/* ... but leaves the sender at least RXC_MIN_SACKS_PER_RTT SACKs per round trip */
+#define RXC_MIN_SACKS_PER_RTT   4
+/* the receive rate counts as stable, when a round trip brings at most 1/RXC_RATE_GROWTH more packets */
+#define RXC_RATE_GROWTH         8
+/* autotuning never shrinks the receiver window below this */
+#define RXC_MIN_TUNED_RWND      (4 * DEFAULT_SCTP_PDU)
+
 /**
  * this struct contains all necessary data for creating SACKs from received data chunks
  */
@@ -61,6 +73,8 @@ typedef struct rxc_buffer_struct
     void *sack_chunk;
     /** */
     GList *frag_list;
+    /** fragments of TSNs above ctsna, that have been delivered to the ULP (non-renegable) */
+    GList *nr_frag_list;
     /** */
     GList *dup_list;
     /** cumulative TSN acked */
@@ -79,21 +93,57 @@ typedef struct rxc_buffer_struct
     /** timer for delayed sacks */
     TimerID sack_timer;
     int datagrams_received;
-     /* either 1 (= sack each data chunk) or 2 (=sack every second chunk)*/
+     /* either 1 (= sack each data chunk) or 2 (= adaptive, sack every ack_packets packets) */
     unsigned int sack_flag;
+    /** TRUE, if a chunk asked for a SACK without delay (I-bit), or a duplicate was received */
+    boolean sack_immediately;
+    /** packets with DATA, that have been received since the last SACK was sent */
+    unsigned int packets_unacked;
+    /** bytes of new DATA chunks, that have been received since the last SACK was sent */
+    unsigned int bytes_unacked;
+    /** current number of packets, after which a SACK is sent (2 at low rates) */
+    unsigned int ack_packets;
+    /** smoothed number of packets with DATA, that arrive per round trip time */
+    unsigned int packets_per_rtt;
+    /** packets with DATA, that arrived since rate_start */
+    unsigned int rate_packets;
+    /** start of the current rate measurement */
+    struct timeval rate_start;
     /** */
     unsigned int last_address;
     /** */
     unsigned int my_association;
-    /** */
+    /** largest receiver window, the limit of autotuning */
     unsigned int my_rwnd;
+    /** TRUE, if the receiver window follows the rate at which the ULP reads data */
+    boolean rwnd_autotuning;
+    /** receiver window, that autotuning currently allows (at most my_rwnd) */
+    unsigned int tuned_rwnd;
+    /** bytes read by the ULP since consume_start */
+    unsigned int consumed_bytes;
+    /** start of the current measurement of the ULP's reading rate */
+    struct timeval consume_start;
     /** delay for delayed ACK in msecs */
     unsigned int delay;
     /** number of dest addresses */
     unsigned int num_of_addresses;
+    /** TRUE, while an ECNE chunk is to be bundled with every SACK (until a CWR arrives) */
+    boolean ecne_pending;
+    /** TSN reported in the ECNE chunk : highest TSN received in a packet marked CE */
+    unsigned int ecne_tsn;
+    /** TRUE, when ctsna or the fragments have changed since the gap ack blocks were written */
+    boolean sack_blocks_changed;
+    /** largest length of sack_chunk, for which the gap ack blocks were written */
+    unsigned int sack_limit;
+    /** offset of the duplicate TSNs in sack_chunk */
+    unsigned int sack_dups_pos;
     /*@} */
 } rxc_buffer;
 
+static unsigned int rxc_sack_limit(unsigned int path);
+static void rxc_write_duplicates(rxc_buffer * rbuf);
+static void rxc_update_sack(rxc_buffer * rbuf, unsigned int limit);
+
 
 /**
  * function creates and allocs new rxc_buffer structure.
@@ -111,9 +161,11 @@ void *rxc_new_recvctrl(unsigned int remote_initial_TSN, unsigned int number_of_d
     if (!tmp) error_log(ERROR_FATAL, "Malloc failed");
 
     tmp->frag_list = NULL;
+    tmp->nr_frag_list = NULL;
     tmp->dup_list = NULL;
     tmp->num_of_addresses = number_of_destination_addresses;
-    tmp->sack_chunk = malloc(sizeof(SCTP_sack_chunk));
+    /* large enough for a SACK or an NR-SACK */
+    tmp->sack_chunk = malloc(sizeof(SCTP_nr_sack_chunk));
     tmp->ctsna = remote_initial_TSN - 1; /* as per section 4.1 */
     tmp->lowest = remote_initial_TSN - 1;
     tmp->highest = remote_initial_TSN - 1;
@@ -121,9 +173,25 @@ void *rxc_new_recvctrl(unsigned int remote_initial_TSN, unsigned int number_of_d
     tmp->timer_running = FALSE;
     tmp->datagrams_received = -1;
     tmp->sack_flag = 2;
+    tmp->sack_immediately = FALSE;
+    tmp->packets_unacked = 0;
+    tmp->bytes_unacked = 0;
+    tmp->ack_packets = 2;
+    tmp->packets_per_rtt = 0;
+    tmp->rate_packets = 0;
+    adl_gettime(&(tmp->rate_start));
     tmp->last_address = 0;
     tmp->my_rwnd =  mdi_getDefaultMyRwnd();
+    tmp->rwnd_autotuning = mdi_getDefaultRwndAutotuning(sctpInstance);
+    tmp->tuned_rwnd = mdi_getInitialMyRwnd();
+    tmp->consumed_bytes = 0;
+    adl_gettime(&(tmp->consume_start));
     tmp->delay =    mdi_getDefaultDelay(sctpInstance);
+    tmp->ecne_pending = FALSE;
+    tmp->ecne_tsn = remote_initial_TSN - 1;
+    tmp->sack_blocks_changed = TRUE;
+    tmp->sack_limit = 0;
+    tmp->sack_dups_pos = 0;
     tmp->my_association = mdi_readAssociationID();
     event_logi(VVERBOSE, "RecvControl : Association-ID== %d ", tmp->my_association);
     if (tmp->my_association == 0)
@@ -149,6 +217,8 @@ void rxc_delete_recvctrl(void *rxc_instance)
 
     g_list_foreach(tmp->frag_list, &free_list_element, NULL);
     g_list_free(tmp->frag_list);
+    g_list_foreach(tmp->nr_frag_list, &free_list_element, NULL);
+    g_list_free(tmp->nr_frag_list);
     g_list_foreach(tmp->dup_list, &free_list_element, NULL);
     g_list_free(tmp->dup_list);
     free(tmp);
@@ -436,6 +506,83 @@ boolean rxc_update_fragments(rxc_buffer * rbuf, unsigned int ch_tsn)
 }
 
 
+/**
+ * Helper function that returns the size of the receive buffer : my_rwnd, or the part
+ * of it that autotuning allows
+ * @param rbuf	instance of rxc_buffer
+ */
+static unsigned int rxc_window_size(rxc_buffer * rbuf)
+{
+    if (rbuf->rwnd_autotuning == FALSE || rbuf->tuned_rwnd > rbuf->my_rwnd) return rbuf->my_rwnd;
+    return rbuf->tuned_rwnd;
+}
+
+/**
+ * Helper function that tunes the receiver window, after the ULP has read bytes : once per
+ * round trip, the window grows to twice the amount read in that round trip, so that the
+ * sender is not limited by our window, while the ULP keeps up. An association, whose data
+ * is not read, keeps its small window. Under memory pressure, the window is halved.
+ * @param rbuf	instance of rxc_buffer
+ * @param bytes	number of bytes the ULP has read
+ */
+static void rxc_tune_window(rxc_buffer * rbuf, unsigned int bytes)
+{
+    struct timeval now;
+    unsigned int rtt, target;
+    int elapsed;
+
+    if (rbuf->rwnd_autotuning == FALSE) return;
+    rbuf->consumed_bytes += bytes;
+
+    rtt = pm_readSRTT((short)rbuf->last_address);
+    if (rtt == 0 || rtt == 0xffffffff) rtt = rbuf->delay;
+    adl_gettime(&now);
+    elapsed = adl_timediff_to_msecs(&now, &(rbuf->consume_start));
+    if (elapsed >= 0 && (unsigned int)elapsed < rtt) return;
+
+    if (mdi_limitReceiverWindow(rbuf->tuned_rwnd) < rbuf->tuned_rwnd) {
+        /* the library runs short of its memory budget */
+        rbuf->tuned_rwnd /= 2;
+        if (rbuf->tuned_rwnd < RXC_MIN_TUNED_RWND) rbuf->tuned_rwnd = RXC_MIN_TUNED_RWND;
+    } else {
+        target = 2 * rbuf->consumed_bytes;
+        if (target > rbuf->my_rwnd) target = rbuf->my_rwnd;
+        if (target > rbuf->tuned_rwnd) rbuf->tuned_rwnd = target;
+    }
+    event_logiii(VERBOSE, "rxc_tune_window: ULP read %u bytes in %d msecs, window is %u now",
+                 rbuf->consumed_bytes, elapsed, rbuf->tuned_rwnd);
+    rbuf->consumed_bytes = 0;
+    rbuf->consume_start = now;
+}
+
+/**
+ * Helper function that computes the receiver window we may currently advertise:
+ * the receive buffer minus the data waiting to be picked up by the ULP, reduced further
+ * when the library runs short of its memory budget
+ * @param rbuf	instance of rxc_buffer
+ * @return the current receiver window
+ */
+static unsigned int rxc_current_window(rxc_buffer * rbuf)
+{
+    int bytesQueued = 0;
+    unsigned int current_rwnd = 0, window;
+
+    bytesQueued = se_getQueuedBytes();
+    if (bytesQueued < 0) bytesQueued = 0;
+    window = rxc_window_size(rbuf);
+    if ((unsigned int)bytesQueued > window) {
+        current_rwnd = 0;
+    } else {
+        current_rwnd = window - bytesQueued;
+    }
+    current_rwnd = mdi_limitReceiverWindow(current_rwnd);
+
+    /* do SWS prevention */
+    if (current_rwnd > 0 && current_rwnd <= 2 * DEFAULT_SCTP_PDU) current_rwnd = 1;
+    return current_rwnd;
+}
+
+
 /**
  * For now this function treats only one incoming data chunk' tsn
  * @param chunk the data chunk that was received by the bundling
@@ -447,7 +594,6 @@ int rxc_data_chunk_rx(SCTP_data_chunk * se_chk, unsigned int ad_idx)
     unsigned int chunk_len;
     unsigned int assoc_state;
     boolean result = FALSE;
-    int bytesQueued = 0;
     unsigned current_rwnd = 0;
 
     event_log(INTERNAL_EVENT_0, "Entering function rxc_data_chunk_rx");
@@ -462,16 +608,7 @@ int rxc_data_chunk_rx(SCTP_data_chunk * se_chk, unsigned int ad_idx)
     rxc->new_chunk_received = FALSE;
     rxc->last_address = ad_idx;
 
-    bytesQueued = se_getQueuedBytes();
-    if (bytesQueued < 0) bytesQueued = 0;
-    if ((unsigned int)bytesQueued > rxc->my_rwnd) {
-        current_rwnd = 0;
-    } else {
-        current_rwnd = rxc->my_rwnd - bytesQueued;
-    }
-
-    /* do SWS prevention */
-    if (current_rwnd > 0 && current_rwnd <= 2 * MAX_SCTP_PDU) current_rwnd = 1;
+    current_rwnd = rxc_current_window(rxc);
 
     /*
      * if any received data chunks have not been acked, sender
@@ -483,6 +620,8 @@ int rxc_data_chunk_rx(SCTP_data_chunk * se_chk, unsigned int ad_idx)
     chunk_len = ntohs(se_chk->chunk_length);
     assoc_state = sci_getState();
 
+    if (se_chk->chunk_flags & SCTP_DATA_SACK_IMMEDIATELY) rxc->sack_immediately = TRUE;
+
     if ( (after(chunk_tsn, rxc->highest) && current_rwnd == 0) ||
          (assoc_state == SHUTDOWNRECEIVED) ||
          (assoc_state == SHUTDOWNACKSENT) ) {
@@ -502,19 +641,32 @@ int rxc_data_chunk_rx(SCTP_data_chunk * se_chk, unsigned int ad_idx)
     if (rxc_update_lowest(rxc, chunk_tsn) == TRUE) {
         /* tsn is even lower than the lowest one received so far */
         rxc_update_duplicates(rxc, chunk_tsn);
+        rxc->sack_immediately = TRUE;
+        trc_event(SCTP_TRACE_MODULE_RECVCTRL, TRC_DATA_DUPLICATE, rxc->my_association, chunk_tsn, 0);
+        mdi_readStatistics()->duplicateTsnsReceived++;
     } else if (rxc_update_highest(rxc, chunk_tsn) == TRUE) {
         rxc->new_chunk_received = TRUE;
         result = rxc_update_fragments(rxc, chunk_tsn);
-    } else if (rxc_chunk_is_duplicate(rxc, chunk_tsn) == TRUE)
+    } else if (rxc_chunk_is_duplicate(rxc, chunk_tsn) == TRUE) {
         rxc_update_duplicates(rxc, chunk_tsn);
-    else
+        rxc->sack_immediately = TRUE;
+        trc_event(SCTP_TRACE_MODULE_RECVCTRL, TRC_DATA_DUPLICATE, rxc->my_association, chunk_tsn, 0);
+        mdi_readStatistics()->duplicateTsnsReceived++;
+    } else
         result = rxc_update_fragments(rxc, chunk_tsn);
 
+    trc_event(SCTP_TRACE_MODULE_RECVCTRL, TRC_DATA_RECEIVED, rxc->my_association, chunk_tsn, chunk_len);
+
     if (result == TRUE) rxc_bubbleup_ctsna(rxc);
+    if (rxc->new_chunk_received == TRUE) {
+        rxc->sack_blocks_changed = TRUE;
+        rxc->bytes_unacked += chunk_len;
+    }
 
     event_logi(VVERBOSE, "rxc_data_chunk_rx: after rxc_bubbleup_ctsna, rxc->ctsna=%u", rxc->ctsna);
 
     if (rxc->new_chunk_received == TRUE) {
+        mdi_readStatistics()->dataChunksReceived++;
         if(se_recvDataChunk(se_chk, chunk_len, ad_idx) == SCTP_SUCCESS) {
             /* resetting it */
             rxc->new_chunk_received = FALSE;
@@ -524,6 +676,139 @@ int rxc_data_chunk_rx(SCTP_data_chunk * se_chk, unsigned int ad_idx)
     return 1;
 }
 
+/**
+ * called by the streamengine, when the ULP has read the data of a chunk : from now on,
+ * the chunk may no longer be reneged, and is reported in the NR gap ack blocks of an
+ * NR-SACK, so that the peer can free it at once
+ * @param tsn	TSN of the chunk, that was delivered
+ */
+void rxc_data_delivered(unsigned int tsn)
+{
+    rxc_buffer *rxc;
+    fragment32 *frag, *next_frag, *new_frag;
+    GList *current = NULL, *next = NULL;
+
+    rxc = (rxc_buffer *) mdi_readRX_control();
+    if (!rxc) {
+        error_log(ERROR_MAJOR, "rxc_buffer instance not set !");
+        return;
+    }
+    if (mdi_supportsNRSACK() == FALSE || !after(tsn, rxc->ctsna)) return;
+    rxc->sack_blocks_changed = TRUE;
+
+    event_logi(VVERBOSE, "rxc_data_delivered: TSN %u is non-renegable now", tsn);
+
+    current = g_list_first(rxc->nr_frag_list);
+    while (current != NULL) {
+        frag = (fragment32*)current->data;
+        if (between(frag->start_tsn, tsn, frag->stop_tsn)) return;
+        if (tsn == frag->start_tsn - 1) {
+            frag->start_tsn = tsn;
+            return;
+        }
+        if (tsn == frag->stop_tsn + 1) {
+            frag->stop_tsn = tsn;
+            /* join with the next fragment, if the gap is closed now */
+            next = g_list_next(current);
+            if (next != NULL) {
+                next_frag = (fragment32*)next->data;
+                if (next_frag->start_tsn == tsn + 1) {
+                    frag->stop_tsn = next_frag->stop_tsn;
+                    rxc->nr_frag_list = g_list_remove_link(rxc->nr_frag_list, next);
+                    g_list_free_1(next); free(next_frag);
+                }
+            }
+            return;
+        }
+        if (before(tsn, frag->start_tsn)) break;
+        current = g_list_next(current);
+    }
+    new_frag = (fragment32*)malloc(sizeof(fragment32));
+    if (new_frag == NULL) return;
+    new_frag->start_tsn = new_frag->stop_tsn = tsn;
+    rxc->nr_frag_list = g_list_insert_sorted(rxc->nr_frag_list, new_frag, (GCompareFunc) rxc_sort_fragments);
+}
+
+/**
+ * bundles an ECNE chunk with the SACK, while the peer has not yet answered with a CWR
+ */
+static void rxc_put_ecne(rxc_buffer * rxc, unsigned int *destination_address)
+{
+    SCTP_ecn_chunk ecne;
+
+    if (rxc->ecne_pending == FALSE) return;
+
+    ecne.chunk_header.chunk_id = CHUNK_ECNE;
+    ecne.chunk_header.chunk_flags = 0;
+    ecne.chunk_header.chunk_length = htons(sizeof(SCTP_ecn_chunk));
+    ecne.tsn = htonl(rxc->ecne_tsn);
+    event_logi(VERBOSE, "rxc_put_ecne: sending ECNE for TSN %u", rxc->ecne_tsn);
+    bu_put_Ctrl_Chunk((SCTP_simple_chunk *) &ecne, destination_address);
+}
+
+/**
+ * Helper function that adapts the number of packets per SACK to the receive rate : the
+ * packets arriving per round trip are counted, and a bulk receiver sends only as many
+ * SACKs as the sender needs to keep its window moving (RXC_MIN_SACKS_PER_RTT). At low
+ * rates, and while the rate still grows (i.e. the sender is in slow start, where its
+ * window grows with every SACK), every second packet is acked as before.
+ * @param rbuf	instance of rxc_buffer
+ */
+static void rxc_update_ack_rate(rxc_buffer * rbuf)
+{
+    struct timeval now;
+    unsigned int rtt;
+    int elapsed;
+    boolean growing;
+
+    rbuf->rate_packets++;
+    rtt = pm_readSRTT((short)rbuf->last_address);
+    if (rtt == 0 || rtt == 0xffffffff) rtt = rbuf->delay;
+
+    adl_gettime(&now);
+    elapsed = adl_timediff_to_msecs(&now, &(rbuf->rate_start));
+    if (elapsed >= 0 && (unsigned int)elapsed < rtt) return;
+
+    /* one round trip has passed */
+    growing = (rbuf->rate_packets > rbuf->packets_per_rtt + rbuf->packets_per_rtt / RXC_RATE_GROWTH);
+    rbuf->packets_per_rtt = (rbuf->packets_per_rtt + rbuf->rate_packets) / 2;
+    rbuf->rate_packets = 0;
+    rbuf->rate_start = now;
+
+    if (growing == TRUE) {
+        rbuf->ack_packets = 2;
+    } else {
+        rbuf->ack_packets = rbuf->packets_per_rtt / RXC_MIN_SACKS_PER_RTT;
+    }
+    if (rbuf->ack_packets < 2) rbuf->ack_packets = 2;
+    if (rbuf->ack_packets > RXC_MAX_ACK_PACKETS) rbuf->ack_packets = RXC_MAX_ACK_PACKETS;
+    event_logii(VERBOSE, "rxc_update_ack_rate: %u packets per RTT, SACK every %u packets",
+                rbuf->packets_per_rtt, rbuf->ack_packets);
+}
+
+/**
+ * Helper function that decides, whether the SACK for the packets received so far may
+ * still wait (for more packets, or for the SACK timer)
+ * @param rbuf	instance of rxc_buffer
+ * @return TRUE, if no SACK needs to be sent now
+ */
+static boolean rxc_may_delay_sack(rxc_buffer * rbuf)
+{
+    unsigned int ack_bytes;
+
+    /* the sender asked for a SACK, or we have duplicates or gaps to report */
+    if (rbuf->sack_immediately == TRUE || rbuf->sack_flag == 1) return FALSE;
+    /* the first packet is acked at once */
+    if (rbuf->datagrams_received == 0) return FALSE;
+
+    /* do not let the peer's view of our window fall behind by more than a quarter */
+    ack_bytes = rbuf->ack_packets * rxc_sack_limit(rbuf->last_address);
+    if (ack_bytes > rxc_window_size(rbuf) / 4) ack_bytes = rxc_window_size(rbuf) / 4;
+
+    if (rbuf->packets_unacked >= rbuf->ack_packets || rbuf->bytes_unacked >= ack_bytes) return FALSE;
+    return TRUE;
+}
+
 /**
  * Function triggered by flowcontrol, tells recvcontrol to
  * send SACK to bundling using bu_put_SACK_Chunk() function.
@@ -549,6 +834,10 @@ boolean rxc_create_sack(unsigned int *destination_address, boolean force_sack)
         event_log(INTERNAL_EVENT_0, "SACK structure was not updated (should have been)");
         rxc_all_chunks_processed(FALSE);
     }
+    if (destination_address != NULL && rxc_sack_limit(*destination_address) < rxc->sack_limit) {
+        /* the SACK goes to a path with a smaller MTU */
+        rxc_update_sack(rxc, rxc_sack_limit(*destination_address));
+    }
 
     num_of_frags = g_list_length(rxc->frag_list);
 
@@ -557,12 +846,16 @@ boolean rxc_create_sack(unsigned int *destination_address, boolean force_sack)
     else
         rxc_send_sack_every_second_time();
 
-    /* send sacks along every second time, generally */
+    /* send sacks along every ack_packets packets, generally */
     /* some timers may want to have a SACK anyway */
     /* first sack is sent at once, since datagrams_received==-1 */
     if (force_sack == TRUE) {
         rxc->lowest = rxc->ctsna;
         bu_put_SACK_Chunk((SCTP_sack_chunk*)rxc->sack_chunk, destination_address);
+        rxc_put_ecne(rxc, destination_address);
+        trc_event(SCTP_TRACE_MODULE_RECVCTRL, TRC_SACK_SENT, rxc->my_association, rxc->ctsna,
+                  ntohl(((SCTP_sack_chunk*)rxc->sack_chunk)->a_rwnd));
+        mdi_readStatistics()->sacksSent++;
         return TRUE;
     } else {
 
@@ -570,12 +863,18 @@ boolean rxc_create_sack(unsigned int *destination_address, boolean force_sack)
         if (rxc->datagrams_received == -1)
             return FALSE;
 
-        if (rxc->datagrams_received % rxc->sack_flag != 0) {
-                event_log(VVERBOSE, "Did not send SACK here - returning");
+        if (rxc_may_delay_sack(rxc) == TRUE) {
+                event_logii(VVERBOSE, "Did not send SACK here (%u of %u packets) - returning",
+                            rxc->packets_unacked, rxc->ack_packets);
+                mdi_readStatistics()->sacksSuppressed++;
                 return FALSE;
         }
         rxc->lowest = rxc->ctsna;
         bu_put_SACK_Chunk((SCTP_sack_chunk*)rxc->sack_chunk,destination_address);
+        rxc_put_ecne(rxc, destination_address);
+        trc_event(SCTP_TRACE_MODULE_RECVCTRL, TRC_SACK_SENT, rxc->my_association, rxc->ctsna,
+                  ntohl(((SCTP_sack_chunk*)rxc->sack_chunk)->a_rwnd));
+        mdi_readStatistics()->sacksSent++;
         return TRUE;
     }
     return FALSE;
@@ -638,6 +937,11 @@ void rxc_stop_sack_timer(void)
     g_list_foreach(rxc->dup_list, &free_list_element, NULL);
     g_list_free(rxc->dup_list);
     rxc->dup_list = NULL;
+    if (rxc->sack_limit > 0) rxc_write_duplicates(rxc);
+    /* all data received so far has been acked */
+    rxc->sack_immediately = FALSE;
+    rxc->packets_unacked = 0;
+    rxc->bytes_unacked = 0;
 
     if (rxc->timer_running == TRUE) {
         result = sctp_stopTimer(rxc->sack_timer);
@@ -660,102 +964,213 @@ boolean rxc_sack_timer_is_running(void)
 }
 
 /**
- * called by bundling, after new data has been processed (so we may start building a sack chunk)
- * or by streamengine, when ULP has read some data, and we want to update the RWND.
+ * Helper function that removes the non-renegable fragments, which the ctsna has passed
+ * @param rbuf	instance of rxc_buffer
  */
-void rxc_all_chunks_processed(boolean new_data_received)
+static void rxc_prune_nr_fragments(rxc_buffer * rbuf)
+{
+    fragment32 *frag;
+    GList *temp = NULL;
+
+    temp = g_list_first(rbuf->nr_frag_list);
+    while (temp != NULL) {
+        frag = (fragment32*)temp->data;
+        if (after(frag->stop_tsn, rbuf->ctsna)) {
+            if (!after(frag->start_tsn, rbuf->ctsna)) frag->start_tsn = rbuf->ctsna + 1;
+            return;
+        }
+        rbuf->nr_frag_list = g_list_remove_link(rbuf->nr_frag_list, temp);
+        g_list_free_1(temp); free(frag);
+        temp = g_list_first(rbuf->nr_frag_list);
+    }
+}
+
+/**
+ * Helper function that returns the largest length of a SACK chunk for a path : a SACK
+ * takes the path MTU, and leaves room for an ECNE chunk
+ * @param path	index of the destination address
+ */
+static unsigned int rxc_sack_limit(unsigned int path)
+{
+    unsigned int pdu;
+
+    pdu = fc_readMTU((short)path);
+    if (pdu == 0) pdu = DEFAULT_SCTP_PDU;
+    return pdu - sizeof(SCTP_ecn_chunk) - 4;
+}
+
+/**
+ * Helper function that writes gap ack blocks of a list of fragments into a SACK chunk.
+ * If not all blocks fit, the most recent ones are taken, as they tell the sender more
+ * about its window. The blocks are written in ascending order.
+ * @param rbuf	instance of rxc_buffer
+ * @param list	sorted list of fragment32 entries
+ * @param max	maximum number of blocks to write
+ * @param buf	position in the SACK chunk, where the blocks go
+ * @return number of blocks that were written
+ */
+static unsigned short rxc_write_gap_blocks(rxc_buffer * rbuf, GList * list,
+                                           unsigned short max, guchar * buf)
 {
-    /* now go and create SACK structure from the array */
-    rxc_buffer *rxc=NULL;
-    SCTP_sack_chunk *sack=NULL;
-    unsigned short num_of_frags, num_of_dups;
-    unsigned short len16, count, frag_start16, frag_stop16;
-    unsigned int pos;
-    duplicate *dptr=NULL, d;
     fragment32 *f32=NULL;
     fragment chunk_frag;
     GList *temp=NULL;
-    int bytesQueued = 0;
-    unsigned current_rwnd = 0;
+    unsigned short count = 0;
 
-    event_log(INTERNAL_EVENT_0, "Entering funtion rxc_all_chunks_processed ()");
+    temp = g_list_last(list);
+    while ((temp != NULL) && (count < max)) {
 
-    rxc = (rxc_buffer *) mdi_readRX_control();
-    if (!rxc) {
-        error_log(ERROR_MAJOR, "rxc_buffer instance not set !");
-        return;
-    }
-
-    if (new_data_received == TRUE) rxc->datagrams_received++;
+        f32 = (fragment32*)temp->data;
+        temp = g_list_previous(temp);
 
-    num_of_frags = g_list_length(rxc->frag_list);
-    num_of_dups  = g_list_length(rxc->dup_list);
+        event_logiii(VVERBOSE,"ctsna==%u, fragment.start==%u, fragment.stop==%u",
+                     rbuf->ctsna, f32->start_tsn, f32->stop_tsn);
 
-    /* limit size of SACK to 80 bytes plus fixed size chunk and chunk header */
-    /* FIXME : Limit number of Fragments/Duplicates according to ->PATH MTU<-  */
-    if (num_of_frags > 10) num_of_frags = 10;
-    if (num_of_dups > 10)  num_of_dups = 10;
+        if ((f32->stop_tsn - rbuf->ctsna) > 0xFFFF) {
+            error_log(ERROR_MINOR, "Fragment offset becomes too big");
+            continue;
+        }
+        chunk_frag.start = htons((unsigned short)(f32->start_tsn - rbuf->ctsna));
+        chunk_frag.stop = htons((unsigned short)(f32->stop_tsn - rbuf->ctsna));
+        event_logii(VVERBOSE, "chunk_frag.start=%u,chunk_frag.stop ==%u",
+                                ntohs(chunk_frag.start), ntohs(chunk_frag.stop));
+        count++;
+        memcpy(&buf[(max - count) * sizeof(fragment)], &chunk_frag, sizeof(fragment));
+    }
+    if (count < max) memmove(buf, &buf[(max - count) * sizeof(fragment)], count * sizeof(fragment));
+    return count;
+}
 
-    event_logii(VVERBOSE, "len of frag_list==%u, len of dup_list==%u", num_of_frags, num_of_dups);
+/**
+ * Helper function that rewrites the fixed part and the gap ack blocks of the SACK chunk,
+ * with as many blocks as fit into limit bytes. The gap ack blocks take precedence over
+ * the non-renegable ones.
+ * @param rbuf	instance of rxc_buffer
+ * @param limit	largest length of the SACK chunk
+ */
+static void rxc_write_sack_blocks(rxc_buffer * rbuf, unsigned int limit)
+{
+    SCTP_sack_chunk *sack=NULL;
+    SCTP_nr_sack_chunk *nr_sack=NULL;
+    unsigned int num_of_frags, num_of_nr_frags, room;
+    guchar *blocks=NULL;
 
-    bytesQueued = se_getQueuedBytes();
-    if (bytesQueued < 0) bytesQueued = 0;
-    if ((unsigned int)bytesQueued > rxc->my_rwnd) {
-        current_rwnd = 0;
+    sack = (SCTP_sack_chunk*)rbuf->sack_chunk;
+    sack->chunk_header.chunk_flags = 0;
+    sack->cumulative_tsn_ack = htonl(rbuf->ctsna);
+
+    if (mdi_supportsNRSACK() == TRUE) {
+        /* NR-SACK : the gap ack blocks are followed by the non-renegable ones */
+        rxc_prune_nr_fragments(rbuf);
+        nr_sack = (SCTP_nr_sack_chunk*)rbuf->sack_chunk;
+        nr_sack->chunk_header.chunk_id = CHUNK_NR_SACK;
+        nr_sack->reserved = 0;
+        blocks = nr_sack->fragments_and_dups;
     } else {
-        current_rwnd = rxc->my_rwnd - bytesQueued;
+        sack->chunk_header.chunk_id = CHUNK_SACK;
+        blocks = sack->fragments_and_dups;
     }
-    /* do SWS prevention */
-    if (current_rwnd > 0 && current_rwnd <= 2 * MAX_SCTP_PDU) current_rwnd = 1;
+    room = (limit - (blocks - (guchar*)rbuf->sack_chunk)) / sizeof(fragment);
+
+    num_of_frags = g_list_length(rbuf->frag_list);
+    if (num_of_frags > room) num_of_frags = room;
+    num_of_frags = rxc_write_gap_blocks(rbuf, rbuf->frag_list, num_of_frags, blocks);
+    rbuf->sack_dups_pos = num_of_frags * sizeof(fragment);
+
+    if (nr_sack != NULL) {
+        num_of_nr_frags = g_list_length(rbuf->nr_frag_list);
+        if (num_of_nr_frags > room - num_of_frags) num_of_nr_frags = room - num_of_frags;
+        num_of_nr_frags = rxc_write_gap_blocks(rbuf, rbuf->nr_frag_list, num_of_nr_frags,
+                                               &blocks[rbuf->sack_dups_pos]);
+        rbuf->sack_dups_pos += num_of_nr_frags * sizeof(fragment);
+        nr_sack->num_of_fragments  = htons(num_of_frags);
+        nr_sack->num_of_nr_fragments = htons(num_of_nr_frags);
+    } else {
+        sack->num_of_fragments  = htons(num_of_frags);
+    }
+    rbuf->sack_dups_pos += blocks - (guchar*)rbuf->sack_chunk;
+    rbuf->sack_limit = limit;
+    rbuf->sack_blocks_changed = FALSE;
 
+    event_logiii(VVERBOSE, "rxc_write_sack_blocks: %u gap ack blocks, %u nr blocks, limit %u",
+                 num_of_frags, (nr_sack != NULL) ? num_of_nr_frags : 0, limit);
+}
 
-    sack = (SCTP_sack_chunk*)rxc->sack_chunk;
-    sack->chunk_header.chunk_id = CHUNK_SACK;
-    sack->chunk_header.chunk_flags = 0;
-    len16 = sizeof(SCTP_chunk_header) + (2 + num_of_dups) * sizeof(unsigned int) +
-            (2 * num_of_frags + 2) * sizeof(unsigned short);
+/**
+ * Helper function that writes the duplicate TSNs behind the gap ack blocks, as many as
+ * fit, and sets the length of the SACK chunk
+ * @param rbuf	instance of rxc_buffer
+ */
+static void rxc_write_duplicates(rxc_buffer * rbuf)
+{
+    SCTP_sack_chunk *sack=NULL;
+    unsigned short num_of_dups = 0;
+    unsigned int pos;
+    duplicate *dptr=NULL, d;
+    GList *temp=NULL;
 
-    sack->chunk_header.chunk_length = htons(len16);
-    sack->cumulative_tsn_ack = htonl(rxc->ctsna);
-    /* FIXME : deduct size of data still in queue, that is waiting to be picked up by an ULP */
-    sack->a_rwnd = htonl(current_rwnd);
-    sack->num_of_fragments  = htons(num_of_frags);
-    sack->num_of_duplicates = htons(num_of_dups);
-    pos = 0L;
+    sack = (SCTP_sack_chunk*)rbuf->sack_chunk;
+    pos = rbuf->sack_dups_pos;
+    temp = g_list_first(rbuf->dup_list);
+    while ((temp != NULL) && (pos + sizeof(duplicate) <= rbuf->sack_limit)) {
+        dptr = (duplicate*)temp->data;
+        d.duplicate_tsn = htonl(dptr->duplicate_tsn);
+        memcpy(&((guchar*)rbuf->sack_chunk)[pos], &d, sizeof(duplicate));
+        pos += sizeof(duplicate);
+        temp = g_list_next(temp); num_of_dups++;
+    }
+    if (sack->chunk_header.chunk_id == CHUNK_NR_SACK)
+        ((SCTP_nr_sack_chunk*)sack)->num_of_duplicates = htons(num_of_dups);
+    else
+        sack->num_of_duplicates = htons(num_of_dups);
+    sack->chunk_header.chunk_length = htons((unsigned short)pos);
+}
 
-    temp = g_list_first(rxc->frag_list); count = 0;
-    while ((temp != NULL) && (count < num_of_frags)) {
+/**
+ * Helper function that brings the SACK chunk up to date : the gap ack blocks are only
+ * rewritten, when they have changed, or when the SACK must fit a different size
+ * @param rbuf	instance of rxc_buffer
+ * @param limit	largest length of the SACK chunk
+ */
+static void rxc_update_sack(rxc_buffer * rbuf, unsigned int limit)
+{
+    /* the SACK chunk is sized for the default PDU, also on paths with a larger MTU */
+    if (limit > sizeof(SCTP_sack_chunk)) limit = sizeof(SCTP_sack_chunk);
+    if (rbuf->sack_blocks_changed == TRUE || limit != rbuf->sack_limit)
+        rxc_write_sack_blocks(rbuf, limit);
 
-        f32 = (fragment32*)temp->data;
+    ((SCTP_sack_chunk*)rbuf->sack_chunk)->a_rwnd = htonl(rxc_current_window(rbuf));
+    rxc_write_duplicates(rbuf);
+}
 
-        event_logiii(VVERBOSE,"ctsna==%u, fragment.start==%u, fragment.stop==%u",
-                     rxc->ctsna, f32->start_tsn, f32->stop_tsn);
+/**
+ * called by bundling, after new data has been processed (so we may start building a sack chunk)
+ * or by streamengine, when ULP has read some data, and we want to update the RWND.
+ */
+void rxc_all_chunks_processed(boolean new_data_received)
+{
+    rxc_buffer *rxc=NULL;
 
-        if (((f32->start_tsn - rxc->ctsna) > 0xFFFF) || ((f32->stop_tsn - rxc->ctsna) > 0xFFFF)) {
-            error_log(ERROR_MINOR, "Fragment offset becomes too big");
-            break;
-        }
-        frag_start16 = (unsigned short) (f32->start_tsn - rxc->ctsna);
-        frag_stop16 = (unsigned short) (f32->stop_tsn - rxc->ctsna);
-        event_logii(VVERBOSE, "frag_start16==%u, frag_stop16==%u", frag_start16, frag_stop16);
+    event_log(INTERNAL_EVENT_0, "Entering funtion rxc_all_chunks_processed ()");
 
-        chunk_frag.start = htons((unsigned short)(f32->start_tsn - rxc->ctsna));
-        chunk_frag.stop = htons((unsigned short)(f32->stop_tsn - rxc->ctsna));
-        event_logii(VVERBOSE, "chunk_frag.start=%u,chunk_frag.stop ==%u",
-                                ntohs(chunk_frag.start), ntohs(chunk_frag.stop));
-        memcpy(&sack->fragments_and_dups[pos], &chunk_frag, sizeof(fragment));
-        pos += sizeof(fragment);
-        temp = g_list_next(temp); count++;
+    rxc = (rxc_buffer *) mdi_readRX_control();
+    if (!rxc) {
+        error_log(ERROR_MAJOR, "rxc_buffer instance not set !");
+        return;
     }
 
-    temp = g_list_first(rxc->dup_list); count = 0;
-    while ((temp != NULL) && (count < num_of_dups)) {
-        dptr = (duplicate*)temp->data;
-        if (dptr) d.duplicate_tsn = htonl(dptr->duplicate_tsn);
-        memcpy(&sack->fragments_and_dups[pos], &d, sizeof(duplicate));
-        pos += sizeof(duplicate);
-        temp = g_list_next(temp); count++;
+    if (new_data_received == TRUE) {
+        rxc->datagrams_received++;
+        rxc->packets_unacked++;
+        rxc_update_ack_rate(rxc);
     }
+
+    event_logii(VVERBOSE, "len of frag_list==%u, len of dup_list==%u",
+                g_list_length(rxc->frag_list), g_list_length(rxc->dup_list));
+
+    /* the SACK takes as many gap ack blocks and duplicates, as fit into the path MTU */
+    rxc_update_sack(rxc, rxc_sack_limit(rxc->last_address));
+
     /* start sack_timer set to 200 msecs */
     if (rxc->timer_running != TRUE && new_data_received == TRUE) {
         rxc->sack_timer = adl_startTimer(rxc->delay, &rxc_sack_timer_cb, TIMER_TYPE_SACK, &(rxc->my_association), NULL);
@@ -775,6 +1190,7 @@ int rxc_start_sack_timer(unsigned int oldQueueLen)
 {
     rxc_buffer *rxc;
     int bytesQueued = 0;
+    unsigned int oldWindow;
 
     rxc = (rxc_buffer *) mdi_readRX_control();
     if (!rxc) {
@@ -784,10 +1200,12 @@ int rxc_start_sack_timer(unsigned int oldQueueLen)
 
     bytesQueued = se_getQueuedBytes();
     if (bytesQueued < 0) bytesQueued = 0;
+    oldWindow = rxc_window_size(rxc);
+    if (oldQueueLen > (unsigned int)bytesQueued) rxc_tune_window(rxc, oldQueueLen - bytesQueued);
     /* no new data received, but we want updated SACK to be sent */
     rxc_all_chunks_processed(FALSE);
-    if ((rxc->my_rwnd - oldQueueLen < 2 * MAX_SCTP_PDU) &&
-        (rxc->my_rwnd - bytesQueued >= 2 * MAX_SCTP_PDU)) {
+    if (((int)oldWindow - (int)oldQueueLen < 2 * (int)DEFAULT_SCTP_PDU) &&
+        ((int)rxc_window_size(rxc) - bytesQueued >= 2 * (int)DEFAULT_SCTP_PDU)) {
         /* send SACK at once */
         rxc_create_sack(&rxc->last_address, TRUE);
         bu_sendAllChunks(&rxc->last_address);
@@ -870,6 +1288,49 @@ int rxc_set_local_receiver_window(unsigned int new_window)
 }
 
 
+/**
+  @return the receiver window, that autotuning currently allows (my_rwnd without autotuning)
+ */
+unsigned int rxc_get_tuned_receiver_window(void)
+{
+    rxc_buffer *rxc;
+    rxc = (rxc_buffer *) mdi_readRX_control();
+    if (!rxc) {
+        error_log(ERROR_MINOR, "rxc_buffer instance not set - returning 0");
+        return (0);
+    }
+    return rxc_window_size(rxc);
+}
+
+/**
+ Switch receiver window autotuning on or off. Autotuning continues with the window
+ it had reached before.
+ @param  enabled TRUE to let the receiver window follow the ULP's reading rate
+ @return 0 on success, else -1 on failure
+ */
+int rxc_set_rwndAutotuning(boolean enabled)
+{
+    rxc_buffer *rxc;
+    rxc = (rxc_buffer *) mdi_readRX_control();
+    if (!rxc) {
+        error_log(ERROR_MAJOR, "rxc_buffer instance not set !");
+        return (-1);
+    }
+    rxc->rwnd_autotuning = enabled;
+    return 0;
+}
+
+boolean rxc_get_rwndAutotuning(void)
+{
+    rxc_buffer *rxc;
+    rxc = (rxc_buffer *) mdi_readRX_control();
+    if (!rxc) {
+        error_log(ERROR_MINOR, "rxc_buffer instance not set !");
+        return FALSE;
+    }
+    return rxc->rwnd_autotuning;
+}
+
 /**
   Get the number of the current cumulative TSN, that we may ack
   @return my current ctsna (32 bit unsigned value)
@@ -937,19 +1398,35 @@ void rxc_restart_receivecontrol(unsigned int my_rwnd, unsigned int new_remote_TS
     rxc_stop_sack_timer();
     g_list_foreach(rxc->frag_list, &free_list_element, NULL);
     g_list_free(rxc->frag_list);
+    g_list_foreach(rxc->nr_frag_list, &free_list_element, NULL);
+    g_list_free(rxc->nr_frag_list);
     rxc->ctsna = new_remote_TSN - 1;
     rxc->lowest = new_remote_TSN - 1;
     rxc->highest = new_remote_TSN - 1;
     /* initialize and set up lists */
 
     rxc->frag_list = NULL;
+    rxc->nr_frag_list = NULL;
     rxc->dup_list = NULL;
     rxc->contains_valid_sack = FALSE;
     rxc->timer_running = FALSE;
     rxc->datagrams_received = -1;
     rxc->sack_flag = 2;
+    rxc->sack_immediately = FALSE;
+    rxc->packets_unacked = 0;
+    rxc->bytes_unacked = 0;
+    rxc->ack_packets = 2;
+    rxc->packets_per_rtt = 0;
+    rxc->rate_packets = 0;
+    adl_gettime(&(rxc->rate_start));
     rxc->last_address = 0;
     rxc->my_rwnd = my_rwnd;
+    rxc->tuned_rwnd = mdi_getInitialMyRwnd();
+    rxc->consumed_bytes = 0;
+    adl_gettime(&(rxc->consume_start));
+    rxc->ecne_pending = FALSE;
+    rxc->ecne_tsn = new_remote_TSN - 1;
+    rxc->sack_blocks_changed = TRUE;
     rxc->my_association = mdi_readAssociationID();
     return;
 }
@@ -980,6 +1457,7 @@ int rxc_process_forward_tsn(void* chunk)
         event_logii(VERBOSE, "rxc_process_forward_tsn --> discard fw_tsn !! (fw_tsn %u <= ctsna %u)",fw_tsn, rxc->ctsna);
         return 0;
     }
+    rxc->sack_blocks_changed = TRUE;
 
     current = g_list_first(rxc->frag_list);
 
@@ -1031,3 +1509,48 @@ int rxc_process_forward_tsn(void* chunk)
     return 0;
 }
 
+
+/**
+ * called by bundling, after the DATA chunks of a packet marked CE (congestion
+ * experienced) have been processed. From now on, every SACK carries an ECNE chunk
+ * for the highest TSN received so far, until the peer answers with a CWR chunk.
+ */
+void rxc_congestion_experienced(void)
+{
+    rxc_buffer *rxc;
+
+    rxc = (rxc_buffer *) mdi_readRX_control();
+    if (!rxc) {
+        error_log(ERROR_MAJOR, "rxc_buffer instance not set !");
+        return;
+    }
+    if (rxc->ecne_pending == FALSE || after(rxc->highest, rxc->ecne_tsn)) {
+        rxc->ecne_tsn = rxc->highest;
+    }
+    rxc->ecne_pending = TRUE;
+    event_logi(INTERNAL_EVENT_0, "rxc_congestion_experienced: ECNE for TSN %u", rxc->ecne_tsn);
+}
+
+
+/**
+ * processes a CWR chunk : the peer has reduced its congestion window for the
+ * TSN in the chunk, so no more ECNE chunks are sent for that TSN and earlier ones
+ * @param chunk  pointer to the CWR chunk
+ */
+int rxc_process_cwr(void* chunk)
+{
+    rxc_buffer *rxc;
+    unsigned int cwr_tsn;
+
+    cwr_tsn = ntohl(((SCTP_ecn_chunk *) chunk)->tsn);
+    rxc = (rxc_buffer *) mdi_readRX_control();
+    if (!rxc) {
+        error_log(ERROR_MAJOR, "rxc_buffer instance not set !");
+        return (-1);
+    }
+    event_logii(INTERNAL_EVENT_0, "rxc_process_cwr: CWR for TSN %u, ECNE TSN is %u", cwr_tsn, rxc->ecne_tsn);
+    if (rxc->ecne_pending == TRUE && !before(cwr_tsn, rxc->ecne_tsn)) {
+        rxc->ecne_pending = FALSE;
+    }
+    return 0;
+}
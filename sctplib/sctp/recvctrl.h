@@ -120,9 +120,35 @@ int rxc_set_sack_delay(unsigned int new_delay);
  */
 int rxc_set_local_receiver_window(unsigned int new_window);
 
+/**
+ * returns the receiver window, that autotuning currently allows (my_rwnd without autotuning)
+ */
+unsigned int rxc_get_tuned_receiver_window(void);
+
+/**
+ * switches receiver window autotuning on or off
+ */
+int rxc_set_rwndAutotuning(boolean enabled);
+boolean rxc_get_rwndAutotuning(void);
+
 void rxc_restart_receivecontrol(unsigned int my_rwnd, unsigned int new_remote_TSN);
 
 int rxc_process_forward_tsn(void* chunk);
 
+/**
+ * the ULP has read the data of the chunk with this TSN, so it is non-renegable
+ */
+void rxc_data_delivered(unsigned int tsn);
+
+/**
+ * the DATA chunks just processed arrived in a packet marked CE (ECN congestion experienced)
+ */
+void rxc_congestion_experienced(void);
+
+/**
+ * processes a CWR chunk, that ends the sending of ECNE chunks
+ */
+int rxc_process_cwr(void* chunk);
+
 
 #endif
@@ -49,6 +49,7 @@
 #include "distribution.h"
 #include "SCTP-control.h"
 #include "bundling.h"
+#include "trace.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -104,6 +105,15 @@ typedef struct rtx_buffer_struct
     unsigned int lastReceivedCTSNA;
 
     GArray *prChunks;
+    /** CMT: bytes newly acked by the current SACK, per destination */
+    unsigned int cmt_acked_bytes[MAX_NUM_ADDRESSES];
+    /** CMT: lowest outstanding TSN per destination before the current SACK (pseudo-cumack) */
+    unsigned int cmt_pseudo_cumack[MAX_NUM_ADDRESSES];
+    gboolean cmt_pseudo_cumack_set[MAX_NUM_ADDRESSES];
+    /** CMT: TRUE if the current SACK acked the pseudo-cumack of a destination */
+    gboolean cmt_pseudo_cumack_advanced[MAX_NUM_ADDRESSES];
+    /** CMT: highest TSN sent to a destination and acked by a gap block of the current SACK */
+    unsigned int cmt_highest_in_sack[MAX_NUM_ADDRESSES];
 /*@} */
 } rtx_buffer;
 
@@ -116,6 +126,8 @@ typedef struct rtx_buffer_struct
 void rtx_reset_bytecounters(rtx_buffer * rtx)
 {
     rtx->newly_acked_bytes = 0L;
+    memset(rtx->cmt_acked_bytes, 0, sizeof(rtx->cmt_acked_bytes));
+    memset(rtx->cmt_pseudo_cumack_advanced, 0, sizeof(rtx->cmt_pseudo_cumack_advanced));
     return;
 }
 
@@ -212,6 +224,105 @@ void rtx_rtt_update(unsigned int adr_idx, rtx_buffer * rtx)
 }
 
 
+/**
+ * records the send-to-ack latency of a chunk that has just been acked for the first time,
+ * measured from its last transmission to the arrival of the SACK
+ * @param    rtx    pointer to the currently active rtx structure
+ * @param    dat    the chunk that was acked
+ */
+static void rtx_record_ack_latency(rtx_buffer * rtx, chunk_data * dat)
+{
+    struct timeval delta;
+
+    if (timercmp(&(rtx->sack_arrival_time), &(dat->transmission_time), <)) return;
+    timersub(&(rtx->sack_arrival_time), &(dat->transmission_time), &delta);
+    if (delta.tv_sec >= 4294) {
+        mdi_recordAckLatency(0xFFFFFFFF);
+    } else {
+        mdi_recordAckLatency((unsigned int)(delta.tv_sec * 1000000 + delta.tv_usec));
+    }
+}
+
+
+/**
+ * CMT: accounts a newly acked chunk to the destination it was sent to
+ */
+static void rtx_cmt_chunk_acked(rtx_buffer * rtx, chunk_data * dat)
+{
+    unsigned int path = dat->last_destination;
+
+    if (path >= MAX_NUM_ADDRESSES) return;
+    rtx->cmt_acked_bytes[path] += dat->chunk_len;
+    if (rtx->cmt_pseudo_cumack_set[path] == TRUE && rtx->cmt_pseudo_cumack[path] == dat->chunk_tsn) {
+        rtx->cmt_pseudo_cumack_advanced[path] = TRUE;
+    }
+}
+
+/**
+ * CMT: before a SACK is processed, finds the lowest outstanding TSN of each destination
+ * (pseudo-cumack, for the cwnd update rules) and the highest TSN of each destination
+ * that the gap blocks of the SACK ack (for split fast retransmit).
+ */
+static void rtx_cmt_prepare_sack(rtx_buffer * rtx, guchar * blocks,
+                                 unsigned int ctsna, unsigned int num_of_gaps)
+{
+    GList* tmp;
+    chunk_data *dat;
+    fragment *frag = NULL;
+    unsigned int path, gap = 0, low = 0, hi = 0;
+
+    for (path = 0; path < MAX_NUM_ADDRESSES; path++) {
+        rtx->cmt_pseudo_cumack_set[path] = FALSE;
+        rtx->cmt_highest_in_sack[path] = ctsna;
+    }
+    if (num_of_gaps > 0) {
+        frag = (fragment *) & (blocks[0]);
+        low = ctsna + ntohs(frag->start);
+        hi = ctsna + ntohs(frag->stop);
+    }
+    for (tmp = g_list_first(rtx->chunk_list); tmp != NULL; tmp = g_list_next(tmp)) {
+        dat = (chunk_data*)tmp->data;
+        path = dat->last_destination;
+        if (path >= MAX_NUM_ADDRESSES) continue;
+        if (dat->hasBeenAcked == FALSE && dat->hasBeenDropped == FALSE &&
+            rtx->cmt_pseudo_cumack_set[path] == FALSE) {
+            rtx->cmt_pseudo_cumack[path] = dat->chunk_tsn;
+            rtx->cmt_pseudo_cumack_set[path] = TRUE;
+        }
+        if (!after(dat->chunk_tsn, ctsna)) continue;
+        while (gap < num_of_gaps && after(dat->chunk_tsn, hi)) {
+            gap++;
+            if (gap < num_of_gaps) {
+                frag = (fragment *) & (blocks[gap * sizeof(fragment)]);
+                low = ctsna + ntohs(frag->start);
+                hi = ctsna + ntohs(frag->stop);
+            }
+        }
+        if (gap < num_of_gaps && !before(dat->chunk_tsn, low) &&
+            after(dat->chunk_tsn, rtx->cmt_highest_in_sack[path])) {
+            rtx->cmt_highest_in_sack[path] = dat->chunk_tsn;
+        }
+    }
+}
+
+/**
+ * CMT: returns the bytes, that the SACK being processed newly acked on a destination
+ * @param  path        index of the destination
+ * @param  advanced    set to TRUE, if the lowest outstanding TSN of the destination was acked
+ */
+unsigned int rtx_readNewlyAckedBytes(unsigned int path, gboolean * advanced)
+{
+    rtx_buffer *rtx;
+
+    rtx = (rtx_buffer *) mdi_readReliableTransfer();
+    if (!rtx || path >= MAX_NUM_ADDRESSES) {
+        *advanced = FALSE;
+        return 0;
+    }
+    *advanced = rtx->cmt_pseudo_cumack_advanced[path];
+    return rtx->cmt_acked_bytes[path];
+}
+
 /**
  * this function enters fast recovery and sets correct exit point
  * iff fast recovery is not already active
@@ -320,6 +431,8 @@ int rtx_dequeue_up_to(unsigned int ctsna, unsigned int addr_index)
             if (dat->hasBeenAcked == FALSE && dat->hasBeenDropped == FALSE) {
                 rtx->newly_acked_bytes += dat->chunk_len;
                 dat->hasBeenAcked = TRUE;
+                rtx_record_ack_latency(rtx, dat);
+                rtx_cmt_chunk_acked(rtx, dat);
                 if (dat->num_of_transmissions == 1 && addr_index == dat->last_destination) {
                     rtx->save_num_of_txm = 1;
                     rtx->saved_send_time = dat->transmission_time;
@@ -333,6 +446,7 @@ int rtx_dequeue_up_to(unsigned int ctsna, unsigned int addr_index)
             event_logi(INTERNAL_EVENT_0, "Now delete chunk with tsn...%u", chunk_tsn);
             old_dat = dat;
             rtx->chunk_list = g_list_remove(rtx->chunk_list, (gpointer)dat);
+            mdi_releaseMemory(old_dat->chunk_len);
             free(old_dat);
         }
         /* it is a sorted list, so it is safe to get out in this case */
@@ -479,32 +593,97 @@ int rtx_get_obpa(unsigned int adIndex, unsigned int *totalInFlight)
     return numBytesPerAddress;
 }
 
+/**
+ * frees the chunks, that the NR gap ack blocks of an NR-SACK report : the peer has
+ * delivered them to its ULP and will not renege them, so they are neither retransmitted
+ * nor kept in the queue until the cumulative TSN ack passes them.
+ * @param  rtx         pointer to the currently active rtx structure
+ * @param  ctsna       cumulative TSN ack of the NR-SACK
+ * @param  nr_blocks   pointer to the first NR gap ack block
+ * @param  num_of_nr_gaps  number of NR gap ack blocks
+ * @param  adr_index   index of the address where we got the NR-SACK
+ * @return number of chunks that were freed
+ */
+static unsigned int rtx_free_nr_acked(rtx_buffer * rtx, unsigned int ctsna, guchar * nr_blocks,
+                                      unsigned int num_of_nr_gaps, unsigned int adr_index)
+{
+    GList *tmp, *next;
+    chunk_data *dat;
+    fragment *frag;
+    unsigned int gap = 0, low, hi, freed = 0;
+
+    frag = (fragment *) & (nr_blocks[0]);
+    low = ctsna + ntohs(frag->start);
+    hi = ctsna + ntohs(frag->stop);
+
+    tmp = g_list_first(rtx->chunk_list);
+    while (tmp != NULL && gap < num_of_nr_gaps) {
+        dat = (chunk_data*)tmp->data;
+        if (after(dat->chunk_tsn, hi)) {
+            /* compare the same chunk with the next block */
+            gap++;
+            if (gap < num_of_nr_gaps) {
+                frag = (fragment *) & (nr_blocks[gap * sizeof(fragment)]);
+                low = ctsna + ntohs(frag->start);
+                hi = ctsna + ntohs(frag->stop);
+            }
+            continue;
+        }
+        next = g_list_next(tmp);
+        if (!before(dat->chunk_tsn, low) && after(dat->chunk_tsn, ctsna)) {
+            if (dat->hasBeenAcked == FALSE && dat->hasBeenDropped == FALSE) {
+                rtx->newly_acked_bytes += dat->chunk_len;
+                dat->hasBeenAcked = TRUE;
+                rtx_record_ack_latency(rtx, dat);
+                rtx_cmt_chunk_acked(rtx, dat);
+                if (dat->num_of_transmissions == 1 && adr_index == dat->last_destination) {
+                    rtx->saved_send_time = dat->transmission_time;
+                    rtx->save_num_of_txm = 1;
+                }
+            }
+            event_logi(VVERBOSE, "rtx_free_nr_acked: chunk %u is non-renegable, freeing it", dat->chunk_tsn);
+            /* it may still be waiting for retransmission in the flowcontrol list */
+            fc_dequeueUnackedChunk(dat->chunk_tsn);
+            rtx->chunk_list = g_list_remove(rtx->chunk_list, (gpointer)dat);
+            mdi_releaseMemory(dat->chunk_len);
+            free(dat);
+            freed++;
+        }
+        tmp = next;
+    }
+    return freed;
+}
+
 /**
  * this is called by bundling, when a SACK needs to be processed. This is a LONG function !
  * FIXME : check correct update of rtx->lowest_tsn !
  * FIXME : handling of out-of-order SACKs
  * CHECK : did SACK ack lowest outstanding tsn, restart t3 timer (section 7.2.4.4) )
  * @param  adr_index   index of the address where we got that sack
- * @param  sack_chunk  pointer to the sack chunk
+ * @param  sack_chunk  pointer to the sack chunk, or to an NR-SACK chunk
  * @return -1 on error, 0 if okay.
  */
 int rtx_process_sack(unsigned int adr_index, void *sack_chunk, unsigned int totalLen)
 {
     rtx_buffer *rtx=NULL;
     SCTP_sack_chunk *sack=NULL;
+    SCTP_nr_sack_chunk *nr_sack=NULL;
+    guchar *blocks=NULL;
     fragment *frag=NULL;
     chunk_data *dat=NULL;
     GList* tmp_list = NULL;
     int result;
     unsigned int advertised_rwnd, old_own_ctsna;
     unsigned int low, hi, ctsna, pos;
-    unsigned int chunk_len, var_len, gap_len, dup_len;
-    unsigned int num_of_dups, num_of_gaps;
+    unsigned int chunk_len, var_len, gap_len, nr_gap_len, dup_len;
+    unsigned int num_of_dups, num_of_gaps, num_of_nr_gaps;
     unsigned int max_rtx_arraysize;
     unsigned int retransmitted_bytes = 0L;
     int chunks_to_rtx = 0;
     guint i=0;
     boolean rtx_necessary = FALSE, all_acked = FALSE, new_acked = FALSE;
+    gboolean cmt;
+    SCTP_AssociationStatistics* stats;
 
     event_logi(INTERNAL_EVENT_0, "rtx_process_sack(address==%u)", adr_index);
 
@@ -542,17 +721,36 @@ int rtx_process_sack(unsigned int adr_index, void *sack_chunk, unsigned int tota
 
     /* maybe add some more sanity checks  !!! */
     advertised_rwnd = ntohl(sack->a_rwnd);
-    num_of_gaps = ntohs(sack->num_of_fragments);
-    num_of_dups = ntohs(sack->num_of_duplicates);
-    /* var_len contains gap acks AND duplicates ! Thanks to Janar for pointing this out */
-    var_len = chunk_len - sizeof(SCTP_chunk_header) - 2 * sizeof(unsigned int) - 2 * sizeof(unsigned short);
+    trc_event(SCTP_TRACE_MODULE_RELTRANSFER, TRC_SACK_RECEIVED, rtx->my_association, ctsna, advertised_rwnd);
+    if (sack->chunk_header.chunk_id == CHUNK_NR_SACK) {
+        nr_sack = (SCTP_nr_sack_chunk *) sack_chunk;
+        num_of_gaps = ntohs(nr_sack->num_of_fragments);
+        num_of_nr_gaps = ntohs(nr_sack->num_of_nr_fragments);
+        num_of_dups = ntohs(nr_sack->num_of_duplicates);
+        blocks = nr_sack->fragments_and_dups;
+        var_len = chunk_len - sizeof(SCTP_chunk_header) - 2 * sizeof(unsigned int) - 4 * sizeof(unsigned short);
+    } else {
+        num_of_gaps = ntohs(sack->num_of_fragments);
+        num_of_nr_gaps = 0;
+        num_of_dups = ntohs(sack->num_of_duplicates);
+        blocks = sack->fragments_and_dups;
+        /* var_len contains gap acks AND duplicates ! Thanks to Janar for pointing this out */
+        var_len = chunk_len - sizeof(SCTP_chunk_header) - 2 * sizeof(unsigned int) - 2 * sizeof(unsigned short);
+    }
     gap_len = num_of_gaps * sizeof(unsigned int);
+    nr_gap_len = num_of_nr_gaps * sizeof(unsigned int);
     dup_len = num_of_dups * sizeof(unsigned int);
-    if (var_len != gap_len+dup_len) {
+    if (var_len != gap_len+nr_gap_len+dup_len) {
         event_logiiii(EXTERNAL_EVENT, "Drop SACK chunk (incorrect length fields) chunk_len=%u, var_len=%u, gap_len=%u, dup_len=%u",
                      chunk_len, var_len, gap_len, dup_len);
         return -1;
     }
+    stats = mdi_readStatistics();
+    stats->sacksReceived++;
+    stats->gapBlocksReceived += num_of_gaps;
+
+    cmt = mdi_usesCMT();
+    if (cmt == TRUE) rtx_cmt_prepare_sack(rtx, blocks, ctsna, num_of_gaps);
 
     event_logiiiii(VVERBOSE, "chunk_len=%u, a_rwnd=%u, var_len=%u, gap_len=%u, du_len=%u",
                     chunk_len, advertised_rwnd, var_len, gap_len, dup_len);
@@ -570,10 +768,15 @@ int rtx_process_sack(unsigned int adr_index, void *sack_chunk, unsigned int tota
         event_logi(VVERBOSE, "Updated rtx->lowest_tsn==ctsna==%u", ctsna);
     }
 
+    if (num_of_nr_gaps != 0) {
+        result = rtx_free_nr_acked(rtx, ctsna, &blocks[gap_len], num_of_nr_gaps, adr_index);
+        event_logii(VERBOSE, "Processed %u NR fragment reports, freed %d chunks", num_of_nr_gaps, result);
+    }
+
     chunk_list_debug(VVERBOSE, rtx->chunk_list);
 
-    if (ntohs(sack->num_of_fragments) != 0) {
-        event_logi(VERBOSE, "Processing %u fragment reports", ntohs(sack->num_of_fragments));
+    if (num_of_gaps != 0) {
+        event_logi(VERBOSE, "Processing %u fragment reports", num_of_gaps);
         max_rtx_arraysize = g_list_length(rtx->chunk_list);
         if (max_rtx_arraysize == 0) {
             /*rxc_send_sack_everytime(); */
@@ -585,7 +788,7 @@ int rtx_process_sack(unsigned int adr_index, void *sack_chunk, unsigned int tota
             dat = (chunk_data*)g_list_nth_data(rtx->chunk_list, i);
             if (rtx->chunk_list != NULL && dat != NULL) {
                 do {
-                frag = (fragment *) & (sack->fragments_and_dups[pos]);
+                frag = (fragment *) & (blocks[pos]);
                     low = ctsna + ntohs(frag->start);
                     hi = ctsna + ntohs(frag->stop);
                     event_logiii(VVERBOSE, "chunk_tsn==%u, lo==%u, hi==%u", dat->chunk_tsn, low, hi);
@@ -598,7 +801,11 @@ int rtx_process_sack(unsigned int adr_index, void *sack_chunk, unsigned int tota
                     }
                     if (before(dat->chunk_tsn, low)) {
                         /* this chunk is in a gap... */
-                        dat->gap_reports++;
+                        /* CMT split fast retransmit : only count the report, if a later TSN */
+                        /* sent to the same destination was acked, else it is just reordering */
+                        if (cmt == FALSE ||
+                            after(rtx->cmt_highest_in_sack[dat->last_destination], dat->chunk_tsn))
+                            dat->gap_reports++;
                         event_logiii(VVERBOSE,
                                      "Chunk in a gap: before(%u,%u)==true -- Marking it up (%u Gap Reports)!",
                                      dat->chunk_tsn, low, dat->gap_reports);
@@ -610,6 +817,7 @@ int rtx_process_sack(unsigned int adr_index, void *sack_chunk, unsigned int tota
                                 if (timerisset(&dat->expiry_time) && timercmp(&(rtx->sack_arrival_time), &(dat->expiry_time), >)) {
                                     event_logi(VVERBOSE, "Got four gap_reports, dropping chunk %u !!!", dat->chunk_tsn);
                                     dat->hasBeenDropped = TRUE;
+                                    stats->abandonedChunks++;
                                     /* this is a trick... */
                                     dat->hasBeenFastRetransmitted = TRUE;
                                 } else if (dat->hasBeenFastRetransmitted == FALSE) {
@@ -639,6 +847,8 @@ int rtx_process_sack(unsigned int adr_index, void *sack_chunk, unsigned int tota
                         if (dat->hasBeenAcked == FALSE && dat->hasBeenDropped == FALSE) {
                             rtx->newly_acked_bytes += dat->chunk_len;
                             dat->hasBeenAcked = TRUE;
+                            rtx_record_ack_latency(rtx, dat);
+                            rtx_cmt_chunk_acked(rtx, dat);
                             rtx->all_chunks_are_unacked = FALSE;
                             dat->gap_reports = 0;
                             if (dat->num_of_transmissions == 1 && adr_index == dat->last_destination) {
@@ -678,7 +888,7 @@ int rtx_process_sack(unsigned int adr_index, void *sack_chunk, unsigned int tota
             }
         }
 
-    } else {                    /* no gaps reported in this SACK */
+    } else if (num_of_nr_gaps == 0) {  /* no gaps reported in this SACK */
         /* do nothing */
         if (rtx->all_chunks_are_unacked == FALSE) {
             /* okay, we have chunks in the queue that were acked by a gap report before       */
@@ -757,6 +967,9 @@ int rtx_process_sack(unsigned int adr_index, void *sack_chunk, unsigned int tota
                      rtx->newly_acked_bytes, rtx->num_of_addresses);
         rtx_reset_bytecounters(rtx);
     } else {
+        trc_event(SCTP_TRACE_MODULE_RELTRANSFER, TRC_FAST_RETRANSMIT, rtx->my_association,
+                  (chunks_to_rtx > 0) ? rtx_chunks[0]->chunk_tsn : 0, chunks_to_rtx);
+        stats->fastRetransmits++;
         /* retval = */
         fc_fast_retransmission(adr_index, advertised_rwnd,ctsna,
                                             retransmitted_bytes,
@@ -830,6 +1043,7 @@ int rtx_t3_timeout(void *assoc_id, unsigned int address, unsigned int mtu, chunk
                     if (timercmp(&now, &((chunk_data *)(tmp->data))->expiry_time, > )) {
                         /* chunk has expired, maybe send FORWARD_TSN */
                         ((chunk_data *)(tmp->data))->hasBeenDropped = TRUE;
+                        mdi_readStatistics()->abandonedChunks++;
                     } else { /* chunk has not yet expired */
                         chunks[chunks_to_rtx] = (chunk_data*)tmp->data;
                         size += chunks[chunks_to_rtx]->chunk_len;
@@ -1047,6 +1261,8 @@ int rtx_dequeueOldestUnackedChunk(unsigned char *buf, unsigned int *len, unsigne
     rtx_buffer *rtx;
     chunk_data *dat = NULL;
     SCTP_data_chunk* dchunk;
+    SCTP_idata_chunk* ichunk;
+    unsigned int hlen;
 
     rtx = (rtx_buffer *) mdi_readReliableTransfer();
     if (!rtx) {
@@ -1058,16 +1274,23 @@ int rtx_dequeueOldestUnackedChunk(unsigned char *buf, unsigned int *len, unsigne
     if (listlen <= 0) return SCTP_UNSPECIFIED_ERROR;
     dat = (chunk_data*)g_list_nth_data(rtx->chunk_list, 0);
     if (dat->num_of_transmissions == 0) return SCTP_UNSPECIFIED_ERROR;
-    if ((*len) <  (dat->chunk_len - FIXED_DATA_CHUNK_SIZE)) return SCTP_BUFFER_TOO_SMALL;
-
     dchunk = (SCTP_data_chunk*) dat->data;
-    *len = dat->chunk_len - FIXED_DATA_CHUNK_SIZE;
-    memcpy(buf, dchunk->data, dat->chunk_len - FIXED_DATA_CHUNK_SIZE);
+    hlen = DATA_CHUNK_HEADER_SIZE(dchunk->chunk_id);
+    if ((*len) <  (dat->chunk_len - hlen)) return SCTP_BUFFER_TOO_SMALL;
+
+    *len = dat->chunk_len - hlen;
+    memcpy(buf, &dat->data[hlen], dat->chunk_len - hlen);
     *tsn = dat->chunk_tsn;
     *sID = ntohs(dchunk->stream_id);
-    *sSN = ntohs(dchunk->stream_sn);
-    *pID = dchunk->protocolId;
-    *flags = dchunk->chunk_flags;
+    if (dchunk->chunk_id == CHUNK_IDATA) {
+        ichunk = (SCTP_idata_chunk*) dat->data;
+        *sSN = (unsigned short)ntohl(ichunk->message_id);
+        *pID = (ichunk->chunk_flags & SCTP_DATA_BEGIN_SEGMENT) ? ichunk->ppid_fsn : 0;
+    } else {
+        *sSN = ntohs(dchunk->stream_sn);
+        *pID = dchunk->protocolId;
+    }
+    *flags = dchunk->chunk_flags & ~SCTP_DATA_SACK_IMMEDIATELY;
     *ctx = dat->context;
     event_logiii(VERBOSE, "rtx_dequeueOldestUnackedChunk() returns chunk tsn %u, num-trans: %u, chunks left: %u",
             dat->chunk_tsn, dat->num_of_transmissions, listlen-1);
@@ -1078,6 +1301,7 @@ int rtx_dequeueOldestUnackedChunk(unsigned char *buf, unsigned int *len, unsigne
     /* be careful ! data may only be freed once: this module ONLY takes care of unacked chunks */
     chunk_list_debug(VVERBOSE, rtx->chunk_list);
 
+    mdi_releaseMemory(dat->chunk_len);
     free(dat);
     return (listlen-1);
 }
@@ -1189,6 +1413,8 @@ unsigned int rtx_rcv_shutdown_ctsna(unsigned int ctsna)
         return (0);
     }
     rxc_send_sack_everytime();
+    /* the ctsna of the SHUTDOWN acknowledges chunks just like a SACK does */
+    adl_gettime(&(rtx->sack_arrival_time));
 
     if (after(ctsna, rtx->lowest_tsn) || (ctsna == rtx->lowest_tsn)) {
         event_logiii(VVERBOSE, "after(%u, %u) == true, call rtx_dequeue_up_to(%u)",
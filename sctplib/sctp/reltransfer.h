@@ -123,6 +123,12 @@ int rtx_enter_fast_recovery(void);
 
 gboolean rtx_is_in_fast_recovery(void);
 
+/**
+ * for concurrent multipath transfer : returns the bytes newly acked on a path
+ * by the SACK being processed, and whether its lowest outstanding TSN was acked
+ */
+unsigned int rtx_readNewlyAckedBytes(unsigned int path, gboolean * advanced);
+
 /**
  * returns the current number of outstanding bytes queued in the retransmission
  * queue
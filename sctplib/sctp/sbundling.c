@@ -48,7 +48,10 @@
 #include "distribution.h"
 #include "recvctrl.h"
 #include "reltransfer.h"
+#include "flowcontrol.h"
+#include "pathmanagement.h"
 #include "errorhandler.h"
+#include "trace.h"
 
 #define TOTAL_SIZE(buf)		((buf)->ctrl_position+(buf)->sack_position+(buf)->data_position- 2*sizeof(SCTP_common_header))
 #define SACK_SIZE(buf)		((buf)->ctrl_position+(buf)->data_position- sizeof(SCTP_common_header))
@@ -59,11 +62,13 @@ typedef struct bundling_instance_struct
 {
     /*@{ */
     /** buffer for control chunks */
-    guchar ctrl_buf[MAX_MTU_SIZE];
+    guchar *ctrl_buf;
     /** buffer for sack chunks */
-    guchar sack_buf[MAX_MTU_SIZE];
+    guchar *sack_buf;
     /** buffer for data chunks */
-    guchar data_buf[MAX_MTU_SIZE];
+    guchar *data_buf;
+    /** size of each of the three buffers, grows with the path MTU up to MAX_MTU_SIZE */
+    guint buf_size;
     /* Leave some space for the SCTP common header */
     /**  current position in the buffer for control chunks */
     guint ctrl_position;
@@ -118,6 +123,18 @@ gpointer bu_new(void)
         error_log(ERROR_MAJOR, "Malloc failed");
         return 0;
     }
+    ptr->buf_size = DEFAULT_MTU_SIZE;
+    ptr->ctrl_buf = (guchar*)malloc(ptr->buf_size);
+    ptr->sack_buf = (guchar*)malloc(ptr->buf_size);
+    ptr->data_buf = (guchar*)malloc(ptr->buf_size);
+    if (!ptr->ctrl_buf || !ptr->sack_buf || !ptr->data_buf) {
+        error_log(ERROR_MAJOR, "Malloc failed");
+        free(ptr->ctrl_buf);
+        free(ptr->sack_buf);
+        free(ptr->data_buf);
+        free(ptr);
+        return 0;
+    }
     ptr->ctrl_position = sizeof(SCTP_common_header); /* start adding data after that header ! */
     ptr->data_position = sizeof(SCTP_common_header); /* start adding data after that header ! */
     ptr->sack_position = sizeof(SCTP_common_header); /* start adding data after that header ! */
@@ -138,10 +155,68 @@ gpointer bu_new(void)
  */
 void bu_delete(gpointer buPtr)
 {
+    bundling_instance *bu_ptr = (bundling_instance *) buPtr;
+
     event_log(INTERNAL_EVENT_0, "deleting bundling");
+    if (bu_ptr != NULL) {
+        free(bu_ptr->ctrl_buf);
+        free(bu_ptr->sack_buf);
+        free(bu_ptr->data_buf);
+    }
     free(buPtr);
 }
 
+/**
+ * Returns the largest packet (without IP and common header) that may be
+ * sent to the destination of the chunks in the buffer.
+ */
+static guint bu_pduLimit(bundling_instance * bu_ptr, unsigned int * dest_index)
+{
+    unsigned int path;
+    guint pdu;
+
+    if (bu_ptr == global_buffer || mdi_readFlowControl() == NULL) return DEFAULT_SCTP_PDU;
+
+    if (dest_index != NULL)                 path = *dest_index;
+    else if (bu_ptr->got_send_address)      path = bu_ptr->requested_destination;
+    else                                    path = pm_readPrimaryPath();
+
+    pdu = fc_readMTU((short)path);
+    return (pdu != 0) ? pdu : DEFAULT_SCTP_PDU;
+}
+
+/**
+ * Makes sure that the buffers can take another chunk of chunk_len bytes (plus padding)
+ * in addition to everything already bundled. All three buffers grow together,
+ * as bu_sendAllChunks() assembles the packet in one of them.
+ * @return TRUE if there is room, FALSE if memory could not be allocated
+ */
+static gboolean bu_reserve(bundling_instance * bu_ptr, guint chunk_len)
+{
+    guint needed, new_size;
+    guchar *ctrl, *sack, *data;
+
+    needed = sizeof(SCTP_common_header) + TOTAL_SIZE(bu_ptr) + chunk_len + 3;
+    if (needed <= bu_ptr->buf_size) return TRUE;
+
+    new_size = max(needed, 2 * bu_ptr->buf_size);
+    new_size = max(needed, min(new_size, MAX_MTU_SIZE));
+
+    ctrl = (guchar*)realloc(bu_ptr->ctrl_buf, new_size);
+    if (ctrl != NULL) bu_ptr->ctrl_buf = ctrl;
+    sack = (guchar*)realloc(bu_ptr->sack_buf, new_size);
+    if (sack != NULL) bu_ptr->sack_buf = sack;
+    data = (guchar*)realloc(bu_ptr->data_buf, new_size);
+    if (data != NULL) bu_ptr->data_buf = data;
+    if (ctrl == NULL || sack == NULL || data == NULL) {
+        error_log(ERROR_MAJOR, "bu_reserve: realloc failed");
+        return FALSE;
+    }
+    event_logii(VERBOSE, "bu_reserve: bundling buffers grown from %u to %u bytes", bu_ptr->buf_size, new_size);
+    bu_ptr->buf_size = new_size;
+    return TRUE;
+}
+
 
 
 /**
@@ -204,10 +279,10 @@ gint bu_put_SACK_Chunk(SCTP_sack_chunk * chunk, unsigned int * dest_index)
         bu_ptr = global_buffer;
     }
 
-    if (SACK_SIZE(bu_ptr) + CHUNKP_LENGTH((SCTP_chunk_header *) chunk) >= MAX_SCTP_PDU) {
+    if (SACK_SIZE(bu_ptr) + CHUNKP_LENGTH((SCTP_chunk_header *) chunk) >= bu_pduLimit(bu_ptr, dest_index)) {
         lock = bu_ptr->locked;
          event_logi(VERBOSE,
-                  "Chunk Length exceeded MAX_SCTP_PDU : sending chunk to address %u !",
+                  "Chunk Length exceeded path MTU : sending chunk to address %u !",
                     (dest_index==NULL)?0:*dest_index);
         if (lock) bu_ptr->locked = FALSE;
         bu_sendAllChunks(dest_index);
@@ -222,6 +297,7 @@ gint bu_put_SACK_Chunk(SCTP_sack_chunk * chunk, unsigned int * dest_index)
                   "bu_put_SACK_Chunk was called a second time, deleting first chunk");
         bu_ptr->sack_position = sizeof(SCTP_common_header);
     }
+    if (bu_reserve(bu_ptr, CHUNKP_LENGTH((SCTP_chunk_header *) chunk)) == FALSE) return -1;
 
     memcpy(&(bu_ptr->sack_buf[bu_ptr->sack_position]), chunk,
            CHUNKP_LENGTH((SCTP_chunk_header *) chunk));
@@ -257,10 +333,10 @@ gint bu_put_Ctrl_Chunk(SCTP_simple_chunk * chunk,unsigned int * dest_index)
         bu_ptr = global_buffer;
     }
 
-    if (TOTAL_SIZE(bu_ptr) + CHUNKP_LENGTH((SCTP_chunk_header *) chunk) >= MAX_SCTP_PDU) {
+    if (TOTAL_SIZE(bu_ptr) + CHUNKP_LENGTH((SCTP_chunk_header *) chunk) >= bu_pduLimit(bu_ptr, dest_index)) {
         lock = bu_ptr->locked;
         event_logi(VERBOSE,
-                  "Chunk Length exceeded MAX_SCTP_PDU : sending chunk to address %u !",
+                  "Chunk Length exceeded path MTU : sending chunk to address %u !",
                     (dest_index==NULL)?0:*dest_index);
         if (lock) bu_ptr->locked = FALSE;
         bu_sendAllChunks(dest_index);
@@ -270,6 +346,7 @@ gint bu_put_Ctrl_Chunk(SCTP_simple_chunk * chunk,unsigned int * dest_index)
         bu_ptr->requested_destination = *dest_index;
     }
 
+    if (bu_reserve(bu_ptr, CHUNKP_LENGTH((SCTP_chunk_header *) chunk)) == FALSE) return -1;
     memcpy(&(bu_ptr->ctrl_buf[bu_ptr->ctrl_position]), chunk,
            CHUNKP_LENGTH((SCTP_chunk_header *) chunk));
     bu_ptr->ctrl_position += CHUNKP_LENGTH((SCTP_chunk_header *) chunk);
@@ -322,10 +399,10 @@ gint bu_put_Data_Chunk(SCTP_simple_chunk * chunk,unsigned int * dest_index)
         bu_ptr = global_buffer;
     }
 
-    if (TOTAL_SIZE(bu_ptr) + CHUNKP_LENGTH((SCTP_chunk_header *) chunk) >= MAX_SCTP_PDU) {
+    if (TOTAL_SIZE(bu_ptr) + CHUNKP_LENGTH((SCTP_chunk_header *) chunk) >= bu_pduLimit(bu_ptr, dest_index)) {
         lock = bu_ptr->locked;
         event_logi(VERBOSE,
-                  "Chunk Length exceeded MAX_SCTP_PDU : sending chunk to address %u !",
+                  "Chunk Length exceeded path MTU : sending chunk to address %u !",
                     (dest_index==NULL)?0:*dest_index);
         if (lock) bu_ptr->locked = FALSE;
         bu_sendAllChunks(dest_index);
@@ -334,6 +411,7 @@ gint bu_put_Data_Chunk(SCTP_simple_chunk * chunk,unsigned int * dest_index)
         bu_ptr->got_send_address = TRUE;
         bu_ptr->requested_destination = *dest_index;
     }
+    if (bu_reserve(bu_ptr, CHUNKP_LENGTH((SCTP_chunk_header *) chunk)) == FALSE) return -1;
     memcpy(&(bu_ptr->data_buf[bu_ptr->data_position]), chunk,
            CHUNKP_LENGTH((SCTP_chunk_header *) chunk));
     bu_ptr->data_position += CHUNKP_LENGTH((SCTP_chunk_header *) chunk);
@@ -357,6 +435,82 @@ gint bu_put_Data_Chunk(SCTP_simple_chunk * chunk,unsigned int * dest_index)
     return 0;
 }
 
+/**
+ * Sends the data chunks in the bundling buffer (with control chunks and SACK, if any)
+ * to their destination, so that chunks for another destination may be put in next.
+ * Like in bu_put_Data_Chunk(), this is done even if the sender is locked.
+ *  @param   ad_idx     pointer to address index of the data in the buffer
+ *  @return  0 if there was nothing to send, else the result of bu_sendAllChunks()
+ */
+gint bu_flushDataChunks(guint * ad_idx)
+{
+    bundling_instance *bu_ptr;
+    gboolean lock;
+    gint result;
+
+    bu_ptr = (bundling_instance *) mdi_readBundling();
+    if (!bu_ptr) bu_ptr = global_buffer;
+    if (bu_ptr->data_in_buffer == FALSE) return 0;
+
+    lock = bu_ptr->locked;
+    if (lock) bu_ptr->locked = FALSE;
+    result = bu_sendAllChunks(ad_idx);
+    if (lock) bu_ptr->locked = TRUE;
+    return result;
+}
+
+/**
+ * Sends a path MTU probe (RFC 8899) : the heartbeat chunk, followed by a PAD chunk that
+ * fills the packet up to probe_size bytes including IP and common header. The probe is
+ * usually larger than the current path MTU, so it bypasses the bundling limits, and
+ * anything already in the buffer is sent on its own before.
+ *  @param   chunk       the heartbeat chunk
+ *  @param   probe_size  size of the probe packet, a multiple of 4
+ *  @param   ad_idx      pointer to the index of the path to be probed
+ *  @return  0 if the probe was sent, -1 if not (e.g. it exceeds the local interface MTU)
+ */
+gint bu_sendProbe(SCTP_simple_chunk * chunk, guint probe_size, guint * ad_idx)
+{
+    bundling_instance *bu_ptr;
+    SCTP_chunk_header *pad;
+    guint pdu, hb_len;
+    gboolean lock;
+    gint result;
+
+    bu_ptr = (bundling_instance *) mdi_readBundling();
+    if (!bu_ptr) bu_ptr = global_buffer;
+
+    hb_len = CHUNKP_LENGTH((SCTP_chunk_header *) chunk);
+    hb_len = (hb_len + 3) & ~3;
+    pdu = probe_size - IP_HEADERLENGTH - sizeof(SCTP_common_header);
+    if (probe_size > MAX_MTU_SIZE || pdu < hb_len + sizeof(SCTP_chunk_header)) return -1;
+
+    lock = bu_ptr->locked;
+    if (lock) bu_ptr->locked = FALSE;
+    if (bu_ptr->sack_in_buffer || bu_ptr->ctrl_chunk_in_buffer || bu_ptr->data_in_buffer)
+        bu_sendAllChunks(ad_idx);
+
+    if (bu_reserve(bu_ptr, pdu) == FALSE) {
+        if (lock) bu_ptr->locked = TRUE;
+        return -1;
+    }
+    memset(&(bu_ptr->ctrl_buf[bu_ptr->ctrl_position]), 0, pdu);
+    memcpy(&(bu_ptr->ctrl_buf[bu_ptr->ctrl_position]), chunk, CHUNKP_LENGTH((SCTP_chunk_header *) chunk));
+    bu_ptr->ctrl_position += hb_len;
+
+    pad = (SCTP_chunk_header *) &(bu_ptr->ctrl_buf[bu_ptr->ctrl_position]);
+    pad->chunk_id = CHUNK_PAD;
+    pad->chunk_flags = 0;
+    pad->chunk_length = htons((guint16)(pdu - hb_len));
+    bu_ptr->ctrl_position += pdu - hb_len;
+    bu_ptr->ctrl_chunk_in_buffer = TRUE;
+
+    event_logii(VERBOSE, "bu_sendProbe: probe of %u bytes to path %u", probe_size, (ad_idx==NULL)?0:*ad_idx);
+    result = bu_sendAllChunks(ad_idx);
+    if (lock) bu_ptr->locked = TRUE;
+    return (result == 0) ? 0 : -1;
+}
+
 /**
  * Trigger sending of all chunks previously entered with put_Chunk functions
  *  Chunks sent are deleted afterwards.
@@ -454,7 +608,7 @@ gint bu_sendAllChunks(guint * ad_idx)
 
     event_logi(VVERBOSE, "bu_sendAllChunks(finally) : send_len == %d ", send_len);
 
-    if (send_len > 1480) {
+    if (send_len > (gint)(MAX_MTU_SIZE - IP_HEADERLENGTH)) {
         fprintf(stderr, "MTU definitely exceeded (%u) - aborting\n",send_len);
         fprintf(stderr, "sack_position: %u, ctrl_position: %u, data_position: %u\n",
             bu_ptr->sack_position,bu_ptr->ctrl_position,bu_ptr->data_position);
@@ -463,6 +617,8 @@ gint bu_sendAllChunks(guint * ad_idx)
 
     if ((bu_ptr->data_in_buffer) && (idx != -1)) pm_chunksSentOn(idx);
 
+    trc_event(SCTP_TRACE_MODULE_BUNDLING, TRC_PACKET_SENT, mdi_readAssociationID(), idx, send_len);
+
     event_logii(VERBOSE, "bu_sendAllChunks() : sending message len==%u to adress idx=%d", send_len, idx);
 
     result = mdi_send_message((SCTP_message *) send_buffer, send_len, idx);
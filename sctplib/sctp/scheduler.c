@@ -0,0 +1,86 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *           //=====   //===== ===//=== //===//  //       //   //===//
+ *          //        //         //    //    // //       //   //    //
+ *         //====//  //         //    //===//  //       //   //===<<
+ *              //  //         //    //       //       //   //    //
+ *       ======//  //=====    //    //       //=====  //   //===//
+ *
+ * -------------- An SCTP implementation according to RFC 4960 --------------
+ *
+ * Copyright (C) 2000 by Siemens AG, Munich, Germany.
+ * Copyright (C) 2001-2004 Andreas Jungmaier
+ * Copyright (C) 2004-2026 Thomas Dreibholz
+ *
+ * Acknowledgements:
+ * Realized in co-operation between Siemens AG and the University of
+ * Duisburg-Essen, Institute for Experimental Mathematics, Computer
+ * Networking Technology group.
+ * This work was partially funded by the Bundesministerium fuer Bildung und
+ * Forschung (BMBF) of the Federal Republic of Germany
+ * (Förderkennzeichen 01AK045).
+ * The authors alone are responsible for the contents.
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact: sctp-discussion@sctp.de
+ *          thomas.dreibholz@gmail.com
+ *          tuexen@fh-muenster.de
+ *          andreas.jungmaier@web.de
+ */
+
+#include "scheduler.h"
+#include "sctp.h"
+
+#include <glib.h>
+
+/* tags of weighted fair queueing are counted in 1/256 bytes per weight unit */
+#define WFQ_SCALE_SHIFT         8
+
+
+/* round robin and priority : every stream may send one unit per round */
+static unsigned int ss_rr_cost(const ss_stream* stream, unsigned int bytes)
+{
+    return 1;
+}
+
+/* weighted fair queueing : a stream advances by its bytes, divided by its weight */
+static unsigned int ss_wfq_cost(const ss_stream* stream, unsigned int bytes)
+{
+    unsigned int cost;
+
+    if (stream->weight == 0) return bytes << WFQ_SCALE_SHIFT;
+    cost = (bytes << WFQ_SCALE_SHIFT) / stream->weight;
+    return (cost > 0) ? cost : 1;
+}
+
+
+static const ss_ops streamSchedulerModules[] = {
+    { SCTP_SS_FCFS, "fcfs",     NULL,        FALSE },
+    { SCTP_SS_RR,   "rr",       ss_rr_cost,  FALSE },
+    { SCTP_SS_PRIO, "priority", ss_rr_cost,  TRUE  },
+    { SCTP_SS_WFQ,  "wfq",      ss_wfq_cost, FALSE }
+};
+
+
+const ss_ops* ss_getModule(unsigned int scheduler)
+{
+    unsigned int i;
+
+    for (i = 0; i < sizeof(streamSchedulerModules) / sizeof(streamSchedulerModules[0]); i++) {
+        if (streamSchedulerModules[i].scheduler == scheduler) return &streamSchedulerModules[i];
+    }
+    return NULL;
+}
@@ -0,0 +1,103 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *           //=====   //===== ===//=== //===//  //       //   //===//
+ *          //        //         //    //    // //       //   //    //
+ *         //====//  //         //    //===//  //       //   //===<<
+ *              //  //         //    //       //       //   //    //
+ *       ======//  //=====    //    //       //=====  //   //===//
+ *
+ * -------------- An SCTP implementation according to RFC 4960 --------------
+ *
+ * Copyright (C) 2000 by Siemens AG, Munich, Germany.
+ * Copyright (C) 2001-2004 Andreas Jungmaier
+ * Copyright (C) 2004-2026 Thomas Dreibholz
+ *
+ * Acknowledgements:
+ * Realized in co-operation between Siemens AG and the University of
+ * Duisburg-Essen, Institute for Experimental Mathematics, Computer
+ * Networking Technology group.
+ * This work was partially funded by the Bundesministerium fuer Bildung und
+ * Forschung (BMBF) of the Federal Republic of Germany
+ * (Förderkennzeichen 01AK045).
+ * The authors alone are responsible for the contents.
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact: sctp-discussion@sctp.de
+ *          thomas.dreibholz@gmail.com
+ *          tuexen@fh-muenster.de
+ *          andreas.jungmaier@web.de
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "globals.h"
+
+
+/* weight and priority of a stream, until the ULP sets them */
+#define SS_DEFAULT_PRIORITY     0
+#define SS_DEFAULT_WEIGHT       1
+
+/**
+ * scheduling state of one outbound stream
+ */
+typedef struct __stream_scheduling_state
+{
+    /** strict priority of the stream, lower values are sent first */
+    unsigned int priority;
+    /** share of the stream in weighted fair queueing, at least 1 */
+    unsigned int weight;
+    /** tag of the stream's last scheduling unit */
+    unsigned int start_tag;
+    /** earliest tag of the stream's next scheduling unit */
+    unsigned int finish_tag;
+} ss_stream;
+
+
+/**
+ * A stream scheduler orders the unsent chunks of different streams. Flowcontrol
+ * gives every scheduling unit (an I-DATA chunk or a whole DATA message) a tag, that
+ * is the larger of the stream's finish tag and the tag of the chunk last sent, and
+ * sends the chunks in order of priority and tag. The scheduler only decides what a
+ * unit costs, and whether stream priorities are used.
+ */
+typedef struct __stream_scheduler_ops
+{
+    /** SCTP_SS_xxx value of this module */
+    unsigned int scheduler;
+    /** name for debug output */
+    const char* name;
+    /**
+     * returns the amount, by which a chunk of the stream advances its finish tag,
+     * NULL for a scheduler that queues all chunks in the order of submission
+     */
+    unsigned int (*cost) (const ss_stream* stream, unsigned int bytes);
+    /** TRUE, if streams of a lower priority value always go first */
+    gboolean uses_priority;
+} ss_ops;
+
+
+/**
+ * @param  scheduler   one of the SCTP_SS_xxx values from sctp.h
+ * @return the stream scheduler module, or NULL if the scheduler is unknown
+ */
+const ss_ops* ss_getModule(unsigned int scheduler);
+
+#endif
@@ -108,6 +108,12 @@ extern "C" {
 /* boolean, 0==normal bundling, 1==do not bundle message */
 #define SCTP_BUNDLING_ENABLED           0
 #define SCTP_BUNDLING_DISABLED          1
+/* may be or'ed to the dontBundle parameter of sctp_send() : asks the peer to acknowledge
+   the message without delay (I-bit, RFC 7053), e.g. for the last message of a request */
+#define SCTP_SACK_IMMEDIATELY           2
+/* may be or'ed to the dontBundle parameter of sctp_send() : more data follows soon, so
+   the message is held back until a packet is full, or the cork delay has passed */
+#define SCTP_SEND_MORE                  4
 
 /* these are also for sctp_send() */
 #define SCTP_USE_PRIMARY                    -1
@@ -119,6 +125,12 @@ extern "C" {
 /* these are for sctp_receive() */
 #define SCTP_MSG_DEFAULT                    0x00
 #define SCTP_MSG_PEEK                       0x02
+/* for sctp_receivev() : streamID, that receives from all streams */
+#define SCTP_ANY_STREAM                     -1
+/* flags of a message received with sctp_receivev() */
+#define SCTP_MSG_UNORDERED                  0x04    /* message was sent unordered */
+#define SCTP_MSG_TRUNCATED                  0x08    /* buffer was too small, the rest of the message
+                                                       is returned by the next receive call */
 
 #define SCTP_CHECKSUM_ALGORITHM_CRC32C      0x1
 #define SCTP_CHECKSUM_ALGORITHM_ADLER32     0x2
@@ -142,6 +154,7 @@ extern "C" {
 #define SCTP_BUFFER_TOO_SMALL               -14
 #define SCTP_NO_CHUNKS_IN_QUEUE             -15
 #define SCTP_INSTANCE_IN_USE                -16
+#define SCTP_MEMORY_BUDGET_EXCEEDED         -17
 #define SCTP_SPECIFIC_FUNCTION_ERROR        1
 
 /* some constants for return codes from COMMUNICATION LOST or COMMUNICATION UP callbacks */
@@ -160,6 +173,19 @@ extern "C" {
 #define SCTP_COMM_UP_RECEIVED_COOKIE_RESTART     3
 
 #define SCTP_SEND_QUEUE                         1
+/* queue type for memory pressure: queue id 1 when pressure starts, 0 when it ends */
+#define SCTP_MEMORY_QUEUE                       2
+
+/* congestion control algorithms, see SCTP_InstanceParameters and SCTP_AssociationStatus */
+#define SCTP_CC_RENO                            0
+#define SCTP_CC_CUBIC                           1
+#define SCTP_CC_DELAY                           2
+
+/* outbound stream schedulers, see SCTP_InstanceParameters and SCTP_AssociationStatus */
+#define SCTP_SS_FCFS                            0
+#define SCTP_SS_RR                              1
+#define SCTP_SS_PRIO                            2
+#define SCTP_SS_WFQ                             3
 
 
 /******************** Structure Definitions *******************************************************/
@@ -276,10 +302,58 @@ struct SCTP_ulp_Callbacks
      *  @param 4 pointer to ULP data
      */
     void (*asconfStatusNotif) (unsigned int, unsigned int, int, void*, void*);
+    /**
+     * indicates that new data arrived from peer, for associations with coalesceDataArrivals
+     * set (see SCTP_AssociationStatus) : replaces the dataArriveNotif calls of all messages
+     * that arrived during one pass of the event loop.
+     *  @param 1 associationID
+     *  @param 2 number of entries in the array of message counts
+     *  @param 3 number of messages, that arrived on each stream (indexed by stream ID)
+     *  @param 4 pointer to ULP data
+     */
+    void (*dataArriveBatchNotif) (unsigned int, unsigned int, const unsigned int*, void*);
     /* @} */
 }SCTP_ulpCallbacks;
 
 
+/* types of the records in a completion queue (see sctp_setEventQueue()), and their
+   parameters, in the order of the parameters of the respective callback */
+#define SCTP_EVENT_DATA_ARRIVE              1   /* streamID, length, streamSN, tsn, protocolId, unordered */
+#define SCTP_EVENT_SEND_FAILURE             2   /* dataLength (the context is in the context field) */
+#define SCTP_EVENT_NETWORK_STATUS_CHANGE    3   /* destination address index, new state */
+#define SCTP_EVENT_COMMUNICATION_UP         4   /* status, noOfDestinations, inStreams, outStreams, PR-SCTP */
+#define SCTP_EVENT_COMMUNICATION_LOST       5   /* status */
+#define SCTP_EVENT_RESTART                  6
+#define SCTP_EVENT_PEER_SHUTDOWN_RECEIVED   7
+#define SCTP_EVENT_SHUTDOWN_COMPLETE        8
+#define SCTP_EVENT_QUEUE_STATUS_CHANGE      9   /* queue type, queue identifier, queue length */
+#define SCTP_EVENT_QUEUE_OVERFLOW           10  /* number of records lost, because the queue was full */
+
+/* smallest completion queue : after an overflow, the next record comes with an overflow record */
+#define SCTP_MIN_EVENT_QUEUE_SIZE           2
+
+typedef
+/**
+ * record of a completion queue, that replaces one call of a callback function in
+ * SCTP_ulpCallbacks
+ */
+struct SCTP_EVENT_RECORD
+{
+    /* @{ */
+    /** one of the SCTP_EVENT_xxx values */
+    unsigned int type;
+    /** association, to which the event belongs (0 for SCTP_EVENT_QUEUE_OVERFLOW) */
+    unsigned int associationID;
+    /** parameters of the event, see SCTP_EVENT_xxx */
+    unsigned int param[6];
+    /** context of the message, that could not be sent (SCTP_EVENT_SEND_FAILURE) */
+    void* context;
+    /** pointer to ULP data of the association */
+    void* ulpData;
+    /* @} */
+} SCTP_Event;
+
+
 typedef
 /**
  * This struct contains parameters that may be set globally with
@@ -311,7 +385,37 @@ struct SCTP_Library_Parameters {
      * Allowed values are 0 (==FALSE) or 1 (== TRUE)
      */
     int supportADDIP;
-
+    /**
+     * library-wide budget (in bytes) for user data held in the send and
+     * receive queues of all associations, 0 means unlimited (default).
+     * When the budget is nearly used up, advertised receiver windows are
+     * reduced, sctp_send() fails with SCTP_MEMORY_BUDGET_EXCEEDED and the
+     * largest consumers get a queueStatusChangeNotif (SCTP_MEMORY_QUEUE). This
+     * notification comes from the event loop, after the packet or timer that
+     * caused it, also when the memory was charged by sctp_send()
+     */
+    unsigned int memoryBudget;
+    /**
+     * number of bytes currently charged against the memory budget
+     * (read only, ignored by sctp_setLibraryParameters())
+     */
+    unsigned int memoryInUse;
+    /**
+     * offer Explicit Congestion Notification (RFC 4960, appendix A) in new
+     * associations. Allowed values are 0 (==FALSE, default) or 1 (== TRUE)
+     */
+    int supportECN;
+    /**
+     * offer non-renegable SACKs (NR-SACK) in new associations, so that the peer frees
+     * data we have delivered at once. Allowed values are 0 (==FALSE, default) or 1 (== TRUE)
+     */
+    int supportNRSACK;
+    /**
+     * offer I-DATA chunks (RFC 8260) in new associations, so that fragments of large
+     * messages are interleaved with the messages of other streams. I-DATA is only used
+     * in associations without PR-SCTP. Allowed values are 0 (==FALSE, default) or 1 (== TRUE)
+     */
+    int supportIDATA;
 
 }SCTP_LibraryParameters;
 
@@ -370,6 +474,49 @@ struct SCTP_Instance_Parameters {
      * there are that many associations !
      */
     unsigned int maxNumberOfAssociations;
+    /**
+     * congestion control algorithm of new associations: SCTP_CC_RENO (RFC 4960, default),
+     * SCTP_CC_CUBIC or SCTP_CC_DELAY (delay-based, for paths with deep buffers)
+     */
+    unsigned int congestionControl;
+    /**
+     * pacing gain in percent of cwnd/srtt per path, 0 disables pacing (default).
+     * Paths in slow start are paced at twice this rate.
+     */
+    unsigned int pacingGain;
+    /**
+     * concurrent multipath transfer: spread new data over all active paths
+     * instead of sending it to the primary path only, no==0 (default), yes==1
+     */
+    unsigned int concurrentMultipath;
+    /**
+     * packetization layer path MTU discovery: probe each path for the largest packet
+     * size it carries, no==0 (default), yes==1
+     */
+    unsigned int pathMTUDiscovery;
+    /**
+     * receiver window autotuning: the window advertised by an association starts small,
+     * and grows with the rate at which the ULP reads data, up to myRwnd. no==0 (default), yes==1
+     */
+    unsigned int rwndAutotuning;
+    /**
+     * stream scheduler of new associations, that decides which stream's data is sent
+     * next: SCTP_SS_FCFS (order of submission, default), SCTP_SS_RR (round robin),
+     * SCTP_SS_PRIO (strict priority, see sctp_setStreamPriority()) or SCTP_SS_WFQ
+     * (weighted fair queueing, see sctp_setStreamWeight()). Unless a scheduler is set
+     * here, associations that use I-DATA go round robin, so that messages are interleaved
+     */
+    unsigned int streamScheduler;
+    /**
+     * time in msecs, that data held back by sctp_setCork() or SCTP_SEND_MORE may wait
+     * for more data, before it is sent in a packet that is not full
+     */
+    unsigned int corkDelay;
+    /**
+     * report the data arriving for new associations during one pass of the event loop with
+     * one dataArriveBatchNotif instead of one dataArriveNotif per message. no==0 (default), yes==1
+     */
+    unsigned int coalesceDataArrivals;
     /* @} */
 } SCTP_InstanceParameters;
 
@@ -440,6 +587,24 @@ struct SCTP_Association_Status
      *  Is this really needed ? The protocol limits the receive queue with
      *  window advertisement of arwnd==0  */
     unsigned int maxRecvQueue;
+    /** (get/set) congestion control algorithm, one of the SCTP_CC_xxx values */
+    unsigned int congestionControl;
+    /** (get/set) pacing gain in percent, 0 if pacing is disabled */
+    unsigned int pacingGain;
+    /** (get/set) concurrent multipath transfer over all active paths no==0, yes==1 */
+    unsigned int concurrentMultipath;
+    /** (get/set) path MTU discovery by probing no==0, yes==1 */
+    unsigned int pathMTUDiscovery;
+    /** (get/set) stream scheduler, one of the SCTP_SS_xxx values */
+    unsigned int streamScheduler;
+    /** (get/set) receiver window autotuning no==0, yes==1, myRwnd is the upper limit */
+    unsigned int rwndAutotuning;
+    /** (get) receiver window, that autotuning currently allows */
+    unsigned int tunedRwnd;
+    /** (get/set) msecs that corked data waits for a full packet, see sctp_setCork() */
+    unsigned int corkDelay;
+    /** (get/set) report arrivals with dataArriveBatchNotif no==0, yes==1 */
+    unsigned int coalesceDataArrivals;
     /* @} */
 } SCTP_AssociationStatus;
 
@@ -475,14 +640,116 @@ struct SCTP_Path_Status
     unsigned int ssthresh;
     /**  from flow control */
     unsigned int outstandingBytesPerAddress;
-    /**  Current MTU (flowcontrol) */
+    /**  Current MTU (flowcontrol), without IP and SCTP common header, see sctp_setPathMTU() */
     unsigned int mtu;
     /** per path ? per instance ? for the IP type of service field. */
     unsigned char ipTos;
+    /** current pacing rate in bytes per second, 0 if the path is not paced */
+    unsigned int pacingRate;
+    /** microseconds until pacing lets the next packet leave on this path */
+    unsigned int pacingDelay;
     /* @} */
 }SCTP_PathStatus;
 
 
+/**
+ * cumulative protocol counters of an association. For association id 0,
+ * the counters of all packets that could not be assigned to an association
+ * are returned (OOTB packets, invalid packets and so on).
+ */
+typedef struct SCTP_ASSOCIATION_STATISTICS
+{
+    /* @{ */
+    /** bytes of SCTP packets sent (SCTP common header and chunks) */
+    unsigned long long bytesSent;
+    /** bytes of SCTP packets received (SCTP common header and chunks) */
+    unsigned long long bytesReceived;
+    /** SCTP packets sent */
+    unsigned int packetsSent;
+    /** SCTP packets received and accepted */
+    unsigned int packetsReceived;
+    /** DATA chunks sent, including retransmissions */
+    unsigned int dataChunksSent;
+    /** new DATA chunks received (not counting duplicates) */
+    unsigned int dataChunksReceived;
+    /** DATA chunks that were retransmitted */
+    unsigned int retransmittedChunks;
+    /** fast retransmit events */
+    unsigned int fastRetransmits;
+    /** T3 retransmission timer expiries */
+    unsigned int t3Timeouts;
+    /** SACK chunks sent */
+    unsigned int sacksSent;
+    /** packets with DATA, for which the SACK was delayed or left out (ACK thinning) */
+    unsigned int sacksSuppressed;
+    /** SACK chunks received */
+    unsigned int sacksReceived;
+    /** duplicate TSNs received */
+    unsigned int duplicateTsnsReceived;
+    /** gap ack blocks received in SACK chunks */
+    unsigned int gapBlocksReceived;
+    /** PR-SCTP chunks abandoned because their lifetime expired */
+    unsigned int abandonedChunks;
+    /** packets dropped (wrong addresses, ports or verification tag) */
+    unsigned int droppedPackets;
+    /** out of the blue packets, i.e. packets that matched no association */
+    unsigned int ootbPackets;
+    /** packets discarded for bad length or checksum */
+    unsigned int invalidPackets;
+    /* @} */
+}SCTP_AssociationStatistics;
+
+
+/**
+ * cumulative protocol counters of one path of an association
+ */
+typedef struct SCTP_PATH_STATISTICS
+{
+    /* @{ */
+    /** bytes of SCTP packets sent on this path */
+    unsigned long long bytesSent;
+    /** bytes of SCTP packets received from this path */
+    unsigned long long bytesReceived;
+    /** SCTP packets sent on this path */
+    unsigned int packetsSent;
+    /** SCTP packets received from this path */
+    unsigned int packetsReceived;
+    /** DATA chunks sent on this path, including retransmissions */
+    unsigned int dataChunksSent;
+    /** DATA chunks retransmitted on this path */
+    unsigned int retransmittedChunks;
+    /** T3 retransmission timer expiries of this path */
+    unsigned int t3Timeouts;
+    /* @} */
+}SCTP_PathStatistics;
+
+
+/* number of buckets of a latency histogram. Values below 8 have a bucket of their own,
+   above that every power of two is split into 8 buckets (i.e. 12.5% resolution) */
+#define SCTP_HISTOGRAM_SUB_BUCKETS      8
+#define SCTP_HISTOGRAM_BUCKETS          240
+
+/**
+ * log-bucketed histogram of latency samples, all values in microseconds.
+ * Use sctp_getHistogramBucketLimit() to find the value range of a bucket.
+ */
+typedef struct SCTP_LATENCY_HISTOGRAM
+{
+    /* @{ */
+    /** number of samples recorded */
+    unsigned int samples;
+    /** smallest sample recorded */
+    unsigned int minimum;
+    /** largest sample recorded */
+    unsigned int maximum;
+    /** sum of all samples, for computing the mean */
+    unsigned long long sum;
+    /** number of samples per bucket */
+    unsigned int bucket[SCTP_HISTOGRAM_BUCKETS];
+    /* @} */
+}SCTP_LatencyHistogram;
+
+
 /******************** Function Definitions ********************************************************/
 
 /**
@@ -513,6 +780,10 @@ int sctp_registerInstance(unsigned short localPort,
 
 int sctp_unregisterInstance(unsigned short instance_name);
 
+int sctp_setEventQueue(unsigned short instance_name, unsigned int size, void** queue);
+
+int sctp_readEventQueue(void* queue, SCTP_Event* events, unsigned int max);
+
 
 
 
@@ -548,7 +819,40 @@ int sctp_send_private(unsigned int associationID,
                       void * context,        /* SCTP_NO_CONTEXT */
                       unsigned int lifetime, /* 0xFFFFFFFF-> infinite, 0->no retransmit, else msecs */
                       int unorderedDelivery, /* use constants SCTP_ORDERED_DELIVERY, SCTP_UNORDERED_DELIVERY */
-                      int dontBundle);  /* use constants SCTP_BUNDLING_ENABLED, SCTP_BUNDLING_DISABLED */
+                      int dontBundle);  /* use constants SCTP_BUNDLING_ENABLED, SCTP_BUNDLING_DISABLED,
+                                           optionally or'ed with SCTP_SACK_IMMEDIATELY */
+
+/**
+ * one message of a batch, that is sent with sctp_sendv(). The fields have the
+ * meaning of the parameters of sctp_send().
+ */
+typedef struct SCTP_SEND_DESCRIPTOR
+{
+    /* @{ */
+    /** stream on which the message is sent */
+    unsigned short streamID;
+    /** message data */
+    unsigned char *buffer;
+    /** length of the message data */
+    unsigned int length;
+    /** payload protocol identifier */
+    unsigned int protocolId;
+    /** SCTP_USE_PRIMARY, else index of the destination address */
+    short path_id;
+    /** ULP context, SCTP_NO_CONTEXT if none */
+    void *context;
+    /** lifetime in msecs, SCTP_INFINITE_LIFETIME or SCTP_NO_RETRANSMISSION */
+    unsigned int lifetime;
+    /** SCTP_ORDERED_DELIVERY or SCTP_UNORDERED_DELIVERY */
+    int unorderedDelivery;
+    /** SCTP_BUNDLING_ENABLED or SCTP_BUNDLING_DISABLED, optionally or'ed with SCTP_SACK_IMMEDIATELY */
+    int dontBundle;
+    /* @} */
+} SCTP_SendDescriptor;
+
+int sctp_sendv(unsigned int associationID, const SCTP_SendDescriptor* msgs, unsigned int count);
+
+int sctp_setCork(unsigned int associationID, int cork);
 
 
 /*
@@ -565,6 +869,35 @@ int sctp_receivefrom(unsigned int associationID, unsigned short streamID, unsign
                      unsigned int *length, unsigned short *streamSN, unsigned int * tsn,
                      unsigned int *addressIndex, unsigned int flags);
 
+/**
+ * one message received with sctp_receivev() : buffer and length are set by the caller,
+ * the other fields are filled in when a message has been received
+ */
+typedef struct SCTP_RECEIVE_DESCRIPTOR
+{
+    /* @{ */
+    /** buffer, that the message is copied to */
+    unsigned char *buffer;
+    /** size of buffer, is set to the number of bytes received */
+    unsigned int length;
+    /** stream, on which the message was received */
+    unsigned short streamID;
+    /** stream sequence number of the message */
+    unsigned short streamSN;
+    /** TSN of (a fragment of) the message */
+    unsigned int tsn;
+    /** payload protocol identifier */
+    unsigned int protocolId;
+    /** index of the address, the message was received from */
+    unsigned int addressIndex;
+    /** SCTP_MSG_UNORDERED, SCTP_MSG_TRUNCATED */
+    unsigned int flags;
+    /* @} */
+} SCTP_ReceiveDescriptor;
+
+int sctp_receivev(unsigned int associationID, int streamID, SCTP_ReceiveDescriptor* msgs,
+                  unsigned int max, unsigned int flags);
+
 
 
 /*----------------------------------------------------------------------------------------------*/
@@ -584,6 +917,45 @@ int sctp_setAssocStatus(unsigned int associationID, SCTP_AssociationStatus* new_
 
 int sctp_getPathStatus(unsigned int associationID, short path_id, SCTP_PathStatus* status);
 int sctp_setPathStatus(unsigned int associationID, short path_id, SCTP_PathStatus *new_status);
+int sctp_setPathMTU(unsigned int associationID, short path_id, unsigned int mtu);
+
+int sctp_getStreamPriority(unsigned int associationID, unsigned short streamID, unsigned int* priority);
+int sctp_setStreamPriority(unsigned int associationID, unsigned short streamID, unsigned int priority);
+int sctp_getStreamWeight(unsigned int associationID, unsigned short streamID, unsigned int* weight);
+int sctp_setStreamWeight(unsigned int associationID, unsigned short streamID, unsigned int weight);
+
+int sctp_getAssocStatistics(unsigned int associationID, SCTP_AssociationStatistics* statistics);
+
+int sctp_getPathStatistics(unsigned int associationID, short path_id, SCTP_PathStatistics* statistics);
+
+/**
+ * returns the histogram of raw RTT samples of a path (data and heartbeat RTT measurements)
+ */
+int sctp_getRttHistogram(unsigned int associationID, short path_id, SCTP_LatencyHistogram* histogram);
+
+/**
+ * returns the histogram of send-to-ack latencies of the DATA chunks of an association,
+ * measured from the (last) transmission of a chunk to the SACK that first acknowledged it
+ */
+int sctp_getAckLatencyHistogram(unsigned int associationID, SCTP_LatencyHistogram* histogram);
+
+/**
+ * clears the RTT histograms of all paths and the send-to-ack histogram of an association
+ */
+int sctp_resetLatencyHistograms(unsigned int associationID);
+
+/**
+ * @param  bucket   index of a histogram bucket
+ * @return the largest value (in microseconds) that is counted in this bucket
+ */
+unsigned int sctp_getHistogramBucketLimit(unsigned int bucket);
+
+/**
+ * @param  histogram   histogram returned by sctp_getRttHistogram() or sctp_getAckLatencyHistogram()
+ * @param  percentile  percentile to compute, between 0.0 and 100.0
+ * @return upper limit (in microseconds) of the bucket containing the percentile, 0 if the histogram is empty
+ */
+unsigned int sctp_getHistogramPercentile(const SCTP_LatencyHistogram* histogram, double percentile);
 /*----------------------------------------------------------------------------------------------*/
 /*
  * These _could_ be build up from the above functions, but for the sake of a
@@ -737,6 +1109,98 @@ int sctp_eventLoop(void);
 
 int sctp_extendedEventLoop(void (*lock)(void* data), void (*unlock)(void* data), void* data);
 
+
+/* dispatch categories of the event loop profile */
+#define SCTP_PROFILE_TIMER_INIT            0
+#define SCTP_PROFILE_TIMER_SHUTDOWN        1
+#define SCTP_PROFILE_TIMER_SACK            2
+#define SCTP_PROFILE_TIMER_RTXM            3
+#define SCTP_PROFILE_TIMER_CWND            4
+#define SCTP_PROFILE_TIMER_HEARTBEAT       5
+#define SCTP_PROFILE_TIMER_USER            6
+#define SCTP_PROFILE_POLL                  7
+#define SCTP_PROFILE_SCTP_PACKETS          8
+#define SCTP_PROFILE_UDP_CALLBACKS         9
+#define SCTP_PROFILE_USER_CALLBACKS        10
+#define SCTP_PROFILE_ULP_NOTIFICATIONS     11
+#define SCTP_PROFILE_CATEGORIES            12
+
+typedef struct SCTP_Profile_Counter
+{
+    /* number of times the category was entered */
+    unsigned long long count;
+    /* accumulated wall clock time in microseconds */
+    unsigned long long wallTime;
+    /* accumulated CPU time of the calling thread in microseconds, 0 if not supported */
+    unsigned long long cpuTime;
+}
+SCTP_ProfileCounter;
+
+typedef struct SCTP_Event_Loop_Profile
+{
+    SCTP_ProfileCounter category[SCTP_PROFILE_CATEGORIES];
+}
+SCTP_EventLoopProfile;
+
+/**
+ * Switches accounting of the time spent in the event loop on or off.
+ * SCTP_PROFILE_POLL is the time blocked in select(), the timer categories are the
+ * time spent in the timer callbacks, by timer type. ULP notifications are measured
+ * while nested inside the packet, timer or user callback that triggered them, so their
+ * time is also contained in that enclosing category.
+ * @param  enable   TRUE to switch profiling on, FALSE to switch it off
+ * @return SCTP_SUCCESS
+ */
+int sctp_setEventLoopProfiling(int enable);
+
+/**
+ * @param  profile  returns the counters accumulated since the last reset
+ * @return SCTP_SUCCESS, or SCTP_PARAMETER_PROBLEM if profile is NULL
+ */
+int sctp_getEventLoopProfile(SCTP_EventLoopProfile* profile);
+
+/**
+ * clears all event loop profile counters
+ */
+int sctp_resetEventLoopProfile(void);
+
+
+/* modules that can be selected for binary tracing (bit mask) */
+#define SCTP_TRACE_MODULE_DISTRIBUTION     0x00000001
+#define SCTP_TRACE_MODULE_BUNDLING         0x00000002
+#define SCTP_TRACE_MODULE_RECVCTRL         0x00000004
+#define SCTP_TRACE_MODULE_RELTRANSFER      0x00000008
+#define SCTP_TRACE_MODULE_FLOWCONTROL      0x00000010
+#define SCTP_TRACE_MODULE_PATHMANAGEMENT   0x00000020
+#define SCTP_TRACE_MODULE_STREAMENGINE     0x00000040
+#define SCTP_TRACE_MODULE_ALL              0x0000007F
+
+/**
+ * Switches on binary tracing of protocol events into an in-memory ring.
+ * May be called again to change the set of traced modules; the ring keeps
+ * its contents unless its size changes.
+ * @param moduleMask        SCTP_TRACE_MODULE_xxx bits of the modules to trace
+ * @param numberOfRecords   size of the ring in records (rounded up to a power of two),
+ *                          0 for the default size
+ * @return SCTP_SUCCESS, or SCTP_OUT_OF_RESOURCES if the ring could not be allocated
+ */
+int sctp_enableTracing(unsigned int moduleMask, unsigned int numberOfRecords);
+
+/**
+ * Switches off tracing. The ring contents are kept and may still be written out.
+ * @return SCTP_SUCCESS
+ */
+int sctp_disableTracing(void);
+
+/**
+ * Writes the current contents of the trace ring to a file, oldest record first.
+ * The file can be decoded with the trace_decoder program.
+ * @param fileName   name of the file to create
+ * @return SCTP_SUCCESS, SCTP_PARAMETER_PROBLEM if there is no ring or the
+ *         file could not be written
+ */
+int sctp_writeTraceFile(const char* fileName);
+
 /**
  *  these next funtions are unused. They should either be implemented, or removed :-)
  *  Maybe we should ask Thomas...
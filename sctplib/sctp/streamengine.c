@@ -49,6 +49,7 @@
 #include "distribution.h"
 #include "errorhandler.h"
 #include "SCTP-control.h"
+#include "trace.h"
 
 #include "recvctrl.h"
 
@@ -66,12 +67,16 @@ typedef struct
     guint16  nextSSN;
     guint16  highestSSN;      /* used to detect Protocol violations in se_searchReadyPdu */
     gboolean highestSSNused;
+    guint32  nextMID;         /* next ordered message expected in I-DATA chunks */
     int index;
 }ReceiveStream;
 
 typedef struct
 {
     unsigned int nextSSN;
+    /* message identifiers of ordered and unordered messages sent in I-DATA chunks */
+    unsigned int nextMID;
+    unsigned int nextUnorderedMID;
 }SendStream;
 
 typedef struct
@@ -83,6 +88,8 @@ typedef struct
     gboolean*       recvStreamActivated;
     unsigned int    queuedBytes;
     gboolean        unreliable;
+    /* stream, with which the next se_ulpreceivev() from any stream starts */
+    unsigned int    nextReceiveStream;
 
     GList           *List;	 /* list for all packets */
 }StreamEngine;
@@ -98,8 +105,12 @@ typedef struct _delivery_data
     guint16 stream_id;
     guint16 stream_sn;
     guint32 protocolId;
+    /* message identifier and fragment sequence number of I-DATA chunks */
+    guint32 message_id;
+    guint32 fsn;
     guint32 fromAddressIndex;
-    guchar  data[MAX_DATACHUNK_PDU_LENGTH];
+    /* user data, allocated with data_length bytes */
+    guchar  data[];
 }
 delivery_data;
 
@@ -123,6 +134,7 @@ typedef struct _delivery_pdu
 
 /******************** Declarations *************************************************/
 int se_searchReadyPdu(StreamEngine* se);
+int se_searchReadyIdataPdu(StreamEngine* se);
 int se_deliverWaiting(StreamEngine* se, unsigned short sid);
 
 void print_element(gpointer list_element, gpointer user_data)
@@ -201,6 +213,7 @@ void* se_new_stream_engine (unsigned int numberReceiveStreams,        /* max of
 
     for (i = 0; i < numberReceiveStreams; i++) {
       (se->RecvStreams)[i].nextSSN = 0;
+      (se->RecvStreams)[i].nextMID = 0;
       (se->RecvStreams)[i].pduList = NULL;
       (se->RecvStreams)[i].prePduList = NULL;
       (se->RecvStreams)[i].index = 0; /* for ordered chunks, next ssn */
@@ -208,9 +221,12 @@ void* se_new_stream_engine (unsigned int numberReceiveStreams,        /* max of
     for (i = 0; i < numberSendStreams; i++)
     {
       (se->SendStreams[i]).nextSSN = 0;
+      (se->SendStreams[i]).nextMID = 0;
+      (se->SendStreams[i]).nextUnorderedMID = 0;
     }
 
     se->queuedBytes = 0;
+    se->nextReceiveStream = 0;
     se->List          = NULL;
     return (se);
 }
@@ -282,6 +298,100 @@ se_readNumberOfStreams (unsigned short *inStreams, unsigned short *outStreams)
 
 /******************** Functions for Sending *****************************************/
 
+/**
+ * sends a message in I-DATA chunks (RFC 8260) : the fragments carry a message identifier
+ * and a fragment sequence number instead of consecutive TSNs, so that flowcontrol may
+ * interleave them with the fragments of messages on other streams
+ * @return SCTP_SUCCESS, or an error code
+ */
+static int
+se_ulpsend_idata (StreamEngine* se, unsigned short streamId, unsigned char *buffer,
+                  unsigned int byteCount,  unsigned int protocolId,
+                  short destAddressIndex, void *context,
+                  gboolean unorderedDelivery, gboolean dontBundle, gboolean sackImmediately,
+                  unsigned int maxDataLength, unsigned int maxQueueLen)
+{
+    chunk_data*  cdata=NULL;
+    chunk_data** fragments=NULL;
+    SCTP_idata_chunk* ichunk=NULL;
+    unsigned char* bufPosition = buffer;
+    unsigned int bCount, numberOfSegments, fsn, mid;
+    int result, retVal = SCTP_SUCCESS;
+
+    /* the I-DATA chunk header is four bytes longer than that of a DATA chunk */
+    maxDataLength -= (FIXED_IDATA_CHUNK_SIZE - FIXED_DATA_CHUNK_SIZE);
+
+    numberOfSegments = (byteCount + maxDataLength - 1) / maxDataLength;
+    if (numberOfSegments == 0) numberOfSegments = 1;
+
+    if (maxQueueLen > 0) {
+        if ((numberOfSegments + fc_readNumberOfQueuedChunks()) > maxQueueLen) return SCTP_QUEUE_EXCEEDED;
+    }
+
+    /* all fragments are built before the first one is handed to flowcontrol, so that
+       a failing malloc does not leave a partial message in the send queue */
+    fragments = (chunk_data**)malloc(numberOfSegments * sizeof(chunk_data*));
+    if (fragments == NULL) return SCTP_OUT_OF_RESOURCES;
+
+    for (fsn = 0; fsn < numberOfSegments; fsn++)
+    {
+        bCount = (fsn == numberOfSegments - 1) ? byteCount - fsn * maxDataLength : maxDataLength;
+        fragments[fsn] = (chunk_data*)malloc(CHUNK_DATA_SIZE(bCount + FIXED_IDATA_CHUNK_SIZE));
+        if (fragments[fsn] == NULL) {
+            error_logi (ERROR_MINOR, "se_ulpsend_idata: out of memory after %u fragments", fsn);
+            while (fsn > 0) free(fragments[--fsn]);
+            free(fragments);
+            return SCTP_OUT_OF_RESOURCES;
+        }
+    }
+
+    /* ordered and unordered messages are numbered independently */
+    if (unorderedDelivery) {
+        mid = se->SendStreams[streamId].nextUnorderedMID++;
+    } else {
+        mid = se->SendStreams[streamId].nextMID++;
+    }
+
+    for (fsn = 0; fsn < numberOfSegments; fsn++)
+    {
+        bCount = (fsn == numberOfSegments - 1) ? byteCount - fsn * maxDataLength : maxDataLength;
+        cdata = fragments[fsn];
+
+        ichunk = (SCTP_idata_chunk*)cdata->data;
+
+        ichunk->chunk_id      = CHUNK_IDATA;
+        ichunk->chunk_flags   = 0;
+        if (fsn == 0) ichunk->chunk_flags |= SCTP_DATA_BEGIN_SEGMENT;
+        if (fsn == numberOfSegments - 1) ichunk->chunk_flags |= SCTP_DATA_END_SEGMENT;
+        if (fsn == numberOfSegments - 1 && sackImmediately) ichunk->chunk_flags |= SCTP_DATA_SACK_IMMEDIATELY;
+        if (unorderedDelivery) ichunk->chunk_flags |= SCTP_DATA_UNORDERED;
+        ichunk->chunk_length  = htons ((unsigned short)(bCount + FIXED_IDATA_CHUNK_SIZE));
+        ichunk->tsn           = 0;        /* gets assigned in the flowcontrol module */
+        ichunk->stream_id     = htons (streamId);
+        ichunk->reserved      = 0;
+        ichunk->message_id    = htonl (mid);
+        /* the first fragment carries the protocol id, all others their fragment number */
+        ichunk->ppid_fsn      = (fsn == 0) ? protocolId : htonl (fsn);
+
+        memcpy (ichunk->data, bufPosition, bCount);
+        bufPosition += bCount;
+
+        event_logiii (EXTERNAL_EVENT, "======> SE sends I-DATA fragment %u of message (MID=%u, SID=%u) to FlowControl <======",
+                        fsn, mid, streamId);
+
+        /* I-DATA is not used together with PR-SCTP */
+        result = fc_send_data_chunk (cdata, destAddressIndex, 0xFFFFFFFF, dontBundle, context);
+
+        if (result != SCTP_SUCCESS) {
+            error_logi (ERROR_MINOR, "se_ulpsend_idata() failed with result %d", result);
+            retVal = result;
+        }
+    }
+    free(fragments);
+    return retVal;
+}
+
+
 /**
  * This function is called to send a chunk.
  *  called from MessageDistribution
@@ -299,12 +409,17 @@ se_ulpsend (unsigned short streamId, unsigned char *buffer,
     SCTP_data_chunk* dchunk=NULL;
     unsigned char* bufPosition = buffer;
 
-    unsigned int bCount = 0, maxQueueLen = 0;
+    unsigned int bCount = 0, maxQueueLen = 0, maxDataLength;
     int numberOfSegments, residual;
 
     int i = 0;
     int result = 0, retVal;
+    gboolean sackImmediately, more;
 
+    /* the peer is asked for an immediate SACK of the last chunk of the message */
+    sackImmediately = (dontBundle & SCTP_SACK_IMMEDIATELY) ? TRUE : FALSE;
+    more = (dontBundle & SCTP_SEND_MORE) ? TRUE : FALSE;
+    dontBundle = (dontBundle & SCTP_BUNDLING_DISABLED) ? TRUE : FALSE;
 
     state = sci_getState ();
     if (sci_shutdown_procedure_started () == TRUE)
@@ -313,8 +428,10 @@ se_ulpsend (unsigned short streamId, unsigned char *buffer,
         "se_ulpsend: Cannot send Chunk, Association (state==%u) in SHUTDOWN-phase", state);
         return SCTP_SPECIFIC_FUNCTION_ERROR;
     }
+    fc_set_more(more);
 
     event_logii (EXTERNAL_EVENT, "se_ulpsend : %u bytes for stream %u", byteCount,streamId);
+    trc_event(SCTP_TRACE_MODULE_STREAMENGINE, TRC_ULP_SEND, mdi_readAssociationID(), streamId, byteCount);
 
     se = (StreamEngine*) mdi_readStreamEngine ();
     if (se == NULL)
@@ -331,20 +448,32 @@ se_ulpsend (unsigned short streamId, unsigned char *buffer,
         return SCTP_PARAMETER_PROBLEM;
     }
 
+    if (mdi_memoryAvailable(byteCount) == FALSE) {
+        event_logi(EXTERNAL_EVENT, "se_ulpsend: memory budget exhausted, rejecting %u bytes", byteCount);
+        return SCTP_MEMORY_BUDGET_EXCEEDED;
+    }
+
     result = fc_get_maxSendQueue(&maxQueueLen);
     if (result != SCTP_SUCCESS) return SCTP_UNSPECIFIED_ERROR;
 
 
     retVal = SCTP_SUCCESS;
 
-    /* if (byteCount <= fc_getMTU())          */
-    if (byteCount <= SCTP_MAXIMUM_DATA_LENGTH)
+    /* fragment according to the MTU of the destination, or of all paths */
+    maxDataLength = fc_readMaxDataLength(destAddressIndex);
+
+    if (mdi_supportsIDATA() == TRUE) {
+        return se_ulpsend_idata(se, streamId, buffer, byteCount, protocolId, destAddressIndex, context,
+                                unorderedDelivery, dontBundle, sackImmediately, maxDataLength, maxQueueLen);
+    }
+
+    if (byteCount <= maxDataLength)
     {
        if (maxQueueLen > 0) {
          if ((1 + fc_readNumberOfQueuedChunks()) > maxQueueLen) return SCTP_QUEUE_EXCEEDED;
        }
 
-        cdata = (chunk_data*)malloc(sizeof(chunk_data));
+        cdata = (chunk_data*)malloc(CHUNK_DATA_SIZE(byteCount + FIXED_DATA_CHUNK_SIZE));
         if (cdata == NULL) {
             return SCTP_OUT_OF_RESOURCES;
         }
@@ -353,6 +482,7 @@ se_ulpsend (unsigned short streamId, unsigned char *buffer,
 
         dchunk->chunk_id      = CHUNK_DATA;
         dchunk->chunk_flags   = (guint8)SCTP_DATA_BEGIN_SEGMENT + SCTP_DATA_END_SEGMENT;
+        if (sackImmediately) dchunk->chunk_flags |= SCTP_DATA_SACK_IMMEDIATELY;
         dchunk->chunk_length  = htons ((unsigned short)(byteCount + FIXED_DATA_CHUNK_SIZE));
         dchunk->tsn = 0;        /* gets assigned in the flowcontrol module */
         dchunk->stream_id     = htons (streamId);
@@ -384,13 +514,13 @@ se_ulpsend (unsigned short streamId, unsigned char *buffer,
     }
     else
     {
-        /* calculate nr. of necessary chunks -> use fc_getMTU() later !!! */
-      numberOfSegments = byteCount / SCTP_MAXIMUM_DATA_LENGTH;
-      residual = byteCount % SCTP_MAXIMUM_DATA_LENGTH;
+        /* calculate nr. of necessary chunks */
+      numberOfSegments = byteCount / maxDataLength;
+      residual = byteCount % maxDataLength;
       if (residual != 0) {
             numberOfSegments++;
       } else {
-            residual = SCTP_MAXIMUM_DATA_LENGTH;
+            residual = maxDataLength;
       }
 
       if (maxQueueLen > 0) {
@@ -399,7 +529,7 @@ se_ulpsend (unsigned short streamId, unsigned char *buffer,
 
       for (i = 1; i <= numberOfSegments; i++)
       {
-            cdata = (chunk_data*)malloc(sizeof(chunk_data));
+            cdata = (chunk_data*)malloc(CHUNK_DATA_SIZE(maxDataLength + FIXED_DATA_CHUNK_SIZE));
             if (cdata == NULL) {
                 /* FIXME: this is unclean, as we have already assigned some TSNs etc, and
                  * maybe queued parts of this message in the queue, this should be cleaned
@@ -412,18 +542,19 @@ se_ulpsend (unsigned short streamId, unsigned char *buffer,
             if ((i != 1) && (i != numberOfSegments))
             {
                 dchunk->chunk_flags = 0;
-                bCount = SCTP_MAXIMUM_DATA_LENGTH;
+                bCount = maxDataLength;
                 event_log (VERBOSE, "NEXT FRAGMENTED CHUNK -> MIDDLE");
             }
             else if (i == 1)
             {
                 dchunk->chunk_flags = SCTP_DATA_BEGIN_SEGMENT;
                 event_log (VERBOSE, "NEXT FRAGMENTED CHUNK -> BEGIN");
-                bCount = SCTP_MAXIMUM_DATA_LENGTH;
+                bCount = maxDataLength;
             }
             else if (i == numberOfSegments)
             {
                 dchunk->chunk_flags = SCTP_DATA_END_SEGMENT;
+                if (sackImmediately) dchunk->chunk_flags |= SCTP_DATA_SACK_IMMEDIATELY;
                 event_log (EXTERNAL_EVENT, "NEXT FRAGMENTED CHUNK -> END");
                 bCount = residual;
             }
@@ -574,12 +705,17 @@ short se_ulpreceivefrom(unsigned char *buffer, unsigned int *byteCount,
                if (d_pdu->read_position >= d_pdu->total_length) {
 
                     se->queuedBytes -= d_pdu->total_length;
+                    mdi_releaseMemory(d_pdu->total_length);
 
                     se->RecvStreams[streamId].pduList =
                         g_list_remove (se->RecvStreams[streamId].pduList,
                                        g_list_nth_data (se->RecvStreams[streamId].pduList, 0));
                     event_log (VERBOSE, "Remove PDU element from the SE list, and free associated memory");
-                    for (i=0; i < d_pdu->number_of_chunks; i++) free(d_pdu->ddata[i]);
+                    for (i=0; i < d_pdu->number_of_chunks; i++) {
+                        /* delivered data can not be reneged anymore */
+                        rxc_data_delivered(d_pdu->ddata[i]->tsn);
+                        free(d_pdu->ddata[i]);
+                    }
                     free(d_pdu->ddata);
                     free(d_pdu);
                     rxc_start_sack_timer(oldQueueLen);
@@ -594,6 +730,85 @@ short se_ulpreceivefrom(unsigned char *buffer, unsigned int *byteCount,
 }
 
 
+/**
+ * This function is called from distribution layer to receive several messages at once.
+ * Streams are served round robin, one message at a time, when receiving from any stream.
+ */
+short se_ulpreceivev(SCTP_ReceiveDescriptor* msgs, unsigned int max, int streamId,
+                     unsigned int flags, unsigned int* count)
+{
+  delivery_pdu  *d_pdu = NULL;
+  delivery_data *d_data = NULL;
+  SCTP_ReceiveDescriptor* msg;
+  unsigned int sid, idle, passes, remaining;
+  short result;
+
+  StreamEngine* se = (StreamEngine *) mdi_readStreamEngine ();
+
+  *count = 0;
+  if (se == NULL)
+    {
+      error_log (ERROR_MAJOR, "Could not retrieve SE instance ");
+      return SCTP_MODULE_NOT_FOUND;
+    }
+  if (streamId == SCTP_ANY_STREAM)
+    {
+      sid = se->nextReceiveStream % se->numReceiveStreams;
+      passes = se->numReceiveStreams;
+    }
+  else if (streamId < 0 || (unsigned int)streamId >= se->numReceiveStreams)
+    {
+      error_log (ERROR_MINOR, "STREAM ID OVERFLOW");
+      return (STREAM_ID_OVERFLOW);
+    }
+  else
+    {
+      sid = (unsigned int)streamId;
+      passes = 1;
+    }
+
+  /* idle counts the streams visited since the last message was removed */
+  idle = 0;
+  while (*count < max && idle < passes)
+    {
+      if (se->RecvStreams[sid].pduList == NULL)
+        {
+          idle++;
+        }
+      else
+        {
+          d_pdu = (delivery_pdu*)g_list_nth_data (se->RecvStreams[sid].pduList, 0);
+          d_data = d_pdu->ddata[d_pdu->read_chunk];
+          remaining = d_pdu->total_length - d_pdu->read_position;
+
+          msg = &msgs[*count];
+          msg->streamID = (unsigned short)sid;
+          msg->protocolId = d_data->protocolId;
+          msg->flags = (d_data->chunk_flags & SCTP_DATA_UNORDERED) ? SCTP_MSG_UNORDERED : 0;
+
+          result = se_ulpreceivefrom (msg->buffer, &msg->length, (unsigned short)sid, &msg->streamSN,
+                                      &msg->tsn, &msg->addressIndex, flags);
+          if (result != RECEIVE_DATA)
+            {
+              if (*count > 0) break;
+              return result;
+            }
+          if (msg->length < remaining) msg->flags |= SCTP_MSG_TRUNCATED;
+          (*count)++;
+
+          /* a peeked message stays at the head of its stream */
+          if (flags == SCTP_MSG_PEEK) idle++;
+          else idle = 0;
+        }
+      if (streamId == SCTP_ANY_STREAM) sid = (sid + 1) % se->numReceiveStreams;
+    }
+  if (streamId == SCTP_ANY_STREAM) se->nextReceiveStream = sid;
+
+  event_logii (EXTERNAL_EVENT, "ulp receives %u of max. %u messages from se", *count, max);
+  return (*count > 0) ? RECEIVE_DATA : NO_DATA_AVAILABLE;
+}
+
+
 /*
  * function that gets chunks from the Lists, transforms them to PDUs, puts them
  * to the pduList, and calls DataArrive-Notification
@@ -613,7 +828,11 @@ int se_doNotifications(void)
     event_log (INTERNAL_EVENT_0, " ================> se_doNotifications <=============== ");
 
     retVal = SCTP_SUCCESS;
-    retVal = se_searchReadyPdu(se);
+    if (mdi_supportsIDATA() == TRUE) {
+        retVal = se_searchReadyIdataPdu(se);
+    } else {
+        retVal = se_searchReadyPdu(se);
+    }
 
     for (i = 0; i < se->numReceiveStreams; i++)
     {
@@ -635,16 +854,18 @@ int se_recvDataChunk (SCTP_data_chunk * dataChunk, unsigned int byteCount, unsig
 {
     guint16 datalength;
     SCTP_InvalidStreamIdError error_info;
+    SCTP_idata_chunk* idataChunk;
     delivery_data* d_chunk;
     StreamEngine* se = (StreamEngine *) mdi_readStreamEngine ();
     assert(se);
 
     event_log (INTERNAL_EVENT_0, "SE_RECVDATACHUNK CALLED");
 
-    d_chunk = (delivery_data*)malloc (sizeof (delivery_data));
+    datalength =  byteCount - DATA_CHUNK_HEADER_SIZE(dataChunk->chunk_id);
+
+    d_chunk = (delivery_data*)malloc (sizeof (delivery_data) + datalength);
     if (d_chunk == NULL) return SCTP_OUT_OF_RESOURCES;
 
-    datalength =  byteCount - FIXED_DATA_CHUNK_SIZE;
     d_chunk->stream_id =    ntohs (dataChunk->stream_id);
 
     if (d_chunk->stream_id >= se->numReceiveStreams) {
@@ -666,17 +887,35 @@ int se_recvDataChunk (SCTP_data_chunk * dataChunk, unsigned int byteCount, unsig
         return SCTP_UNSPECIFIED_ERROR;
     }
 
-    memcpy (d_chunk->data, dataChunk->data, datalength);
     d_chunk->data_length = datalength;
     d_chunk->chunk_flags = dataChunk->chunk_flags;
-    d_chunk->stream_sn =    ntohs (dataChunk->stream_sn);
-    d_chunk->protocolId =   dataChunk->protocolId;
+    if (dataChunk->chunk_id == CHUNK_IDATA) {
+        idataChunk = (SCTP_idata_chunk*)dataChunk;
+        memcpy (d_chunk->data, idataChunk->data, datalength);
+        d_chunk->message_id = ntohl (idataChunk->message_id);
+        /* the ULP sees the lower bits of the message id as stream sequence number */
+        d_chunk->stream_sn =  (guint16)d_chunk->message_id;
+        if (idataChunk->chunk_flags & SCTP_DATA_BEGIN_SEGMENT) {
+            d_chunk->fsn = 0;
+            d_chunk->protocolId = idataChunk->ppid_fsn;
+        } else {
+            d_chunk->fsn = ntohl (idataChunk->ppid_fsn);
+            d_chunk->protocolId = 0;
+        }
+    } else {
+        memcpy (d_chunk->data, dataChunk->data, datalength);
+        d_chunk->stream_sn =    ntohs (dataChunk->stream_sn);
+        d_chunk->protocolId =   dataChunk->protocolId;
+        d_chunk->message_id =   d_chunk->stream_sn;
+        d_chunk->fsn = 0;
+    }
     d_chunk->fromAddressIndex =  address_index;
 
 
 
     se->List = g_list_insert_sorted(se->List, d_chunk, (GCompareFunc) sort_tsn_se);
     se->queuedBytes += datalength;
+    mdi_chargeMemory(datalength);
 
     se->recvStreamActivated[d_chunk->stream_id] = TRUE;
     return SCTP_SUCCESS;
@@ -871,6 +1110,115 @@ int se_recvDataChunk (SCTP_data_chunk * dataChunk, unsigned int byteCount, unsig
 }
 
 
+/*
+ * the I-DATA counterpart of se_searchReadyPdu : the fragments of a message need not have
+ * consecutive TSNs, they are found by stream id, message id and fragment sequence number.
+ * Ordered messages are passed on in the order of their message ids.
+ */
+int se_searchReadyIdataPdu(StreamEngine* se)
+{
+    GList* tmp = g_list_first(se->List);
+    GList* item = NULL;
+    GList* next = NULL;
+    delivery_data* d_chunk;
+    delivery_pdu* d_pdu;
+    guint16 currentSID;
+    guint32 currentMID;
+    guint32 nextFSN;
+    guint8  unordered;
+    guint32 nrOfChunks, i;
+    gboolean complete;
+
+    event_log (INTERNAL_EVENT_0, " ================> se_searchReadyIdataPdu <=============== ");
+    event_logi (VVERBOSE, "List has %u elements", g_list_length(se->List));
+
+    while (tmp != NULL)
+    {
+        d_chunk = (delivery_data*)(tmp->data);
+        if (!(d_chunk->chunk_flags & SCTP_DATA_BEGIN_SEGMENT)) {
+            tmp = g_list_next(tmp);
+            continue;
+        }
+        currentSID = d_chunk->stream_id;
+        currentMID = d_chunk->message_id;
+        unordered  = d_chunk->chunk_flags & SCTP_DATA_UNORDERED;
+        event_logiii(VVERBOSE, "Found Begin Segment with TSN: %u, MID: %u, SID: %u", d_chunk->tsn, currentMID, currentSID);
+
+        if (!unordered && currentMID != se->RecvStreams[currentSID].nextMID) {
+            /* an earlier message of this stream is still missing */
+            tmp = g_list_next(tmp);
+            continue;
+        }
+
+        /* the other fragments follow the first one in TSN order */
+        nrOfChunks = 1;
+        nextFSN = 1;
+        complete = (d_chunk->chunk_flags & SCTP_DATA_END_SEGMENT) ? TRUE : FALSE;
+        for (item = g_list_next(tmp); item != NULL && !complete; item = g_list_next(item)) {
+            d_chunk = (delivery_data*)(item->data);
+            if (d_chunk->stream_id != currentSID || d_chunk->message_id != currentMID ||
+                (d_chunk->chunk_flags & SCTP_DATA_UNORDERED) != unordered) continue;
+            if (d_chunk->chunk_flags & SCTP_DATA_BEGIN_SEGMENT) {
+                error_logi(VERBOSE, "Multiple Begins found with MID: %u", currentMID);
+                scu_abort(ECC_PROTOCOL_VIOLATION, 0, NULL);
+                return SCTP_UNSPECIFIED_ERROR;
+            }
+            /* a fragment is still missing */
+            if (d_chunk->fsn != nextFSN) break;
+            nrOfChunks++;
+            nextFSN++;
+            if (d_chunk->chunk_flags & SCTP_DATA_END_SEGMENT) complete = TRUE;
+        }
+        if (!complete) {
+            event_logi (VVERBOSE, "Message with MID %u is incomplete", currentMID);
+            tmp = g_list_next(tmp);
+            continue;
+        }
+
+        event_log (VVERBOSE, "handling complete PDU");
+        d_pdu = (delivery_pdu*)malloc(sizeof(delivery_pdu));
+        if (d_pdu == NULL) {
+            return SCTP_OUT_OF_RESOURCES;
+        }
+        d_pdu->number_of_chunks = nrOfChunks;
+        d_pdu->read_position = 0;
+        d_pdu->read_chunk = 0;
+        d_pdu->chunk_position = 0;
+        d_pdu->total_length = 0;
+        d_pdu->ddata = (delivery_data**)malloc(nrOfChunks*sizeof(delivery_data*));
+        if (d_pdu->ddata == NULL) {
+            free(d_pdu);
+            return SCTP_OUT_OF_RESOURCES;
+        }
+
+        /* move the fragments into the PDU, and continue after the first chunk left in the list */
+        item = tmp;
+        tmp = NULL;
+        i = 0;
+        while (i < nrOfChunks) {
+            next = g_list_next(item);
+            d_chunk = (delivery_data*)(item->data);
+            if (d_chunk->stream_id == currentSID && d_chunk->message_id == currentMID &&
+                (d_chunk->chunk_flags & SCTP_DATA_UNORDERED) == unordered) {
+                d_pdu->ddata[i++] = d_chunk;
+                d_pdu->total_length += d_chunk->data_length;
+                se->List = g_list_delete_link(se->List, item);
+            } else if (tmp == NULL) {
+                tmp = item;
+            }
+            item = next;
+        }
+        if (tmp == NULL) tmp = item;
+
+        if (!unordered) se->RecvStreams[currentSID].nextMID++;
+        se->RecvStreams[currentSID].prePduList = g_list_append(se->RecvStreams[currentSID].prePduList, d_pdu);
+    }
+    event_log (INTERNAL_EVENT_0, " ================> se_searchReadyIdataPdu Finished <=============== ");
+
+    return SCTP_SUCCESS;
+}
+
+
 int se_deliverWaiting(StreamEngine* se, unsigned short sid)
 {
     GList* waitingListItem = g_list_first(se->RecvStreams[sid].prePduList);
@@ -880,6 +1228,8 @@ int se_deliverWaiting(StreamEngine* se, unsigned short sid)
     {
         d_pdu = (delivery_pdu*)waitingListItem->data;
         se->RecvStreams[sid].pduList = g_list_append(se->RecvStreams[sid].pduList, d_pdu);
+        trc_event(SCTP_TRACE_MODULE_STREAMENGINE, TRC_DATA_DELIVERED, mdi_readAssociationID(),
+                  sid, d_pdu->total_length);
         mdi_dataArriveNotif(sid, d_pdu->total_length, d_pdu->ddata[0]->stream_sn, d_pdu->ddata[0]->tsn,
                                 d_pdu->ddata[0]->protocolId, (d_pdu->ddata[0]->chunk_flags & SCTP_DATA_UNORDERED) ? 1 : 0);
         if(waitingListItem != NULL)
@@ -992,6 +1342,7 @@ int se_deliver_unreliably(unsigned int up_to_tsn, SCTP_forward_tsn_chunk* chk)
 
              se->List = g_list_remove (se->List, d_chunk);
              se->queuedBytes -= d_chunk->data_length;
+             mdi_releaseMemory(d_chunk->data_length);
              free(d_chunk);
              tmp = g_list_first(se->List);
         }
@@ -47,6 +47,7 @@
 
 #include  "globals.h"           /* boolean, etc */
 #include  "messages.h"
+#include  "sctp.h"
 
 
 
@@ -114,6 +115,12 @@ short se_ulpreceivefrom(unsigned char *buffer, unsigned int *byteCount,
                         unsigned short streamId, unsigned short* streamSN,
                         unsigned int * tsn, unsigned int* addressIndex, unsigned int flags);
 
+/* This function is called from ULP to receive up to max messages from one stream,
+   or from all streams (streamId == SCTP_ANY_STREAM). count returns the number of messages.
+*/
+short se_ulpreceivev(SCTP_ReceiveDescriptor* msgs, unsigned int max, int streamId,
+                     unsigned int flags, unsigned int* count);
+
 
 /*
  * This function is called from RX_Control to receive a chunk.
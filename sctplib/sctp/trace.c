@@ -0,0 +1,178 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *           //=====   //===== ===//=== //===//  //       //   //===//
+ *          //        //         //    //    // //       //   //    //
+ *         //====//  //         //    //===//  //       //   //===<<
+ *              //  //         //    //       //       //   //    //
+ *       ======//  //=====    //    //       //=====  //   //===//
+ *
+ * -------------- An SCTP implementation according to RFC 4960 --------------
+ *
+ * Copyright (C) 2000 by Siemens AG, Munich, Germany.
+ * Copyright (C) 2001-2004 Andreas Jungmaier
+ * Copyright (C) 2004-2026 Thomas Dreibholz
+ *
+ * Acknowledgements:
+ * Realized in co-operation between Siemens AG and the University of
+ * Duisburg-Essen, Institute for Experimental Mathematics, Computer
+ * Networking Technology group.
+ * This work was partially funded by the Bundesministerium fuer Bildung und
+ * Forschung (BMBF) of the Federal Republic of Germany
+ * (Förderkennzeichen 01AK045).
+ * The authors alone are responsible for the contents.
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact: sctp-discussion@sctp.de
+ *          thomas.dreibholz@gmail.com
+ *          tuexen@fh-muenster.de
+ *          andreas.jungmaier@web.de
+ */
+
+#include "globals.h"
+#include "adaptation.h"
+#include "sctp.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the modules that are currently traced, 0 means tracing is off */
+volatile unsigned int trc_activeModules = 0;
+
+/* the record ring, its size (a power of two) minus one, and the running record number */
+static SCTP_TraceRecord* trc_ring = NULL;
+static unsigned int trc_mask = 0;
+static volatile unsigned int trc_next = 0;
+
+
+/**
+ * reserves the next slot of the ring. Several threads may write trace records
+ * concurrently, so the counter is advanced atomically where the compiler allows.
+ * @return running number of the reserved record
+ */
+static unsigned int trc_reserveRecord(void)
+{
+#if defined(__GNUC__)
+    return __sync_fetch_and_add(&trc_next, 1);
+#else
+    return trc_next++;
+#endif
+}
+
+
+void trc_record(unsigned int module, unsigned int event,
+                unsigned int assoc, unsigned int tsn, unsigned int arg)
+{
+    SCTP_TraceRecord* rec;
+    struct timeval now;
+    unsigned int number;
+
+    if (trc_ring == NULL) return;
+
+    number = trc_reserveRecord();
+    rec = &trc_ring[number & trc_mask];
+    rec->sequence = 0;
+
+    adl_gettime(&now);
+    rec->seconds = (unsigned int)now.tv_sec;
+    rec->microseconds = (unsigned int)now.tv_usec;
+    rec->assocID = assoc;
+    rec->tsn = tsn;
+    rec->arg = arg;
+    rec->event = (unsigned short)event;
+    rec->module = (unsigned short)module;
+    rec->sequence = number + 1;
+}
+
+
+int sctp_enableTracing(unsigned int moduleMask, unsigned int numberOfRecords)
+{
+    SCTP_TraceRecord* newRing;
+    unsigned int size = 1;
+
+    if (numberOfRecords == 0) numberOfRecords = TRC_DEFAULT_RECORDS;
+    while (size < numberOfRecords && size < 0x80000000) size <<= 1;
+
+    if (trc_ring == NULL || size != trc_mask + 1) {
+        newRing = (SCTP_TraceRecord*)calloc(size, sizeof(SCTP_TraceRecord));
+        if (newRing == NULL) {
+            error_log(ERROR_MAJOR, "sctp_enableTracing: could not allocate trace ring");
+            return SCTP_OUT_OF_RESOURCES;
+        }
+        trc_activeModules = 0;
+        if (trc_ring != NULL) free(trc_ring);
+        trc_ring = newRing;
+        trc_mask = size - 1;
+        trc_next = 0;
+    }
+    trc_activeModules = moduleMask & SCTP_TRACE_MODULE_ALL;
+
+    event_logii(INTERNAL_EVENT_0, "sctp_enableTracing: tracing modules %x into %u records",
+                trc_activeModules, size);
+    return SCTP_SUCCESS;
+}
+
+
+int sctp_disableTracing(void)
+{
+    trc_activeModules = 0;
+    event_log(INTERNAL_EVENT_0, "sctp_disableTracing: tracing switched off");
+    return SCTP_SUCCESS;
+}
+
+
+int sctp_writeTraceFile(const char* fileName)
+{
+    SCTP_TraceFileHeader header;
+    SCTP_TraceRecord rec;
+    FILE* fd;
+    unsigned int last, first, number, written = 0;
+
+    if (trc_ring == NULL || fileName == NULL) return SCTP_PARAMETER_PROBLEM;
+
+    fd = fopen(fileName, "wb");
+    if (fd == NULL) {
+        error_logi(ERROR_MINOR, "sctp_writeTraceFile: could not open %s", fileName);
+        return SCTP_PARAMETER_PROBLEM;
+    }
+
+    last = trc_next;
+    first = (last > trc_mask) ? last - trc_mask - 1 : 0;
+
+    header.magic = TRC_FILE_MAGIC;
+    header.version = TRC_FILE_VERSION;
+    header.recordSize = sizeof(SCTP_TraceRecord);
+    header.numberOfRecords = 0;
+    header.lostRecords = first;
+    fwrite(&header, sizeof(header), 1, fd);
+
+    for (number = first; number != last; number++) {
+        rec = trc_ring[number & trc_mask];
+        /* skip records that are being written, or were overwritten meanwhile */
+        if (rec.sequence != number + 1) continue;
+        if (fwrite(&rec, sizeof(rec), 1, fd) != 1) break;
+        written++;
+    }
+
+    header.numberOfRecords = written;
+    rewind(fd);
+    fwrite(&header, sizeof(header), 1, fd);
+    if (fclose(fd) != 0) return SCTP_PARAMETER_PROBLEM;
+
+    event_logii(INTERNAL_EVENT_0, "sctp_writeTraceFile: wrote %u records to %s", written, fileName);
+    return SCTP_SUCCESS;
+}
@@ -0,0 +1,130 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *           //=====   //===== ===//=== //===//  //       //   //===//
+ *          //        //         //    //    // //       //   //    //
+ *         //====//  //         //    //===//  //       //   //===<<
+ *              //  //         //    //       //       //   //    //
+ *       ======//  //=====    //    //       //=====  //   //===//
+ *
+ * -------------- An SCTP implementation according to RFC 4960 --------------
+ *
+ * Copyright (C) 2000 by Siemens AG, Munich, Germany.
+ * Copyright (C) 2001-2004 Andreas Jungmaier
+ * Copyright (C) 2004-2026 Thomas Dreibholz
+ *
+ * Acknowledgements:
+ * Realized in co-operation between Siemens AG and the University of
+ * Duisburg-Essen, Institute for Experimental Mathematics, Computer
+ * Networking Technology group.
+ * This work was partially funded by the Bundesministerium fuer Bildung und
+ * Forschung (BMBF) of the Federal Republic of Germany
+ * (Förderkennzeichen 01AK045).
+ * The authors alone are responsible for the contents.
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact: sctp-discussion@sctp.de
+ *          thomas.dreibholz@gmail.com
+ *          tuexen@fh-muenster.de
+ *          andreas.jungmaier@web.de
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/*
+ * The binary trace ring records protocol events as fixed size records. Unlike
+ * event_log(), which is compiled out unless Current_event_log_ is raised, the
+ * ring is switched on at runtime per module with sctp_enableTracing(). When a
+ * module is not traced, a trace point costs a single test of trc_activeModules.
+ * The ring is dumped with sctp_writeTraceFile() and decoded offline by the
+ * trace_decoder program. This header is shared with the decoder, so it must
+ * not depend on glib or any other library internals.
+ */
+
+/* "SCTR" : the magic number at the start of every trace file */
+#define TRC_FILE_MAGIC          0x53435452
+#define TRC_FILE_VERSION        1
+
+/* record ring size used when sctp_enableTracing() is called with 0 records */
+#define TRC_DEFAULT_RECORDS     65536
+
+/* trace events. The meaning of tsn and arg for each event is given behind it */
+#define TRC_PACKET_RECEIVED     1       /* tsn: verification tag, arg: packet length */
+#define TRC_PACKET_SENT         2       /* tsn: path index, arg: packet length */
+#define TRC_DATA_SENT           3       /* tsn: TSN, arg: chunk length */
+#define TRC_DATA_RECEIVED       4       /* tsn: TSN, arg: chunk length */
+#define TRC_DATA_DUPLICATE      5       /* tsn: TSN, arg: 0 */
+#define TRC_SACK_SENT           6       /* tsn: cumulative TSN ack, arg: advertised rwnd */
+#define TRC_SACK_RECEIVED       7       /* tsn: cumulative TSN ack, arg: advertised rwnd */
+#define TRC_FAST_RETRANSMIT     8       /* tsn: lowest TSN retransmitted, arg: number of chunks */
+#define TRC_T3_TIMEOUT          9       /* tsn: path index, arg: number of chunks */
+#define TRC_ULP_SEND            10      /* tsn: stream id, arg: message length */
+#define TRC_DATA_DELIVERED      11      /* tsn: stream id, arg: message length */
+#define TRC_RTT_MEASURED        12      /* tsn: path index, arg: rtt in msecs */
+#define TRC_MAX_EVENT           12
+
+/**
+ * one fixed size trace record. All fields are stored in host byte order.
+ * sequence is written last and is 1 + the running record number, so a reader
+ * can tell empty (0) and overwritten records apart from valid ones.
+ */
+typedef struct SCTP_TRACE_RECORD
+{
+    unsigned int sequence;
+    unsigned int seconds;
+    unsigned int microseconds;
+    unsigned int assocID;
+    unsigned int tsn;
+    unsigned int arg;
+    unsigned short event;
+    unsigned short module;
+} SCTP_TraceRecord;
+
+/**
+ * header of a trace file, followed by numberOfRecords records of
+ * recordSize bytes each, oldest record first
+ */
+typedef struct SCTP_TRACE_FILE_HEADER
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned int recordSize;
+    unsigned int numberOfRecords;
+    unsigned int lostRecords;
+} SCTP_TraceFileHeader;
+
+
+/* bit mask of the modules (SCTP_TRACE_MODULE_xxx) that are currently traced */
+extern volatile unsigned int trc_activeModules;
+
+/**
+ * trace point macro. Costs one branch when the module is not traced.
+ * @param module   SCTP_TRACE_MODULE_xxx constant of the calling module
+ * @param event    TRC_xxx event code
+ * @param assoc    association id (0 if not known)
+ * @param tsn      first event-specific value (see event codes)
+ * @param arg      second event-specific value (see event codes)
+ */
+#define trc_event(module, event, assoc, tsn, arg) \
+    if (trc_activeModules & (module)) trc_record((module), (event), (assoc), (tsn), (arg))
+
+/**
+ * writes one record into the trace ring. Do not call directly, use trc_event().
+ */
+void trc_record(unsigned int module, unsigned int event,
+                unsigned int assoc, unsigned int tsn, unsigned int arg);
+
+#endif